@@ -14,6 +14,9 @@
 
 #import <QuartzCore/CAMetalLayer.h>
 
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
 #include <vector>
 
 @interface MarlinViewController ()
@@ -32,7 +35,8 @@ static CVReturn displayLinkCallback(CVDisplayLinkRef displayLink,
                                     CVOptionFlags* flagsOut,
                                     void* target) {
         
-    marlin::ScenePtr scene = marlin::Scene::create();
+    static marlin::ScenePtr scene = marlin::Scene::create();
+    static std::vector< marlin::GeometryPtr > geometries;
     static bool first = true;
     if ( first )
     {
@@ -62,9 +66,10 @@ static CVReturn displayLinkCallback(CVDisplayLinkRef displayLink,
             mesh.setIndices( indices );
             
             marlin::GeometryPtr geometry = marlin::Geometry::create( scene );
-            geometry->setLOD( mesh, 0 );
+            geometry->setLOD( std::move( mesh ), 0 );
             
             scene->addObject( geometry );
+            geometries.push_back( geometry );
         }
         
         {
@@ -92,14 +97,25 @@ static CVReturn displayLinkCallback(CVDisplayLinkRef displayLink,
             mesh.setIndices( indices );
             
             marlin::GeometryPtr geometry = marlin::Geometry::create( scene );
-            geometry->setLOD( mesh, 0 );
+            geometry->setLOD( std::move( mesh ), 0 );
             
             scene->addObject( geometry );
+            geometries.push_back( geometry );
         }
         
         first = false;
     }
     
+    // Spin everything about z, each matrix is a single write into the transform store
+    static auto startTime = std::chrono::high_resolution_clock::now();
+    const double time = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - startTime ).count();
+    const marlin::Mat4d rotation = glm::rotate( marlin::Mat4d( 1.0 ), time * glm::radians( 90.0 ), marlin::Vec3d( 0.0, 0.0, 1.0 ) );
+    
+    for ( const marlin::GeometryPtr &geometry : geometries )
+    {
+        geometry->setMatrix( rotation );
+    }
+    
     marlin::render( scene );
     
     return kCVReturnSuccess;
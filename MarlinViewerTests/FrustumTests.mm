@@ -0,0 +1,178 @@
+//
+//  FrustumTests.mm
+//  MarlinViewerTests
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <marlin/scene/frustum.hpp>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace marlin;
+
+// Box frustum, x and y in [ -1, 1 ] and looking down -z from 0 to -10
+static Frustum s_boxFrustum()
+{
+    Mat4f viewProjection( 1.0f );
+    viewProjection[ 2 ][ 2 ] = -0.1f;
+    return Frustum( viewProjection );
+}
+
+// Spheres as cullSpheres reads them, padded to a multiple of four
+struct Spheres
+{
+    std::vector< float > x, y, z, radius;
+
+    void add( float i_x, float i_y, float i_z, float i_radius )
+    {
+        x.push_back( i_x );
+        y.push_back( i_y );
+        z.push_back( i_z );
+        radius.push_back( i_radius );
+    }
+
+    // Padding lanes hold a visible sphere so writes past the count show up
+    void pad()
+    {
+        const size_t padded = ( x.size() + 3 ) & ~size_t( 3 );
+        x.resize( padded, 0.0f );
+        y.resize( padded, 0.0f );
+        z.resize( padded, -5.0f );
+        radius.resize( padded, 1.0f );
+    }
+};
+
+@interface FrustumTests : XCTestCase
+
+@end
+
+@implementation FrustumTests
+
+- (void)testCullSpheresPartialGroups {
+    const Frustum frustum = s_boxFrustum();
+
+    for ( size_t count = 1; count <= 9; count++ )
+    {
+        // Every other sphere is well outside the right plane
+        Spheres spheres;
+        uint32_t expected = 0;
+        for ( size_t i = 0; i < count; i++ )
+        {
+            const bool inside = ( i % 2 ) == 0;
+            spheres.add( inside ? 0.0f : 5.0f, 0.0f, -5.0f, 0.5f );
+            expected += inside ? 1 : 0;
+        }
+        spheres.pad();
+
+        std::vector< uint8_t > visible( count + 4, 0xAB );
+        const uint32_t visibleCount = frustum.cullSpheres( spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(), count, visible.data() );
+
+        XCTAssertEqual( visibleCount, expected );
+        for ( size_t i = 0; i < count; i++ )
+        {
+            XCTAssertEqual( visible[ i ], ( i % 2 ) == 0 ? 1 : 0 );
+        }
+
+        // Nothing written for the padding lanes
+        for ( size_t i = count; i < visible.size(); i++ )
+        {
+            XCTAssertEqual( visible[ i ], 0xAB );
+        }
+    }
+}
+
+- (void)testCullSpheresStraddlingPlanes {
+    const Frustum frustum = s_boxFrustum();
+
+    struct Case
+    {
+        float x, y, z, radius;
+        uint8_t visible;
+    };
+
+    const Case cases[] = {
+        // Center outside the right plane, sphere reaching back in
+        { 1.5f, 0.0f, -5.0f, 0.6f, 1 },
+        { 1.5f, 0.0f, -5.0f, 0.4f, 0 },
+        // Exactly touching counts as inside
+        { 1.5f, 0.0f, -5.0f, 0.5f, 1 },
+        { 0.0f, -1.25f, -5.0f, 0.3f, 1 },
+        { 0.0f, -1.25f, -5.0f, 0.2f, 0 },
+        // Behind the near plane and past the far plane
+        { 0.0f, 0.0f, 0.3f, 0.5f, 1 },
+        { 0.0f, 0.0f, 0.3f, 0.2f, 0 },
+        { 0.0f, 0.0f, -10.4f, 0.5f, 1 },
+        { 0.0f, 0.0f, -10.4f, 0.2f, 0 },
+        // Off a corner, each plane alone keeps it, so it is conservatively kept
+        { 1.4f, 1.4f, -5.0f, 0.5f, 1 },
+    };
+
+    const size_t caseCount = sizeof( cases ) / sizeof( cases[ 0 ] );
+
+    Spheres spheres;
+    uint32_t expected = 0;
+    for ( const Case &sphere : cases )
+    {
+        spheres.add( sphere.x, sphere.y, sphere.z, sphere.radius );
+        expected += sphere.visible;
+    }
+    spheres.pad();
+
+    std::vector< uint8_t > visible( caseCount );
+    const uint32_t visibleCount = frustum.cullSpheres( spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(), caseCount, visible.data() );
+
+    XCTAssertEqual( visibleCount, expected );
+    for ( size_t i = 0; i < caseCount; i++ )
+    {
+        XCTAssertEqual( visible[ i ], cases[ i ].visible, @"Case %zu", i );
+    }
+}
+
+- (void)testCullSpheresPerformance {
+    const Frustum frustum = s_boxFrustum();
+
+    // Roughly a fifth of the sampled volume lies inside the frustum
+    const size_t count = 100000;
+    std::mt19937 generator( 17 );
+    std::uniform_real_distribution< float > position( -2.0f, 2.0f );
+    std::uniform_real_distribution< float > depth( -12.0f, 2.0f );
+    std::uniform_real_distribution< float > radius( 0.0f, 0.2f );
+
+    Spheres spheres;
+    for ( size_t i = 0; i < count; i++ )
+    {
+        spheres.add( position( generator ), position( generator ), depth( generator ), radius( generator ) );
+    }
+    spheres.pad();
+
+    std::vector< uint8_t > visible( count );
+
+    // Blocks capture by copy, hand them the arrays instead of the vectors
+    const float* x = spheres.x.data();
+    const float* y = spheres.y.data();
+    const float* z = spheres.z.data();
+    const float* radii = spheres.radius.data();
+    uint8_t* visibleData = visible.data();
+
+    [self measureBlock:^{
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        CullStats stats;
+        stats.drawCount = static_cast< uint32_t >( count );
+        stats.visibleCount = frustum.cullSpheres( x, y, z, radii, count, visibleData );
+        stats.culledCount = stats.drawCount - stats.visibleCount;
+        stats.milliseconds = std::chrono::duration< double, std::milli >( std::chrono::high_resolution_clock::now() - start ).count();
+
+        NSLog( @"Culled %u of %u spheres, %u visible, %.3f ms per 100k", stats.culledCount, stats.drawCount, stats.visibleCount, stats.milliseconds * 100000.0 / count );
+        XCTAssertGreaterThan( stats.visibleCount, 0u );
+        XCTAssertGreaterThan( stats.culledCount, 0u );
+    }];
+}
+
+@end
@@ -0,0 +1,151 @@
+//
+//  MeshCompressionTests.mm
+//  MarlinViewerTests
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <marlin/scene/meshCompression.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace marlin;
+
+// Grid of quads with every stream filled, two triangles per quad
+static Mesh s_gridMesh( uint32_t i_size )
+{
+    std::vector< Vec3f > positions;
+    std::vector< Vec3f > normals;
+    std::vector< Vec3f > colors;
+    std::vector< Vec2f > uvs;
+    for ( uint32_t y = 0; y <= i_size; y++ )
+    {
+        for ( uint32_t x = 0; x <= i_size; x++ )
+        {
+            const Vec2f uv = Vec2f( x, y ) / float( i_size );
+            positions.push_back( Vec3f( uv, 0.1f * std::sin( 7.0f * uv.x ) ) );
+            normals.push_back( glm::normalize( Vec3f( uv.x - 0.5f, uv.y - 0.5f, 1.0f ) ) );
+            colors.push_back( Vec3f( uv, 1.0f - uv.x ) );
+            uvs.push_back( uv );
+        }
+    }
+
+    std::vector< uint32_t > indices;
+    const uint32_t row = i_size + 1;
+    for ( uint32_t y = 0; y < i_size; y++ )
+    {
+        for ( uint32_t x = 0; x < i_size; x++ )
+        {
+            const uint32_t corner = y * row + x;
+            indices.insert( indices.end(), { corner, corner + 1, corner + row + 1 } );
+            indices.insert( indices.end(), { corner, corner + row + 1, corner + row } );
+        }
+    }
+
+    Mesh mesh;
+    mesh.setVertices( std::move( positions ) );
+    mesh.setNormals( std::move( normals ) );
+    mesh.setColors( std::move( colors ) );
+    mesh.setUVs( std::move( uvs ) );
+    mesh.setIndices( std::move( indices ) );
+    return mesh;
+}
+
+template < class T >
+static bool s_equal( MeshSpanT< T > i_lhs, MeshSpanT< T > i_rhs )
+{
+    return i_lhs.size() == i_rhs.size() && std::equal( i_lhs.begin(), i_lhs.end(), i_rhs.begin() );
+}
+
+// Same triangles in the same order, each may start at another corner
+static bool s_sameTriangles( MeshSpanT< uint32_t > i_lhs, MeshSpanT< uint32_t > i_rhs )
+{
+    if ( i_lhs.size() != i_rhs.size() )
+    {
+        return false;
+    }
+
+    for ( size_t i = 0; i < i_lhs.size(); i += 3 )
+    {
+        bool found = false;
+        for ( size_t rotation = 0; rotation < 3 && !found; rotation++ )
+        {
+            found = i_lhs[ i ] == i_rhs[ i + rotation ] &&
+                    i_lhs[ i + 1 ] == i_rhs[ i + ( rotation + 1 ) % 3 ] &&
+                    i_lhs[ i + 2 ] == i_rhs[ i + ( rotation + 2 ) % 3 ];
+        }
+
+        if ( !found )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+@interface MeshCompressionTests : XCTestCase
+
+@end
+
+@implementation MeshCompressionTests
+
+- (void)testTriangleRoundTrip {
+    const Mesh mesh = s_gridMesh( 16 );
+
+    const CompressedMesh compressed = compressMesh( mesh );
+    XCTAssertFalse( compressed.empty() );
+    XCTAssertLessThan( compressed.getSize(), mesh.getOwnedSize() );
+
+    const Mesh decompressed = decompressMesh( compressed );
+    XCTAssertTrue( s_equal( decompressed.getVertices(), mesh.getVertices() ) );
+    XCTAssertTrue( s_equal( decompressed.getNormals(), mesh.getNormals() ) );
+    XCTAssertTrue( s_equal( decompressed.getColors(), mesh.getColors() ) );
+    XCTAssertTrue( s_equal( decompressed.getUVs(), mesh.getUVs() ) );
+    XCTAssertTrue( s_sameTriangles( decompressed.getIndices(), mesh.getIndices() ) );
+}
+
+- (void)testIndexSequenceRoundTrip {
+    // Not whole triangles, so the sequence codec is used and the order is exact
+    Mesh mesh = s_gridMesh( 4 );
+    std::vector< uint32_t > indices = { 0, 1, 2, 7, 24, 3, 3, 12 };
+    XCTAssertNotEqual( indices.size() % 3, 0u );
+    mesh.setIndices( indices );
+
+    const Mesh decompressed = decompressMesh( compressMesh( mesh ) );
+    XCTAssertTrue( s_equal( decompressed.getIndices(), MeshSpanT< uint32_t >( indices ) ) );
+    XCTAssertTrue( s_equal( decompressed.getVertices(), mesh.getVertices() ) );
+}
+
+- (void)testPartialStreamsDropped {
+    // Normals for only some vertices and no colors at all
+    Mesh mesh = s_gridMesh( 4 );
+    const MeshSpanT< Vec3f > normals = mesh.getNormals();
+    mesh.setNormals( std::vector< Vec3f >( normals.begin(), normals.begin() + normals.size() / 2 ) );
+    mesh.setColors( std::vector< Vec3f >() );
+
+    const CompressedMesh compressed = compressMesh( mesh );
+    const Mesh decompressed = decompressMesh( compressed );
+
+    XCTAssertTrue( decompressed.getNormals().empty() );
+    XCTAssertTrue( decompressed.getColors().empty() );
+    XCTAssertTrue( s_equal( decompressed.getVertices(), mesh.getVertices() ) );
+    XCTAssertTrue( s_equal( decompressed.getUVs(), mesh.getUVs() ) );
+    XCTAssertTrue( s_sameTriangles( decompressed.getIndices(), mesh.getIndices() ) );
+}
+
+- (void)testEmptyRoundTrip {
+    const CompressedMesh compressed = compressMesh( Mesh() );
+    XCTAssertTrue( compressed.empty() );
+
+    const Mesh decompressed = decompressMesh( compressed );
+    XCTAssertTrue( decompressed.getVertices().empty() );
+    XCTAssertTrue( decompressed.getIndices().empty() );
+}
+
+@end
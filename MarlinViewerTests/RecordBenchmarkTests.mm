@@ -0,0 +1,125 @@
+//
+//  RecordBenchmarkTests.mm
+//  MarlinViewerTests
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <marlin/marlin.hpp>
+#include <marlin/scene/renderStorage.hpp>
+
+#include <vector>
+
+using namespace marlin;
+
+// Small grid of two triangles per quad, a few of them fill a shrunken pool entry
+static Mesh s_gridMesh( uint32_t i_size, const Vec3f &i_offset )
+{
+    std::vector< Vec3f > positions;
+    std::vector< Vec3f > colors;
+    for ( uint32_t y = 0; y <= i_size; y++ )
+    {
+        for ( uint32_t x = 0; x <= i_size; x++ )
+        {
+            const Vec2f uv = Vec2f( x, y ) / float( i_size );
+            positions.push_back( i_offset + Vec3f( uv - 0.5f, 0.0f ) * 0.1f );
+            colors.push_back( Vec3f( uv, 1.0f ) );
+        }
+    }
+
+    std::vector< uint32_t > indices;
+    const uint32_t row = i_size + 1;
+    for ( uint32_t y = 0; y < i_size; y++ )
+    {
+        for ( uint32_t x = 0; x < i_size; x++ )
+        {
+            const uint32_t corner = y * row + x;
+            indices.insert( indices.end(), { corner, corner + 1, corner + row + 1 } );
+            indices.insert( indices.end(), { corner, corner + row + 1, corner + row } );
+        }
+    }
+
+    Mesh mesh;
+    mesh.setVertices( std::move( positions ) );
+    mesh.setColors( std::move( colors ) );
+    mesh.setIndices( std::move( indices ) );
+    return mesh;
+}
+
+@interface RecordBenchmarkTests : XCTestCase
+
+@end
+
+@implementation RecordBenchmarkTests
+
+// Headless, so it needs a Vulkan device but no window. Logs the average
+// time to record a frame for each chunk size, the default record chunk
+// size in instance.cpp is picked from these. Batches follow pool entries,
+// so the entries are shrunk to hold a handful of meshes each and the scene
+// gets enough batches to split into chunks.
+- (void)testRecordChunkSizes {
+    const uint32_t gridSize = 16;
+    const uint32_t meshesPerEntry = 8;
+    const uint32_t geometryCount = 4096;
+    const uint32_t warmupFrames = 8;
+    const uint32_t measuredFrames = 64;
+    const size_t chunkSizes[] = { 4, 8, 16, 32, 64, 128, 256, 1024 };
+
+    const size_t indexBytes = gridSize * gridSize * 6 * sizeof( uint32_t );
+    setPoolEntrySize( meshesPerEntry * indexBytes );
+    initOffscreen( 256, 256, 3 );
+
+    ScenePtr scene = Scene::create();
+    std::vector< GeometryPtr > geometries;
+    for ( uint32_t i = 0; i < geometryCount; i++ )
+    {
+        const Vec3f offset( ( i % 64 ) / 64.0f - 0.5f, ( i / 64 ) / 64.0f - 0.5f, 0.0f );
+
+        GeometryPtr geometry = Geometry::create( scene );
+        geometry->setLOD( s_gridMesh( gridSize, offset ), 0 );
+        scene->addObject( geometry );
+        geometries.push_back( geometry );
+    }
+
+    for ( size_t chunkSize : chunkSizes )
+    {
+        double milliseconds = 0.0;
+        RecordStats stats;
+
+        for ( uint32_t frame = 0; frame < warmupFrames + measuredFrames; frame++ )
+        {
+            // Setting the chunk size invalidates recorded frames, so every frame records
+            setRecordChunkSize( chunkSize );
+            render( scene );
+
+            stats = getRecordStats();
+            XCTAssertFalse( stats.reused );
+            if ( frame >= warmupFrames )
+            {
+                milliseconds += stats.milliseconds;
+            }
+        }
+
+        // Several meshes share every batch
+        XCTAssertGreaterThan( stats.batchCount, 0u );
+        XCTAssertLessThan( stats.batchCount, geometryCount / 2 );
+        XCTAssertEqual( stats.chunkCount, ( stats.batchCount + chunkSize - 1 ) / chunkSize );
+
+        NSLog( @"Chunk size %zu: %u batches in %u chunks, %.3f ms per recorded frame", chunkSize, stats.batchCount, stats.chunkCount, milliseconds / measuredFrames );
+    }
+
+    for ( const GeometryPtr &geometry : geometries )
+    {
+        scene->removeObject( geometry );
+    }
+    geometries.clear();
+    scene = nullptr;
+
+    deinit();
+    setPoolEntrySize( s_defaultPoolEntryBytes );
+}
+
+@end
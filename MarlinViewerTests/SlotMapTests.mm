@@ -0,0 +1,112 @@
+//
+//  SlotMapTests.mm
+//  MarlinViewerTests
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <marlin/scene/slotMap.hpp>
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+using namespace marlin;
+
+@interface SlotMapTests : XCTestCase
+
+@end
+
+@implementation SlotMapTests
+
+- (void)testStaleHandleAfterReinsert {
+    SlotMapT< std::string > slotMap;
+
+    const SlotHandle first = slotMap.insert( "first" );
+    XCTAssertNotEqual( first, s_invalidSlotHandle );
+    XCTAssertTrue( slotMap.erase( first ) );
+
+    // The freed slot is reused under a new generation
+    const SlotHandle second = slotMap.insert( "second" );
+    XCTAssertEqual( static_cast< uint32_t >( first ), static_cast< uint32_t >( second ) );
+    XCTAssertNotEqual( first, second );
+
+    XCTAssertFalse( slotMap.contains( first ) );
+    XCTAssertTrue( slotMap.find( first ) == nullptr );
+    XCTAssertFalse( slotMap.erase( first ) );
+
+    XCTAssertTrue( slotMap.contains( second ) );
+    XCTAssertTrue( *slotMap.find( second ) == "second" );
+    XCTAssertEqual( slotMap.size(), 1u );
+}
+
+- (void)testClearInvalidatesHandles {
+    SlotMapT< int > slotMap;
+
+    const SlotHandle a = slotMap.insert( 1 );
+    const SlotHandle b = slotMap.insert( 2 );
+    slotMap.clear();
+
+    XCTAssertTrue( slotMap.empty() );
+    XCTAssertFalse( slotMap.contains( a ) );
+    XCTAssertFalse( slotMap.contains( b ) );
+
+    const SlotHandle c = slotMap.insert( 3 );
+    XCTAssertNotEqual( c, a );
+    XCTAssertNotEqual( c, b );
+    XCTAssertFalse( slotMap.contains( s_invalidSlotHandle ) );
+}
+
+- (void)testGenerationWrapSkipsZero {
+    XCTAssertEqual( SlotMapT< int >::nextGeneration( 1 ), 2u );
+    XCTAssertEqual( SlotMapT< int >::nextGeneration( UINT32_MAX - 1 ), UINT32_MAX );
+    XCTAssertEqual( SlotMapT< int >::nextGeneration( UINT32_MAX ), 1u );
+
+    // Churning one slot never hands out the invalid handle or an old one
+    SlotMapT< int > slotMap;
+    std::set< SlotHandle > seen;
+    for ( int i = 0; i < 1000; i++ )
+    {
+        const SlotHandle handle = slotMap.insert( i );
+        XCTAssertNotEqual( handle, s_invalidSlotHandle );
+        XCTAssertTrue( seen.insert( handle ).second );
+        XCTAssertTrue( slotMap.erase( handle ) );
+    }
+}
+
+- (void)testIterationAfterSwapRemove {
+    SlotMapT< int > slotMap;
+
+    SlotHandle handles[ 5 ];
+    for ( int i = 0; i < 5; i++ )
+    {
+        handles[ i ] = slotMap.insert( i * 10 );
+    }
+
+    // Erasing from the middle moves the last value into the hole
+    XCTAssertTrue( slotMap.erase( handles[ 1 ] ) );
+    XCTAssertEqual( slotMap.size(), 4u );
+    XCTAssertEqual( slotMap.getValue( 1 ), 40 );
+    XCTAssertEqual( slotMap.getHandle( 1 ), handles[ 4 ] );
+
+    // Erasing the last value moves nothing
+    XCTAssertTrue( slotMap.erase( handles[ 3 ] ) );
+
+    std::multiset< int > values( slotMap.begin(), slotMap.end() );
+    XCTAssertTrue( values == std::multiset< int >( { 0, 20, 40 } ) );
+
+    // Dense order and handles still agree, and moved values keep their handle
+    for ( size_t i = 0; i < slotMap.size(); i++ )
+    {
+        XCTAssertEqual( slotMap.find( slotMap.getHandle( i ) ), &slotMap.getValue( i ) );
+    }
+
+    XCTAssertEqual( *slotMap.find( handles[ 4 ] ), 40 );
+    XCTAssertEqual( *slotMap.find( handles[ 2 ] ), 20 );
+    XCTAssertEqual( *slotMap.find( handles[ 0 ] ), 0 );
+}
+
+@end
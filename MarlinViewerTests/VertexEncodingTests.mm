@@ -0,0 +1,220 @@
+//
+//  VertexEncodingTests.mm
+//  MarlinViewerTests
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <marlin/scene/vertexEncoding.hpp>
+
+#include <meshoptimizer/src/meshoptimizer.h>
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Weverything"
+#include <glm/gtc/packing.hpp>
+#pragma clang diagnostic pop
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+using namespace marlin;
+
+// What a R8G8B8A8_SNORM attribute reads as
+static Vec4f s_readSnorm8( const int8_t* i_data )
+{
+    Vec4f result;
+    for ( int i = 0; i < 4; i++ )
+    {
+        result[ i ] = std::max( i_data[ i ] / 127.0f, -1.0f );
+    }
+    return result;
+}
+
+// Line for line port of decodeOctahedral in shader.vert
+static Vec3f s_decodeOctahedral( const Vec4f &i_encoded )
+{
+    const Vec2f xy = Vec2f( i_encoded ) / i_encoded.z;
+    Vec3f normal = Vec3f( xy, 1.0f - std::abs( xy.x ) - std::abs( xy.y ) );
+
+    const float fold = std::max( -normal.z, 0.0f );
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+
+    return glm::normalize( normal );
+}
+
+// Encodes one attribute of every vertex into packed vertices
+static std::vector< PackedVertex > s_encode( const std::vector< Vertex > &i_vertices, VertexAttribute i_attribute, const Vec4f &i_dequantization )
+{
+    std::vector< PackedVertex > packed( i_vertices.size() );
+
+    void* data = nullptr;
+    switch ( i_attribute )
+    {
+        case VertexAttributePosition: data = packed[ 0 ].pos; break;
+        case VertexAttributeColor: data = packed[ 0 ].color; break;
+        case VertexAttributeNormal: data = packed[ 0 ].normal; break;
+        default: data = packed[ 0 ].uv; break;
+    }
+
+    encodeAttribute( getVertexSource( i_vertices ), i_attribute, VertexEncoding::Quantized, i_dequantization, data, sizeof( PackedVertex ) );
+    return packed;
+}
+
+// Unit vectors spread over the whole sphere, plus the axes and the folded seams
+static std::vector< Vec3f > s_sphereDirections()
+{
+    std::vector< Vec3f > directions = {
+        Vec3f( 1.0f, 0.0f, 0.0f ), Vec3f( -1.0f, 0.0f, 0.0f ),
+        Vec3f( 0.0f, 1.0f, 0.0f ), Vec3f( 0.0f, -1.0f, 0.0f ),
+        Vec3f( 0.0f, 0.0f, 1.0f ), Vec3f( 0.0f, 0.0f, -1.0f ),
+        glm::normalize( Vec3f( 1.0f, 1.0f, 0.0f ) ), glm::normalize( Vec3f( -1.0f, 1.0f, -1.0f ) ),
+    };
+
+    const size_t count = 2000;
+    const float goldenAngle = 2.39996323f;
+    for ( size_t i = 0; i < count; i++ )
+    {
+        const float z = 1.0f - 2.0f * ( i + 0.5f ) / count;
+        const float r = std::sqrt( 1.0f - z * z );
+        directions.push_back( Vec3f( r * std::cos( goldenAngle * i ), r * std::sin( goldenAngle * i ), z ) );
+    }
+
+    return directions;
+}
+
+@interface VertexEncodingTests : XCTestCase
+
+@end
+
+@implementation VertexEncodingTests
+
+- (void)testPositionRoundTrip {
+    const Vec3f boundsMin( -3.0f, 0.5f, 10.0f );
+    const Vec3f boundsMax( 5.0f, 2.0f, 11.0f );
+    const Vec4f dequantization = computeDequantization( boundsMin, boundsMax );
+
+    // The longest axis sets the uniform scale
+    XCTAssertEqual( dequantization, Vec4f( boundsMin, 8.0f ) );
+
+    std::vector< Vertex > vertices;
+    for ( int i = 0; i <= 100; i++ )
+    {
+        const float t = i / 100.0f;
+        Vertex vertex {};
+        vertex.pos = glm::mix( boundsMin, boundsMax, Vec3f( t, t * t, 1.0f - t ) );
+        vertices.push_back( vertex );
+    }
+
+    // Half a step of the 16 bit grid over the scale, plus float rounding
+    const float tolerance = dequantization.w * ( 0.5f / 65535.0f ) + 1e-5f;
+
+    const std::vector< PackedVertex > packed = s_encode( vertices, VertexAttributePosition, dequantization );
+    for ( size_t i = 0; i < vertices.size(); i++ )
+    {
+        // Unorm reads, then the transform's offset and scale
+        const Vec3f unorm = Vec3f( packed[ i ].pos[ 0 ], packed[ i ].pos[ 1 ], packed[ i ].pos[ 2 ] ) / 65535.0f;
+        const Vec3f decoded = Vec3f( dequantization ) + unorm * dequantization.w;
+
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            XCTAssertEqualWithAccuracy( decoded[ axis ], vertices[ i ].pos[ axis ], tolerance );
+        }
+    }
+}
+
+- (void)testDegenerateBoundsRoundTrip {
+    // Every vertex in one place has no extent to scale by
+    const Vec3f point( 2.0f, -1.0f, 4.0f );
+    const Vec4f dequantization = computeDequantization( point, point );
+    XCTAssertEqual( dequantization, Vec4f( point, 1.0f ) );
+
+    std::vector< Vertex > vertices( 3 );
+    for ( Vertex &vertex : vertices )
+    {
+        vertex.pos = point;
+    }
+
+    const std::vector< PackedVertex > packed = s_encode( vertices, VertexAttributePosition, dequantization );
+    for ( const PackedVertex &vertex : packed )
+    {
+        XCTAssertEqual( vertex.pos[ 0 ], 0 );
+        XCTAssertEqual( vertex.pos[ 1 ], 0 );
+        XCTAssertEqual( vertex.pos[ 2 ], 0 );
+    }
+
+    // Inverted bounds, as an empty mesh would give, are degenerate too
+    const Vec4f empty = computeDequantization( Vec3f( FLT_MAX ), Vec3f( -FLT_MAX ) );
+    XCTAssertEqual( empty.w, 1.0f );
+}
+
+- (void)testOctahedralNormalRoundTrip {
+    const std::vector< Vec3f > directions = s_sphereDirections();
+
+    std::vector< Vertex > vertices( directions.size() );
+    for ( size_t i = 0; i < directions.size(); i++ )
+    {
+        vertices[ i ].normal = directions[ i ];
+    }
+
+    const std::vector< PackedVertex > packed = s_encode( vertices, VertexAttributeNormal, s_identityDequantization );
+
+    // The reference decoder works in place on tightly packed normals
+    std::vector< int8_t > reference( packed.size() * 4 );
+    for ( size_t i = 0; i < packed.size(); i++ )
+    {
+        std::copy( packed[ i ].normal, packed[ i ].normal + 4, &reference[ i * 4 ] );
+    }
+    meshopt_decodeFilterOct( reference.data(), packed.size(), 4 );
+
+    float maxAngle = 0.0f;
+    float maxMismatch = 0.0f;
+    for ( size_t i = 0; i < directions.size(); i++ )
+    {
+        const Vec3f decoded = s_decodeOctahedral( s_readSnorm8( packed[ i ].normal ) );
+        const float angle = std::acos( std::min( glm::dot( decoded, directions[ i ] ), 1.0f ) );
+        maxAngle = std::max( maxAngle, angle );
+
+        // The shader has to agree with meshoptimizer's own decoder
+        const Vec3f expected = glm::normalize( Vec3f( reference[ i * 4 ], reference[ i * 4 + 1 ], reference[ i * 4 + 2 ] ) );
+        maxMismatch = std::max( maxMismatch, glm::length( decoded - expected ) );
+    }
+
+    // 8 bit octahedral stays within about a degree, the reference rounds its
+    // output back to 8 bits so it only agrees to about one step
+    XCTAssertLessThan( maxAngle, 0.02f );
+    XCTAssertLessThan( maxMismatch, 0.01f );
+}
+
+- (void)testHalfUVRoundTrip {
+    std::vector< Vertex > vertices;
+    const float values[] = { 0.0f, 1.0f, 0.5f, 0.333f, -0.25f, 4.75f, 1024.3f, 1e-3f };
+    for ( float u : values )
+    {
+        for ( float v : values )
+        {
+            Vertex vertex {};
+            vertex.uv = Vec2f( u, v );
+            vertices.push_back( vertex );
+        }
+    }
+
+    const std::vector< PackedVertex > packed = s_encode( vertices, VertexAttributeUV, s_identityDequantization );
+    for ( size_t i = 0; i < vertices.size(); i++ )
+    {
+        for ( int axis = 0; axis < 2; axis++ )
+        {
+            // Half precision keeps 11 significant bits
+            const float original = vertices[ i ].uv[ axis ];
+            const float decoded = glm::unpackHalf1x16( packed[ i ].uv[ axis ] );
+            XCTAssertEqualWithAccuracy( decoded, original, std::abs( original ) / 2048.0f + 1e-7f );
+        }
+    }
+}
+
+@end
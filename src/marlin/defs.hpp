@@ -31,6 +31,11 @@ using Vec2u = glm::uvec2;
 using Vec3u = glm::uvec3;
 using Vec4u = glm::uvec4;
 
+// Four wide vectors, lowered to SSE or NEON depending on the target.
+// Comparisons give an Int4 with all bits set where true.
+typedef float Float4 __attribute__(( vector_size( 16 ) ));
+typedef int32_t Int4 __attribute__(( vector_size( 16 ) ));
+
 template< class T >
 using Vec2T = glm::tvec2< T, glm::precision::defaultp >;
 
@@ -8,6 +8,7 @@
 
 #include "marlin.hpp"
 
+#include <marlin/scene/renderStorage.hpp>
 #include <marlin/scene/scene.hpp>
 #include <marlin/vulkan/instance.hpp>
 
@@ -19,16 +20,66 @@
 namespace marlin
 {
 
+void setVertexEncoding( VertexEncoding i_encoding )
+{
+    marlin::MlnInstance::getInstance().setVertexEncoding( i_encoding );
+}
+
+void setPoolEntrySize( size_t i_bytes )
+{
+    marlin::MlnInstance::getInstance().setPoolEntrySize( i_bytes );
+}
+
 void init( void* i_layer )
 {
     marlin::MlnInstance::getInstance().init( i_layer );
 }
 
+void initOffscreen( uint32_t i_width, uint32_t i_height, uint32_t i_ringDepth )
+{
+    marlin::MlnInstance::getInstance().initOffscreen( i_width, i_height, i_ringDepth );
+}
+
+bool readFrame( FrameReadback &o_frame )
+{
+    return marlin::MlnInstance::getInstance().readFrame( o_frame );
+}
+
 void render( ScenePtr i_scene )
 {
     marlin::MlnInstance::getInstance().drawFrame( i_scene );
 }
 
+CullStats getCullStats()
+{
+    return marlin::MlnInstance::getInstance().getRenderStorage().getCullStats();
+}
+
+void setRecordChunkSize( size_t i_chunkSize )
+{
+    marlin::MlnInstance::getInstance().setRecordChunkSize( i_chunkSize );
+}
+
+RecordStats getRecordStats()
+{
+    return marlin::MlnInstance::getInstance().getRecordStats();
+}
+
+std::vector< MemoryHeapStats > getMemoryHeapStats()
+{
+    return marlin::MlnInstance::getInstance().getMemoryHeapStats();
+}
+
+void setMeshletClustering( bool i_enabled )
+{
+    marlin::MlnInstance::getInstance().getRenderStorage().setMeshletClustering( i_enabled );
+}
+
+void setInterleavedVertices( bool i_enabled )
+{
+    marlin::MlnInstance::getInstance().getRenderStorage().setInterleavedVertices( i_enabled );
+}
+
 void deinit()
 {
     marlin::MlnInstance::getInstance().deinit();
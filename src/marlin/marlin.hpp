@@ -11,16 +11,55 @@
 
 #include <marlin/defs.hpp>
 #include <marlin/scene/scene.hpp>
+#include <marlin/stats.hpp>
+
+#include <vector>
 
 namespace marlin
 {
 
 class Scene;
 
+// How vertices are stored on the device, call before init. Quantized
+// vertices take less than half the memory and fetch bandwidth.
+void setVertexEncoding( VertexEncoding i_encoding );
+
+// Bytes in each shared vertex and index buffer, call before init. Meshes in
+// the same buffers are drawn together, larger ones fall back to a buffer of
+// their own.
+void setPoolEntrySize( size_t i_bytes );
+
 void init( void* i_layer );
 
+// Render without a surface into a ring of offscreen images, finished frames
+// are collected with readFrame
+void initOffscreen( uint32_t i_width, uint32_t i_height, uint32_t i_ringDepth );
+
+bool readFrame( FrameReadback &o_frame );
+
 void render( ScenePtr i_scene );
 
+// Visible and culled draw counts of the last rendered frame and the time
+// the culling pass took. Empty when culling runs on the device.
+CullStats getCullStats();
+
+// Indirect batches recorded per secondary command buffer, and how long
+// recording the last frame took
+void setRecordChunkSize( size_t i_chunkSize );
+RecordStats getRecordStats();
+
+// Budget and usage of every device memory heap, with how much of it the
+// renderer's memory blocks hold and hand out
+std::vector< MemoryHeapStats > getMemoryHeapStats();
+
+// Split geometry uploaded from now on into meshlets that are frustum culled
+// on their own, and with device culling back facing ones are dropped too
+void setMeshletClustering( bool i_enabled );
+
+// Upload each vertex's attributes together, or every attribute as a stream of
+// its own. Applies to geometry uploaded from now on.
+void setInterleavedVertices( bool i_enabled );
+
 void deinit();
 
 } // namespace marlin
@@ -0,0 +1,78 @@
+//
+//  frustum.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/frustum.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace marlin
+{
+
+Frustum::Frustum( const Mat4f &i_viewProjection )
+{
+    // Rows of the matrix, glm stores columns
+    Vec4f rows[ 4 ];
+    for ( int i = 0; i < 4; i++ )
+    {
+        rows[ i ] = Vec4f( i_viewProjection[ 0 ][ i ], i_viewProjection[ 1 ][ i ], i_viewProjection[ 2 ][ i ], i_viewProjection[ 3 ][ i ] );
+    }
+
+    m_planes = {
+        rows[ 3 ] + rows[ 0 ],
+        rows[ 3 ] - rows[ 0 ],
+        rows[ 3 ] + rows[ 1 ],
+        rows[ 3 ] - rows[ 1 ],
+        rows[ 2 ],
+        rows[ 3 ] - rows[ 2 ],
+    };
+
+    // Unit normals so distances compare against radii
+    for ( Vec4f &plane : m_planes )
+    {
+        plane /= glm::length( Vec3f( plane ) );
+    }
+}
+
+const std::array< Vec4f, 6 > & Frustum::getPlanes() const
+{
+    return m_planes;
+}
+
+uint32_t Frustum::cullSpheres( const float* i_x, const float* i_y, const float* i_z, const float* i_radius, size_t i_count, uint8_t* o_visible ) const
+{
+    uint32_t visibleCount = 0;
+
+    for ( size_t i = 0; i < i_count; i += 4 )
+    {
+        Float4 x, y, z, radius;
+        std::memcpy( &x, i_x + i, sizeof( x ) );
+        std::memcpy( &y, i_y + i, sizeof( y ) );
+        std::memcpy( &z, i_z + i, sizeof( z ) );
+        std::memcpy( &radius, i_radius + i, sizeof( radius ) );
+
+        // Outside as soon as the center is further than the radius behind any plane
+        Int4 inside = { -1, -1, -1, -1 };
+        for ( const Vec4f &plane : m_planes )
+        {
+            const Float4 distance = x * plane.x + y * plane.y + z * plane.z + plane.w;
+            inside &= ( distance >= -radius );
+        }
+
+        const size_t lanes = std::min< size_t >( 4, i_count - i );
+        for ( size_t lane = 0; lane < lanes; lane++ )
+        {
+            o_visible[ i + lane ] = inside[ lane ] ? 1 : 0;
+            visibleCount += o_visible[ i + lane ];
+        }
+    }
+
+    return visibleCount;
+}
+
+} // namespace marlin
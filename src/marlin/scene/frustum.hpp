@@ -0,0 +1,44 @@
+//
+//  frustum.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_FRUSTUM_HPP
+#define MARLIN_FRUSTUM_HPP
+
+#include <marlin/stats.hpp>
+#include <marlin/vulkan/../defs.hpp>
+
+#include <array>
+#include <cstddef>
+
+namespace marlin
+{
+
+// Six inward facing planes taken from a view projection matrix with a zero
+// to one depth range. A point p is inside a plane when dot( n, p ) + d >= 0.
+class Frustum
+{
+public:
+
+    Frustum() = default;
+    explicit Frustum( const Mat4f &i_viewProjection );
+
+    const std::array< Vec4f, 6 > & getPlanes() const;
+
+    // Spheres as structure of arrays, tested four at a time. Arrays must be
+    // readable up to count rounded up to a multiple of four. Writes one or
+    // zero per sphere and returns how many are at least partly inside.
+    uint32_t cullSpheres( const float* i_x, const float* i_y, const float* i_z, const float* i_radius, size_t i_count, uint8_t* o_visible ) const;
+
+private:
+
+    std::array< Vec4f, 6 > m_planes;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_FRUSTUM_HPP */
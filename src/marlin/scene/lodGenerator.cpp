@@ -0,0 +1,86 @@
+//
+//  lodGenerator.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/lodGenerator.hpp>
+
+#include <meshoptimizer/src/meshoptimizer.h>
+
+namespace marlin
+{
+
+// Attribute streams that are empty are left empty
+template < class T >
+static std::vector< T > s_remapStream( MeshSpanT< T > i_stream, const std::vector< uint32_t > &i_remap, size_t i_vertexCount )
+{
+    if ( i_stream.empty() )
+    {
+        return std::vector< T >();
+    }
+    
+    std::vector< T > remapped( i_vertexCount );
+    meshopt_remapVertexBuffer( remapped.data(), i_stream.data, i_stream.size(), sizeof( T ), i_remap.data() );
+    return remapped;
+}
+
+std::vector< GeneratedLOD > generateLODChain( const Mesh &i_source, const LODChainSettings &i_settings )
+{
+    std::vector< GeneratedLOD > lods;
+    
+    const MeshSpanT< Vec3f > positions = i_source.getVertices();
+    const MeshSpanT< uint32_t > sourceIndices = i_source.getIndices();
+    if ( positions.empty() || sourceIndices.size() < 3 )
+    {
+        return lods;
+    }
+    
+    // Relative errors are scaled by this to get object space ones
+    const float scale = meshopt_simplifyScale( &positions[ 0 ].x, positions.size(), sizeof( Vec3f ) );
+    
+    std::vector< uint32_t > indices( sourceIndices.size() );
+    std::vector< uint32_t > remap( positions.size() );
+    size_t previousCount = sourceIndices.size();
+    
+    for ( uint32_t level = 0; level < i_settings.levelCount; level++ )
+    {
+        const size_t targetCount = static_cast< size_t >( previousCount * i_settings.ratio ) / 3 * 3;
+        if ( targetCount < 3 )
+        {
+            break;
+        }
+        
+        float relativeError = 0.0f;
+        const size_t indexCount = meshopt_simplify( indices.data(), sourceIndices.data, sourceIndices.size(), &positions[ 0 ].x, positions.size(), sizeof( Vec3f ), targetCount, i_settings.targetError, 0, &relativeError );
+        
+        // The error bound was reached before the target, coarser levels would look the same
+        if ( indexCount == 0 || indexCount >= previousCount )
+        {
+            break;
+        }
+        
+        // Drop the vertices no triangle refers to any more
+        const size_t vertexCount = meshopt_optimizeVertexFetchRemap( remap.data(), indices.data(), indexCount, positions.size() );
+        
+        std::vector< uint32_t > lodIndices( indexCount );
+        meshopt_remapIndexBuffer( lodIndices.data(), indices.data(), indexCount, remap.data() );
+        
+        GeneratedLOD lod;
+        lod.mesh.setVertices( s_remapStream( positions, remap, vertexCount ) );
+        lod.mesh.setNormals( s_remapStream( i_source.getNormals(), remap, vertexCount ) );
+        lod.mesh.setColors( s_remapStream( i_source.getColors(), remap, vertexCount ) );
+        lod.mesh.setUVs( s_remapStream( i_source.getUVs(), remap, vertexCount ) );
+        lod.mesh.setIndices( std::move( lodIndices ) );
+        lod.error = relativeError * scale;
+        
+        lods.push_back( std::move( lod ) );
+        previousCount = indexCount;
+    }
+    
+    return lods;
+}
+
+} // namespace marlin
@@ -0,0 +1,46 @@
+//
+//  lodGenerator.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_LODGENERATOR_HPP
+#define MARLIN_LODGENERATOR_HPP
+
+#include <marlin/scene/mesh.hpp>
+
+#include <vector>
+
+namespace marlin
+{
+
+struct LODChainSettings
+{
+    // Levels generated after the source, fewer are made once simplification stalls
+    uint32_t levelCount = 4;
+    
+    // Each level aims for this fraction of the previous level's triangles
+    float ratio = 0.5f;
+    
+    // Largest error a level may introduce, relative to the mesh extent
+    float targetError = 0.05f;
+};
+
+struct GeneratedLOD
+{
+    Mesh mesh;
+    
+    // Object space distance from the source surface
+    float error;
+};
+
+// Simplifies the source into successively coarser meshes. Every level is
+// simplified from the source so its error is measured against full detail,
+// and keeps only the vertices its triangles use. Safe to run on any thread.
+std::vector< GeneratedLOD > generateLODChain( const Mesh &i_source, const LODChainSettings &i_settings );
+
+} // namespace marlin
+
+#endif /* MARLIN_LODGENERATOR_HPP */
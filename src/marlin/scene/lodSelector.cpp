@@ -0,0 +1,76 @@
+//
+//  lodSelector.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/lodSelector.hpp>
+
+#include <marlin/scene/renderStorage.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace marlin
+{
+
+// Error allowed on screen before a finer LOD is needed
+static const float s_lodPixelError = 1.0f;
+
+// Fraction of the threshold an error must clear before the LOD changes
+static const float s_lodHysteresis = 0.15f;
+
+// Keeps the camera inside a sphere from dividing by zero
+static const float s_minLODDistance = 1e-3f;
+
+LODSelector::LODSelector( const Mat4f &i_view, const Mat4f &i_projection, uint32_t i_viewportHeight, float i_bias )
+{
+    m_cameraPosition = Vec3f( glm::inverse( i_view )[ 3 ] );
+
+    // The flipped y scale still measures the vertical field of view
+    m_pixelScale = std::abs( i_projection[ 1 ][ 1 ] ) * static_cast< float >( i_viewportHeight ) * 0.5f;
+    m_threshold = s_lodPixelError * std::max( i_bias, 0.0f );
+}
+
+uint8_t LODSelector::select( const MeshLODs &i_lods, const Mat4f &i_world, uint8_t i_current ) const
+{
+    uint8_t finest = s_invalidLOD;
+    uint8_t selected = s_invalidLOD;
+
+    // Errors grow with the LOD index, the last one under its threshold is the coarsest
+    for ( uint8_t lodIndex = 0; lodIndex < s_maxLODs; lodIndex++ )
+    {
+        const MeshStorage &meshLOD = i_lods.meshLODs[ lodIndex ];
+        if ( meshLOD.drawSlots.empty() )
+        {
+            continue;
+        }
+
+        if ( finest == s_invalidLOD )
+        {
+            finest = lodIndex;
+        }
+
+        const float margin = lodIndex > i_current || i_current == s_invalidLOD ? 1.0f - s_lodHysteresis : 1.0f + s_lodHysteresis;
+        if ( getPixelError( meshLOD.error, i_world, meshLOD.boundingSphere ) <= m_threshold * margin )
+        {
+            selected = lodIndex;
+        }
+    }
+
+    // Nothing is coarse enough to hide its error, draw the most detail we have
+    return selected != s_invalidLOD ? selected : finest;
+}
+
+float LODSelector::getPixelError( float i_error, const Mat4f &i_world, const Vec4f &i_sphere ) const
+{
+    const Vec3f center = Vec3f( i_world * Vec4f( Vec3f( i_sphere ), 1.0f ) );
+    const float scale = std::max( { glm::length( Vec3f( i_world[ 0 ] ) ), glm::length( Vec3f( i_world[ 1 ] ) ), glm::length( Vec3f( i_world[ 2 ] ) ) } );
+
+    const float distance = std::max( glm::length( center - m_cameraPosition ) - i_sphere.w * scale, s_minLODDistance );
+    return i_error * scale * m_pixelScale / distance;
+}
+
+} // namespace marlin
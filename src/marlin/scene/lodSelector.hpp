@@ -0,0 +1,52 @@
+//
+//  lodSelector.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_LODSELECTOR_HPP
+#define MARLIN_LODSELECTOR_HPP
+
+#include <marlin/vulkan/../defs.hpp>
+
+namespace marlin
+{
+
+struct MeshLODs;
+
+static const uint8_t s_invalidLOD = UINT8_MAX;
+
+// Negative errors passed with a LOD are estimated from its bounds and triangle count
+static const float s_estimateLODError = -1.0f;
+
+// Picks one LOD per object from the on screen size of each LOD's object
+// space error, measured at the near side of the object's bounding sphere.
+// The coarsest LOD under the threshold wins. Coarsening needs a margin below
+// it and refining a margin above it, so objects near a boundary do not pop.
+class LODSelector
+{
+public:
+
+    // Bias scales the threshold, above one favours coarser LODs
+    LODSelector( const Mat4f &i_view, const Mat4f &i_projection, uint32_t i_viewportHeight, float i_bias );
+
+    // s_invalidLOD when no LOD has anything to draw
+    uint8_t select( const MeshLODs &i_lods, const Mat4f &i_world, uint8_t i_current ) const;
+
+    // Pixels covered by an object space error on an object with this world matrix and sphere
+    float getPixelError( float i_error, const Mat4f &i_world, const Vec4f &i_sphere ) const;
+
+private:
+
+    Vec3f m_cameraPosition;
+
+    // Pixels per world unit at a distance of one
+    float m_pixelScale;
+    float m_threshold;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_LODSELECTOR_HPP */
@@ -11,58 +11,169 @@
 namespace marlin
 {
 
+template < class T >
+static void s_copy( MeshStreamT< T > &o_stream, const std::vector< T > &i_data )
+{
+    o_stream.owned = i_data;
+    o_stream.view = MeshSpanT< T >();
+    o_stream.external = false;
+}
+
+template < class T >
+static void s_move( MeshStreamT< T > &o_stream, std::vector< T > &&i_data )
+{
+    o_stream.owned = std::move( i_data );
+    o_stream.view = MeshSpanT< T >();
+    o_stream.external = false;
+}
+
+template < class T >
+static void s_view( MeshStreamT< T > &o_stream, const T* i_data, size_t i_count )
+{
+    // Release what we owned, the view replaces it
+    o_stream.owned = std::vector< T >();
+    o_stream.view = MeshSpanT< T >( i_data, i_count );
+    o_stream.external = true;
+}
+
+template < class T >
+static void s_own( MeshStreamT< T > &io_stream )
+{
+    if ( io_stream.external )
+    {
+        s_copy( io_stream, std::vector< T >( io_stream.view.begin(), io_stream.view.end() ) );
+    }
+}
+
+template < class T >
+static size_t s_ownedSize( const MeshStreamT< T > &i_stream )
+{
+    return i_stream.owned.capacity() * sizeof( T );
+}
+
 Mesh::Mesh()
 {
 }
 
 void Mesh::setVertices( const std::vector< Vec3f > &i_vertices )
 {
-    m_vertices = i_vertices;
+    s_copy( m_vertices, i_vertices );
+}
+
+void Mesh::setVertices( std::vector< Vec3f > &&i_vertices )
+{
+    s_move( m_vertices, std::move( i_vertices ) );
+}
+
+void Mesh::setVertices( const Vec3f* i_vertices, size_t i_count )
+{
+    s_view( m_vertices, i_vertices, i_count );
 }
 
-const std::vector< Vec3f > & Mesh::getVertices() const
+MeshSpanT< Vec3f > Mesh::getVertices() const
 {
-    return m_vertices;
+    return m_vertices.get();
 }
 
 void Mesh::setNormals( const std::vector< Vec3f > &i_normals )
 {
-    m_normals = i_normals;
+    s_copy( m_normals, i_normals );
+}
+
+void Mesh::setNormals( std::vector< Vec3f > &&i_normals )
+{
+    s_move( m_normals, std::move( i_normals ) );
+}
+
+void Mesh::setNormals( const Vec3f* i_normals, size_t i_count )
+{
+    s_view( m_normals, i_normals, i_count );
 }
 
-const std::vector< Vec3f > & Mesh::getNormals() const
+MeshSpanT< Vec3f > Mesh::getNormals() const
 {
-    return m_normals;
+    return m_normals.get();
 }
 
 void Mesh::setColors( const std::vector< Vec3f > &i_colors )
 {
-    m_colors = i_colors;
+    s_copy( m_colors, i_colors );
 }
 
-const std::vector< Vec3f > & Mesh::getColors() const
+void Mesh::setColors( std::vector< Vec3f > &&i_colors )
 {
-    return m_colors;
+    s_move( m_colors, std::move( i_colors ) );
+}
+
+void Mesh::setColors( const Vec3f* i_colors, size_t i_count )
+{
+    s_view( m_colors, i_colors, i_count );
+}
+
+MeshSpanT< Vec3f > Mesh::getColors() const
+{
+    return m_colors.get();
 }
 
 void Mesh::setUVs( const std::vector< Vec2f > &i_uvs )
 {
-    m_uvs = i_uvs;
+    s_copy( m_uvs, i_uvs );
+}
+
+void Mesh::setUVs( std::vector< Vec2f > &&i_uvs )
+{
+    s_move( m_uvs, std::move( i_uvs ) );
 }
 
-const std::vector< Vec2f > & Mesh::getUVs() const
+void Mesh::setUVs( const Vec2f* i_uvs, size_t i_count )
 {
-    return m_uvs;
+    s_view( m_uvs, i_uvs, i_count );
+}
+
+MeshSpanT< Vec2f > Mesh::getUVs() const
+{
+    return m_uvs.get();
 }
 
 void Mesh::setIndices( const std::vector< uint32_t > &i_indices )
 {
-    m_indices = i_indices;
+    s_copy( m_indices, i_indices );
+}
+
+void Mesh::setIndices( std::vector< uint32_t > &&i_indices )
+{
+    s_move( m_indices, std::move( i_indices ) );
+}
+
+void Mesh::setIndices( const uint32_t* i_indices, size_t i_count )
+{
+    s_view( m_indices, i_indices, i_count );
+}
+
+MeshSpanT< uint32_t > Mesh::getIndices() const
+{
+    return m_indices.get();
+}
+
+bool Mesh::hasViews() const
+{
+    return m_vertices.external || m_normals.external || m_colors.external || m_uvs.external || m_indices.external;
+}
+
+Mesh Mesh::copyViews() const
+{
+    Mesh mesh = *this;
+    s_own( mesh.m_vertices );
+    s_own( mesh.m_normals );
+    s_own( mesh.m_colors );
+    s_own( mesh.m_uvs );
+    s_own( mesh.m_indices );
+    return mesh;
 }
 
-const std::vector< uint32_t > & Mesh::getIndices() const
+size_t Mesh::getOwnedSize() const
 {
-    return m_indices;
+    return s_ownedSize( m_vertices ) + s_ownedSize( m_normals ) + s_ownedSize( m_colors ) + s_ownedSize( m_uvs ) + s_ownedSize( m_indices );
 }
 
 } // namespace marlin
@@ -16,6 +16,38 @@
 namespace marlin
 {
 
+// Read only view of one mesh stream, owned by the mesh or by the caller
+template < class T >
+struct MeshSpanT
+{
+    MeshSpanT() = default;
+    MeshSpanT( const T* i_data, size_t i_count ) : data( i_data ), count( i_count ) {}
+    MeshSpanT( const std::vector< T > &i_data ) : data( i_data.data() ), count( i_data.size() ) {}
+    
+    const T* data = nullptr;
+    size_t count = 0;
+    
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+    const T& operator[]( size_t i_index ) const { return data[ i_index ]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+// A stream either owns its elements or views the caller's
+template < class T >
+struct MeshStreamT
+{
+    std::vector< T > owned;
+    MeshSpanT< T > view;
+    bool external = false;
+    
+    MeshSpanT< T > get() const { return external ? view : MeshSpanT< T >( owned ); }
+};
+
+// Streams are set by copy, by move, or as views of data the caller keeps
+// alive and unchanged until it has been uploaded. Copies of a mesh share
+// the views, they do not copy the data behind them.
 class Mesh
 {
 public:
@@ -24,27 +56,46 @@ public:
     ~Mesh() = default;
 
     void setVertices( const std::vector< Vec3f > &i_vertices );
-    const std::vector< Vec3f > & getVertices() const;
+    void setVertices( std::vector< Vec3f > &&i_vertices );
+    void setVertices( const Vec3f* i_vertices, size_t i_count );
+    MeshSpanT< Vec3f > getVertices() const;
     
     void setNormals( const std::vector< Vec3f > &i_normals );
-    const std::vector< Vec3f > & getNormals() const;
+    void setNormals( std::vector< Vec3f > &&i_normals );
+    void setNormals( const Vec3f* i_normals, size_t i_count );
+    MeshSpanT< Vec3f > getNormals() const;
 
     void setColors( const std::vector< Vec3f > &i_colors );
-    const std::vector< Vec3f > & getColors() const;
+    void setColors( std::vector< Vec3f > &&i_colors );
+    void setColors( const Vec3f* i_colors, size_t i_count );
+    MeshSpanT< Vec3f > getColors() const;
 
     void setUVs( const std::vector< Vec2f > &i_uvs );
-    const std::vector< Vec2f > & getUVs() const;
+    void setUVs( std::vector< Vec2f > &&i_uvs );
+    void setUVs( const Vec2f* i_uvs, size_t i_count );
+    MeshSpanT< Vec2f > getUVs() const;
 
     void setIndices( const std::vector< uint32_t > &i_indices );
-    const std::vector< uint32_t > & getIndices() const;
+    void setIndices( std::vector< uint32_t > &&i_indices );
+    void setIndices( const uint32_t* i_indices, size_t i_count );
+    MeshSpanT< uint32_t > getIndices() const;
+    
+    // Any stream views the caller's data
+    bool hasViews() const;
+    
+    // Copy of the mesh that owns every stream, safe to keep past the views
+    Mesh copyViews() const;
+    
+    // Bytes of the streams the mesh owns, views are not counted
+    size_t getOwnedSize() const;
     
 protected:
     
-    std::vector< Vec3f > m_vertices;
-    std::vector< Vec3f > m_normals;
-    std::vector< Vec3f > m_colors;
-    std::vector< Vec2f > m_uvs;
-    std::vector< uint32_t > m_indices;
+    MeshStreamT< Vec3f > m_vertices;
+    MeshStreamT< Vec3f > m_normals;
+    MeshStreamT< Vec3f > m_colors;
+    MeshStreamT< Vec2f > m_uvs;
+    MeshStreamT< uint32_t > m_indices;
     
 };
 
@@ -0,0 +1,131 @@
+//
+//  meshCompression.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/meshCompression.hpp>
+
+#include <meshoptimizer/src/meshoptimizer.h>
+
+#include <iostream>
+#include <stdexcept>
+
+namespace marlin
+{
+
+enum CompressedStream
+{
+    CompressedStreamPositions = 0,
+    CompressedStreamNormals   = 1,
+    CompressedStreamColors    = 2,
+    CompressedStreamUVs       = 3,
+};
+
+template < class T >
+static std::vector< uint8_t > s_compressStream( MeshSpanT< T > i_stream, size_t i_vertexCount, const char* i_name )
+{
+    // Uploads never read partial streams, the compressed copy does not keep them either
+    if ( i_stream.size() != i_vertexCount && i_stream.size() != 0 )
+    {
+        std::cerr << "Warning: Mesh has " << i_stream.size() << " " << i_name << " for " << i_vertexCount << " vertices, dropping them from the compressed copy." << std::endl;
+    }
+    
+    if ( i_stream.size() != i_vertexCount || i_vertexCount == 0 )
+    {
+        return std::vector< uint8_t >();
+    }
+    
+    std::vector< uint8_t > buffer( meshopt_encodeVertexBufferBound( i_vertexCount, sizeof( T ) ) );
+    buffer.resize( meshopt_encodeVertexBuffer( buffer.data(), buffer.size(), i_stream.data, i_vertexCount, sizeof( T ) ) );
+    buffer.shrink_to_fit();
+    return buffer;
+}
+
+template < class T >
+static std::vector< T > s_decompressStream( const std::vector< uint8_t > &i_buffer, size_t i_vertexCount )
+{
+    if ( i_buffer.empty() )
+    {
+        return std::vector< T >();
+    }
+    
+    std::vector< T > stream( i_vertexCount );
+    if ( meshopt_decodeVertexBuffer( stream.data(), i_vertexCount, sizeof( T ), i_buffer.data(), i_buffer.size() ) != 0 )
+    {
+        throw std::runtime_error( "Error: Failed to decompress a mesh vertex stream." );
+    }
+    
+    return stream;
+}
+
+bool CompressedMesh::empty() const
+{
+    return vertexCount == 0 && indexCount == 0;
+}
+
+size_t CompressedMesh::getSize() const
+{
+    size_t size = indices.size();
+    for ( const std::vector< uint8_t > &stream : vertexStreams )
+    {
+        size += stream.size();
+    }
+    
+    return size;
+}
+
+CompressedMesh compressMesh( const Mesh &i_mesh )
+{
+    CompressedMesh compressed;
+    
+    const size_t vertexCount = i_mesh.getVertices().size();
+    compressed.vertexCount = static_cast< uint32_t >( vertexCount );
+    compressed.vertexStreams[ CompressedStreamPositions ] = s_compressStream( i_mesh.getVertices(), vertexCount, "positions" );
+    compressed.vertexStreams[ CompressedStreamNormals ] = s_compressStream( i_mesh.getNormals(), vertexCount, "normals" );
+    compressed.vertexStreams[ CompressedStreamColors ] = s_compressStream( i_mesh.getColors(), vertexCount, "colors" );
+    compressed.vertexStreams[ CompressedStreamUVs ] = s_compressStream( i_mesh.getUVs(), vertexCount, "UVs" );
+    
+    // The triangle codec needs whole triangles, anything else is a plain sequence
+    const MeshSpanT< uint32_t > indices = i_mesh.getIndices();
+    compressed.indexCount = static_cast< uint32_t >( indices.size() );
+    if ( indices.size() % 3 == 0 )
+    {
+        compressed.indices.resize( meshopt_encodeIndexBufferBound( indices.size(), vertexCount ) );
+        compressed.indices.resize( meshopt_encodeIndexBuffer( compressed.indices.data(), compressed.indices.size(), indices.data, indices.size() ) );
+    }
+    else
+    {
+        compressed.indices.resize( meshopt_encodeIndexSequenceBound( indices.size(), vertexCount ) );
+        compressed.indices.resize( meshopt_encodeIndexSequence( compressed.indices.data(), compressed.indices.size(), indices.data, indices.size() ) );
+    }
+    compressed.indices.shrink_to_fit();
+    
+    return compressed;
+}
+
+Mesh decompressMesh( const CompressedMesh &i_compressed )
+{
+    Mesh mesh;
+    mesh.setVertices( s_decompressStream< Vec3f >( i_compressed.vertexStreams[ CompressedStreamPositions ], i_compressed.vertexCount ) );
+    mesh.setNormals( s_decompressStream< Vec3f >( i_compressed.vertexStreams[ CompressedStreamNormals ], i_compressed.vertexCount ) );
+    mesh.setColors( s_decompressStream< Vec3f >( i_compressed.vertexStreams[ CompressedStreamColors ], i_compressed.vertexCount ) );
+    mesh.setUVs( s_decompressStream< Vec2f >( i_compressed.vertexStreams[ CompressedStreamUVs ], i_compressed.vertexCount ) );
+    
+    std::vector< uint32_t > indices( i_compressed.indexCount );
+    const int result = i_compressed.indexCount % 3 == 0 ?
+        meshopt_decodeIndexBuffer( indices.data(), indices.size(), sizeof( uint32_t ), i_compressed.indices.data(), i_compressed.indices.size() ) :
+        meshopt_decodeIndexSequence( indices.data(), indices.size(), sizeof( uint32_t ), i_compressed.indices.data(), i_compressed.indices.size() );
+    
+    if ( result != 0 )
+    {
+        throw std::runtime_error( "Error: Failed to decompress a mesh index buffer." );
+    }
+    
+    mesh.setIndices( std::move( indices ) );
+    return mesh;
+}
+
+} // namespace marlin
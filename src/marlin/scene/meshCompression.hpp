@@ -0,0 +1,56 @@
+//
+//  meshCompression.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_MESHCOMPRESSION_HPP
+#define MARLIN_MESHCOMPRESSION_HPP
+
+#include <marlin/scene/mesh.hpp>
+
+#include <array>
+#include <vector>
+
+namespace marlin
+{
+
+// What a geometry keeps on the host once a LOD has been uploaded
+enum class MeshResidency
+{
+    // The mesh, so the LOD can be uploaded again at any time
+    Keep,
+    
+    // Nothing, the LOD has to be set again before it can be uploaded again
+    Release,
+    
+    // A compressed copy, decompressed whenever the LOD is uploaded again
+    Compressed,
+};
+
+// Copy of a mesh packed with meshoptimizer's vertex and index codecs. It is
+// lossless, except that a triangle may start at another corner with the
+// same winding. Streams are compressed on their own, partial streams are
+// dropped with a warning.
+struct CompressedMesh
+{
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    
+    // Positions, normals, colors and UVs, empty when the mesh has none
+    std::array< std::vector< uint8_t >, 4 > vertexStreams;
+    std::vector< uint8_t > indices;
+    
+    bool empty() const;
+    size_t getSize() const;
+};
+
+// Safe to run on any thread
+CompressedMesh compressMesh( const Mesh &i_mesh );
+Mesh decompressMesh( const CompressedMesh &i_compressed );
+
+} // namespace marlin
+
+#endif /* MARLIN_MESHCOMPRESSION_HPP */
@@ -0,0 +1,61 @@
+//
+//  meshIngest.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/meshIngest.hpp>
+
+#include <meshoptimizer/src/meshoptimizer.h>
+
+namespace marlin
+{
+
+// FIFO size the statistics are reported for
+static const uint32_t s_analyzedCacheSize = 16;
+
+// Cache efficiency overdraw ordering may give up, as a factor of the ACMR
+static const float s_overdrawThreshold = 1.05f;
+
+IngestStats optimizeMesh( std::vector< Vertex > &io_vertices, std::vector< uint32_t > &io_indices )
+{
+    IngestStats stats;
+    stats.vertexCountBefore = static_cast< uint32_t >( io_vertices.size() );
+    stats.vertexCountAfter = stats.vertexCountBefore;
+    
+    if ( io_vertices.empty() || io_indices.size() < 3 )
+    {
+        return stats;
+    }
+    
+    const meshopt_VertexCacheStatistics before = meshopt_analyzeVertexCache( io_indices.data(), io_indices.size(), io_vertices.size(), s_analyzedCacheSize, 0, 0 );
+    stats.acmrBefore = before.acmr;
+    stats.atvrBefore = before.atvr;
+    
+    // Identical vertices share an index, the orderings below see the real topology
+    std::vector< uint32_t > remap( io_vertices.size() );
+    const size_t vertexCount = meshopt_generateVertexRemap( remap.data(), io_indices.data(), io_indices.size(), io_vertices.data(), io_vertices.size(), sizeof( Vertex ) );
+    
+    std::vector< Vertex > vertices( vertexCount );
+    meshopt_remapVertexBuffer( vertices.data(), io_vertices.data(), io_vertices.size(), sizeof( Vertex ), remap.data() );
+    meshopt_remapIndexBuffer( io_indices.data(), io_indices.data(), io_indices.size(), remap.data() );
+    
+    meshopt_optimizeVertexCache( io_indices.data(), io_indices.data(), io_indices.size(), vertexCount );
+    meshopt_optimizeOverdraw( io_indices.data(), io_indices.data(), io_indices.size(), &vertices[ 0 ].pos.x, vertexCount, sizeof( Vertex ), s_overdrawThreshold );
+    
+    // Last, so vertices are laid out in the order the cache requests them
+    io_vertices.resize( vertexCount );
+    const size_t fetchedCount = meshopt_optimizeVertexFetch( io_vertices.data(), io_indices.data(), io_indices.size(), vertices.data(), vertexCount, sizeof( Vertex ) );
+    io_vertices.resize( fetchedCount );
+    
+    const meshopt_VertexCacheStatistics after = meshopt_analyzeVertexCache( io_indices.data(), io_indices.size(), io_vertices.size(), s_analyzedCacheSize, 0, 0 );
+    stats.vertexCountAfter = static_cast< uint32_t >( io_vertices.size() );
+    stats.acmrAfter = after.acmr;
+    stats.atvrAfter = after.atvr;
+    
+    return stats;
+}
+
+} // namespace marlin
@@ -0,0 +1,39 @@
+//
+//  meshIngest.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_MESHINGEST_HPP
+#define MARLIN_MESHINGEST_HPP
+
+#include <marlin/vulkan/pipeline.hpp>
+
+#include <vector>
+
+namespace marlin
+{
+
+// Post transform cache efficiency of a mesh before and after ingest, measured
+// with a 16 entry FIFO cache. ACMR is transformed vertices per triangle, best
+// case 0.5. ATVR is transformed vertices per vertex, best case 1.0.
+struct IngestStats
+{
+    uint32_t vertexCountBefore = 0;
+    uint32_t vertexCountAfter = 0;
+    float acmrBefore = 0.0f;
+    float acmrAfter = 0.0f;
+    float atvrBefore = 0.0f;
+    float atvrAfter = 0.0f;
+};
+
+// Merges identical vertices, orders triangles for the vertex cache and then
+// for overdraw, and orders vertices by first use. Works on the interleaved
+// vertices so every attribute moves together. Safe to run on any thread.
+IngestStats optimizeMesh( std::vector< Vertex > &io_vertices, std::vector< uint32_t > &io_indices );
+
+} // namespace marlin
+
+#endif /* MARLIN_MESHINGEST_HPP */
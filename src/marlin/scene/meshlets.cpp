@@ -0,0 +1,68 @@
+//
+//  meshlets.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/meshlets.hpp>
+
+#include <meshoptimizer/src/meshoptimizer.h>
+
+namespace marlin
+{
+
+static const size_t s_meshletMaxVertices = 64;
+static const size_t s_meshletMaxTriangles = 124;
+
+// Trades spatial compactness for narrower normal cones
+static const float s_meshletConeWeight = 0.25f;
+
+MeshletClusters buildMeshlets( const VertexSource &i_vertices, MeshSpanT< uint32_t > i_indices )
+{
+    MeshletClusters clusters;
+    if ( i_vertices.count == 0 || i_indices.size() < 3 )
+    {
+        return clusters;
+    }
+    
+    const size_t maxMeshlets = meshopt_buildMeshletsBound( i_indices.size(), s_meshletMaxVertices, s_meshletMaxTriangles );
+    std::vector< meshopt_Meshlet > meshlets( maxMeshlets );
+    std::vector< uint32_t > meshletVertices( maxMeshlets * s_meshletMaxVertices );
+    std::vector< uint8_t > meshletTriangles( maxMeshlets * s_meshletMaxTriangles * 3 );
+    
+    const float* positions = &i_vertices.getPosition( 0 ).x;
+    const size_t positionStride = i_vertices.strides[ VertexAttributePosition ];
+    const size_t meshletCount = meshopt_buildMeshlets( meshlets.data(), meshletVertices.data(), meshletTriangles.data(),
+                                                       i_indices.data, i_indices.size(),
+                                                       positions, i_vertices.count, positionStride,
+                                                       s_meshletMaxVertices, s_meshletMaxTriangles, s_meshletConeWeight );
+    
+    clusters.indices.reserve( i_indices.size() );
+    clusters.meshlets.resize( meshletCount );
+    
+    for ( size_t i = 0; i < meshletCount; i++ )
+    {
+        const meshopt_Meshlet &source = meshlets[ i ];
+        Meshlet &meshlet = clusters.meshlets[ i ];
+        
+        // Meshlet local triangles back to indices into the whole vertex buffer
+        meshlet.indexOffset = static_cast< uint32_t >( clusters.indices.size() );
+        meshlet.indexCount = source.triangle_count * 3;
+        for ( uint32_t j = 0; j < meshlet.indexCount; j++ )
+        {
+            clusters.indices.push_back( meshletVertices[ source.vertex_offset + meshletTriangles[ source.triangle_offset + j ] ] );
+        }
+        
+        const meshopt_Bounds bounds = meshopt_computeMeshletBounds( &meshletVertices[ source.vertex_offset ], &meshletTriangles[ source.triangle_offset ],
+                                                                    source.triangle_count, positions, i_vertices.count, positionStride );
+        
+        meshlet.boundingSphere = Vec4f( bounds.center[ 0 ], bounds.center[ 1 ], bounds.center[ 2 ], bounds.radius );
+        meshlet.cone = Vec4f( bounds.cone_axis[ 0 ], bounds.cone_axis[ 1 ], bounds.cone_axis[ 2 ], bounds.cone_cutoff );
+    }
+    
+    return clusters;
+}
+
+} // namespace marlin
@@ -0,0 +1,50 @@
+//
+//  meshlets.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_MESHLETS_HPP
+#define MARLIN_MESHLETS_HPP
+
+#include <marlin/scene/vertexEncoding.hpp>
+
+#include <vector>
+
+namespace marlin
+{
+
+// A cone whose cutoff is above one never faces away from the camera
+static const Vec4f s_unculledCone = Vec4f( 0.0f, 0.0f, 0.0f, 2.0f );
+
+struct Meshlet
+{
+    // Range of the clustered indices, relative to the LOD's first index
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+    
+    // Object space bounding sphere, center and radius
+    Vec4f boundingSphere = Vec4f( 0.0f );
+    
+    // Axis the triangle normals lie around and the cosine cutoff of the
+    // cone, the meshlet faces away when the view is inside the cone
+    Vec4f cone = s_unculledCone;
+};
+
+struct MeshletClusters
+{
+    // Triangles of the source indices, grouped by meshlet
+    std::vector< uint32_t > indices;
+    std::vector< Meshlet > meshlets;
+};
+
+// Splits a mesh into clusters of at most 64 vertices and 124 triangles that
+// are small and flat enough to be culled on their own. The vertices are not
+// touched, only the triangle order. Safe to run on any thread.
+MeshletClusters buildMeshlets( const VertexSource &i_vertices, MeshSpanT< uint32_t > i_indices );
+
+} // namespace marlin
+
+#endif /* MARLIN_MESHLETS_HPP */
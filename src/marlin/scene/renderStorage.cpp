@@ -8,24 +8,62 @@
 
 #include <marlin/scene/renderStorage.hpp>
 
+#include <marlin/vulkan/uploadScheduler.hpp>
+
+#include <chrono>
+#include <cmath>
+
 namespace marlin
 {
 
-RenderStorage::RenderStorage( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice )
-: m_vertexPool( i_device, i_physicalDevice, PoolUsage::Vertex, 2048 * 3 )
-, m_indexPool( i_device, i_physicalDevice, PoolUsage::Index, 2048 )
-{    
-    m_indirectBuffer = BufferT< VkDrawIndexedIndirectCommand >::create( i_device, i_physicalDevice, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |  VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, BufferMode::Device, nullptr, sizeof( VkDrawIndexedIndirectCommand ) );
+// Elements each pool may move per frame while defragmenting
+static const uint32_t s_defragmentBudget = 16 * 1024;
+
+static const VkBufferUsageFlags s_transformUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+static const VkBufferUsageFlags s_boundsUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+static const VkBufferUsageFlags s_defaultAttributeUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+
+static const VkBufferUsageFlags s_indirectUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+RenderStorage::RenderStorage( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, uint32_t i_frameCount, VertexEncoding i_vertexEncoding, size_t i_poolEntryBytes )
+: m_device( i_device )
+, m_physicalDevice( i_physicalDevice )
+, m_frameCount( i_frameCount )
+, m_vertexEncoding( i_vertexEncoding )
+, m_poolEntryBytes( i_poolEntryBytes )
+, m_indexPool( i_device, i_physicalDevice, PoolUsage::Index, i_poolEntryBytes / sizeof( uint32_t ) )
+, m_transformBuffers( i_frameCount )
+, m_transformDirtyRanges( i_frameCount, { UINT32_MAX, 0 } )
+{
+    std::vector< uint32_t > defaults;
+    encodeDefaultAttributes( i_vertexEncoding, defaults );
+    m_defaultAttributes = BufferT< uint32_t >::create( i_device, i_physicalDevice, s_defaultAttributeUsage, BufferMode::Device, defaults );
 }
 
-VertexPoolHandle RenderStorage::allocateVertexBuffer( uint32_t i_size )
+VertexEncoding RenderStorage::getVertexEncoding() const
 {
-    return m_vertexPool.allocate( i_size );
+    return m_vertexEncoding;
 }
 
-void RenderStorage::deallocateVertexBuffer( const VertexPoolHandle &i_handle )
+VertexPoolHandle RenderStorage::allocateVertexBuffer( const VertexLayout &i_layout, uint32_t i_size )
 {
-    m_vertexPool.deallocate( i_handle );
+    return getVertexPool( i_layout ).allocate( i_size );
+}
+
+void RenderStorage::deallocateVertexBuffer( const VertexLayout &i_layout, const VertexPoolHandle &i_handle )
+{
+    // Frames in flight may still draw from it, and a new upload must not land there
+    BufferPoolT< uint32_t >* pool = &getVertexPool( i_layout );
+    m_device->getUploadScheduler()->defer( [ pool, i_handle ]() {
+        pool->deallocate( i_handle );
+    });
+}
+
+BufferTPtr< uint32_t > RenderStorage::getDefaultAttributeBuffer() const
+{
+    return m_defaultAttributes;
 }
 
 IndexPoolHandle RenderStorage::allocateIndexBuffer( uint32_t i_size )
@@ -35,51 +73,79 @@ IndexPoolHandle RenderStorage::allocateIndexBuffer( uint32_t i_size )
 
 void RenderStorage::deallocateIndexBuffer( const IndexPoolHandle &i_handle )
 {
-    m_indexPool.deallocate( i_handle );
+    m_device->getUploadScheduler()->defer( [ this, i_handle ]() {
+        m_indexPool.deallocate( i_handle );
+    });
 }
 
-void RenderStorage::updateLOD( ObjectId i_id, uint32_t i_lodIndex, const Mesh &i_mesh )
+void RenderStorage::updateLOD( SlotHandle &io_handle, TransformSlot i_transformSlot, uint32_t i_lodIndex, const VertexLayout &i_layout, const VertexSource &i_vertices, MeshSpanT< uint32_t > i_indices, float i_error, const Vec4f &i_dequantization, const MeshletClusters* i_clusters )
 {
-    MeshLODs &meshLODs = m_meshStorage[ i_id ];
+    if ( !m_meshStorage.contains( io_handle ) )
+    {
+        io_handle = m_meshStorage.insert( MeshLODs() );
+    }
+    
+    MeshLODs &meshLODs = *m_meshStorage.find( io_handle );
+    meshLODs.transformSlot = i_transformSlot;
     MeshStorage &meshLOD = meshLODs.meshLODs[ i_lodIndex ];
     
+    removeDraw( meshLOD );
+    
+    if ( m_vertexEncoding == VertexEncoding::Quantized )
+    {
+        setDequantization( i_transformSlot, i_dequantization );
+    }
+    
     VertexPoolHandle &vertexHandle = meshLOD.vertexHandle;
     if ( vertexHandle.isValid() )
     {
-        deallocateVertexBuffer( vertexHandle );
+        deallocateVertexBuffer( meshLOD.layout, vertexHandle );
     }
     
-    struct Vertex
+    // Empty LODs hold no allocation, they would pin pool entries
+    uint32_t vertexBufferSize = static_cast< uint32_t >( i_vertices.count );
+    meshLOD.layout = i_layout;
+    vertexHandle = VertexPoolHandle();
+    if ( vertexBufferSize > 0 )
     {
-        Vec3 pos;
-        Vec3 color;
-    };
+        vertexHandle = allocateVertexBuffer( i_layout, vertexBufferSize );
+        uploadVertices( meshLOD, i_vertices, i_dequantization );
+    }
+    
+    Vec3f boundsMin( s_InfinityFloat );
+    Vec3f boundsMax( -s_InfinityFloat );
+    for ( size_t i = 0; i < i_vertices.count; i++ )
+    {
+        boundsMin = glm::min( boundsMin, i_vertices.getPosition( i ) );
+        boundsMax = glm::max( boundsMax, i_vertices.getPosition( i ) );
+    }
+    
+    // Tighter than half the box diagonal for most meshes
+    const Vec3f center = ( boundsMin + boundsMax ) * 0.5f;
+    float radiusSquared = 0.0f;
+    for ( size_t i = 0; i < i_vertices.count; i++ )
+    {
+        const Vec3f offset = i_vertices.getPosition( i ) - center;
+        radiusSquared = std::max( radiusSquared, glm::dot( offset, offset ) );
+    }
     
-    // Temp transform vertices
-    std::vector< Vertex > vertices;
+    meshLOD.boundsMin = i_vertices.count == 0 ? Vec3f( 0.0f ) : boundsMin;
+    meshLOD.boundsMax = i_vertices.count == 0 ? Vec3f( 0.0f ) : boundsMax;
+    meshLOD.boundingSphere = i_vertices.count == 0 ? Vec4f( 0.0f ) : Vec4f( center, std::sqrt( radiusSquared ) );
     
-    const std::vector< Vec3f > &meshVertices = i_mesh.getVertices();
-    const std::vector< Vec3f > &meshColors = i_mesh.getColors();
+    meshLOD.vertexCount = static_cast< uint32_t>( i_vertices.count );
+    meshLOD.vertexOffset = static_cast< int32_t >( vertexHandle.allocation.offset );
     
-    for ( size_t i = 0; i < meshVertices.size(); i++ )
+    // Clustering reorders the triangles, the meshlets draw ranges of them
+    MeshletClusters clusters;
+    if ( m_meshletClustering && !i_clusters )
     {
-        Vec3f meshVertex = meshVertices[ i ];
-        Vec3f meshColor = meshColors[ i ];
-        
-        Vertex vertex;
-        vertex.pos = meshVertex;
-        vertex.color = meshColor;
-        
-        vertices.push_back( vertex );
+        clusters = buildMeshlets( i_vertices, i_indices );
+        i_clusters = &clusters;
     }
-
-    std::byte* bytes = reinterpret_cast< std::byte* >( vertices.data() );
-    uint32_t vertexBufferSize = static_cast< uint32_t >( vertices.size() * sizeof( Vertex ) );
-    vertexHandle = allocateVertexBuffer( vertexBufferSize );
-    BufferTPtr< std::byte > vertexBuffer = vertexHandle.buffer;
-    vertexBuffer->updateData( bytes, vertexHandle.allocation.offset, vertexBufferSize );
     
-    meshLOD.vertexCount = static_cast< uint32_t>( vertices.size() );
+    const MeshSpanT< uint32_t > indices = m_meshletClustering ? MeshSpanT< uint32_t >( i_clusters->indices ) : i_indices;
+    meshLOD.meshlets = m_meshletClustering ? i_clusters->meshlets : std::vector< Meshlet >();
     
     IndexPoolHandle &indexHandle = meshLOD.indexHandle;
     if ( indexHandle.isValid() )
@@ -87,41 +153,780 @@ void RenderStorage::updateLOD( ObjectId i_id, uint32_t i_lodIndex, const Mesh &i
         deallocateIndexBuffer( indexHandle );
     }
 
-    const std::vector< uint32_t > &indices = i_mesh.getIndices();
     uint32_t indexBufferSize = static_cast< uint32_t >( indices.size() );
-        
-    indexHandle = allocateIndexBuffer( indexBufferSize );
-    BufferTPtr< uint32_t > indexBuffer = indexHandle.buffer;
-    indexBuffer->updateData( indices.data(), indexHandle.allocation.offset, indexBufferSize );
+    
+    indexHandle = IndexPoolHandle();
+    if ( indexBufferSize > 0 )
+    {
+        indexHandle = allocateIndexBuffer( indexBufferSize );
+        BufferTPtr< uint32_t > indexBuffer = indexHandle.buffer;
+        indexBuffer->updateData( indices.data, indexHandle.allocation.offset, indexBufferSize );
+    }
     
     meshLOD.indexCount = static_cast< uint32_t>( indices.size() );
+    meshLOD.firstIndex = indexHandle.allocation.offset;
+    
+    // Without a measured error, assume the surface is off by about one edge length
+    const uint32_t triangleCount = meshLOD.indexCount / 3;
+    meshLOD.error = i_error;
+    if ( i_error < 0.0f )
+    {
+        meshLOD.error = triangleCount > 0 ? meshLOD.boundingSphere.w / std::sqrt( static_cast< float >( triangleCount ) ) : 0.0f;
+    }
+    
+    addDraw( io_handle, static_cast< uint8_t >( i_lodIndex ), meshLOD );
 }
 
-const MeshLODs* RenderStorage::getLODs( ObjectId i_id ) const
+void RenderStorage::removeGeometry( SlotHandle i_handle )
 {
-    auto itr = m_meshStorage.find( i_id );
-    if ( itr != m_meshStorage.end() )
+    MeshLODs* meshLODs = m_meshStorage.find( i_handle );
+    if ( !meshLODs )
     {
-        return &itr->second;
+        return;
     }
-    return nullptr;
+    
+    for ( MeshStorage &meshLOD : meshLODs->meshLODs )
+    {
+        removeDraw( meshLOD );
+        
+        if ( meshLOD.vertexHandle.isValid() )
+        {
+            deallocateVertexBuffer( meshLOD.layout, meshLOD.vertexHandle );
+        }
+        
+        if ( meshLOD.indexHandle.isValid() )
+        {
+            deallocateIndexBuffer( meshLOD.indexHandle );
+        }
+    }
+    
+    // The slot may be handed to an object that is not quantized
+    setDequantization( meshLODs->transformSlot, s_identityDequantization );
+    
+    m_meshStorage.erase( i_handle );
+}
+
+const MeshLODs* RenderStorage::getLODs( SlotHandle i_handle ) const
+{
+    return m_meshStorage.find( i_handle );
 }
 
-BufferTPtr< VkDrawIndexedIndirectCommand > RenderStorage::getIndirectBuffer() const
+const MeshStorageMap & RenderStorage::getGeometries() const
 {
-    return m_indirectBuffer;
+    return m_meshStorage;
 }
 
-std::vector< ObjectId > RenderStorage::getGeometryIds() const
+void RenderStorage::selectLODs( const TransformStore &i_transforms, const LODSelector &i_selector )
 {
-    std::vector< ObjectId > objectIds;
-    for ( const auto &pair : m_meshStorage )
+    for ( MeshLODs &meshLODs : m_meshStorage )
     {
-        objectIds.push_back( pair.first );
+        const Mat4f world = i_transforms.get( meshLODs.transformSlot );
+        const uint8_t selectedLOD = i_selector.select( meshLODs, world, meshLODs.selectedLOD );
+        if ( selectedLOD == meshLODs.selectedLOD )
+        {
+            continue;
+        }
+        
+        if ( meshLODs.selectedLOD != s_invalidLOD )
+        {
+            setSelected( meshLODs.meshLODs[ meshLODs.selectedLOD ], false );
+        }
+        
+        if ( selectedLOD != s_invalidLOD )
+        {
+            setSelected( meshLODs.meshLODs[ selectedLOD ], true );
+        }
+        
+        meshLODs.selectedLOD = selectedLOD;
+    }
+}
+
+void RenderStorage::cull( const TransformStore &i_transforms, const Frustum &i_frustum )
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    
+    m_cullStats = CullStats();
+    
+    for ( auto &pair : m_indirectBatches )
+    {
+        IndirectBatch &batch = pair.second;
+        const size_t count = batch.commands.size();
+        
+        // Padded so the last group of four reads initialised memory
+        const size_t padded = ( count + 3 ) & ~size_t( 3 );
+        for ( std::vector< float > &component : m_cullSpheres )
+        {
+            component.resize( padded, 0.0f );
+        }
+        m_cullVisibility.resize( count );
+        
+        float* worldX = m_cullSpheres[ 0 ].data();
+        float* worldY = m_cullSpheres[ 1 ].data();
+        float* worldZ = m_cullSpheres[ 2 ].data();
+        float* worldRadius = m_cullSpheres[ 3 ].data();
+        
+        // Into world space, scaled by the longest axis so the sphere stays conservative
+        for ( size_t i = 0; i < count; i++ )
+        {
+            const Mat4f world = i_transforms.get( batch.commands[ i ].firstInstance );
+            const Vec4f center = world * Vec4f( batch.sphereX[ i ], batch.sphereY[ i ], batch.sphereZ[ i ], 1.0f );
+            const float scale = std::max( { glm::length( Vec3f( world[ 0 ] ) ), glm::length( Vec3f( world[ 1 ] ) ), glm::length( Vec3f( world[ 2 ] ) ) } );
+            
+            worldX[ i ] = center.x;
+            worldY[ i ] = center.y;
+            worldZ[ i ] = center.z;
+            worldRadius[ i ] = batch.sphereRadius[ i ] * scale;
+        }
+        
+        i_frustum.cullSpheres( worldX, worldY, worldZ, worldRadius, count, m_cullVisibility.data() );
+        
+        // Draws of unselected LODs are not counted, they were never going to be drawn
+        uint32_t selectedCount = 0;
+        uint32_t visibleCount = 0;
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            const uint32_t instanceCount = m_cullVisibility[ i ] & batch.selected[ i ];
+            selectedCount += batch.selected[ i ];
+            visibleCount += instanceCount;
+            
+            VkDrawIndexedIndirectCommand &command = batch.commands[ i ];
+            if ( command.instanceCount != instanceCount )
+            {
+                command.instanceCount = instanceCount;
+                markDirty( batch, i );
+            }
+        }
+        
+        m_cullStats.drawCount += selectedCount;
+        m_cullStats.visibleCount += visibleCount;
     }
     
-    return objectIds;
+    m_cullStats.culledCount = m_cullStats.drawCount - m_cullStats.visibleCount;
+    m_cullStats.milliseconds = std::chrono::duration< double, std::milli >( std::chrono::high_resolution_clock::now() - start ).count();
 }
 
+const CullStats & RenderStorage::getCullStats() const
+{
+    return m_cullStats;
+}
+
+void RenderStorage::setGpuCulling( bool i_enabled )
+{
+    if ( m_gpuCulling == i_enabled )
+    {
+        return;
+    }
+    
+    m_gpuCulling = i_enabled;
+    
+    // Undo what the host culled, and make every frame build its device buffers
+    for ( auto &pair : m_indirectBatches )
+    {
+        IndirectBatch &batch = pair.second;
+        for ( size_t i = 0; i < batch.commands.size(); i++ )
+        {
+            batch.commands[ i ].instanceCount = batch.selected[ i ];
+        }
+        
+        if ( !batch.commands.empty() )
+        {
+            markDirty( batch, 0 );
+            markDirty( batch, static_cast< uint32_t >( batch.commands.size() - 1 ) );
+        }
+    }
+    
+    m_revision++;
+}
+
+bool RenderStorage::getGpuCulling() const
+{
+    return m_gpuCulling;
+}
+
+void RenderStorage::setMeshletClustering( bool i_enabled )
+{
+    m_meshletClustering = i_enabled;
+}
+
+bool RenderStorage::getMeshletClustering() const
+{
+    return m_meshletClustering;
+}
+
+void RenderStorage::setInterleavedVertices( bool i_enabled )
+{
+    m_interleavedVertices = i_enabled;
+}
+
+bool RenderStorage::getInterleavedVertices() const
+{
+    return m_interleavedVertices;
+}
+
+void RenderStorage::updateIndirectBatches( uint32_t i_frame )
+{
+    for ( auto &pair : m_indirectBatches )
+    {
+        IndirectBatch &batch = pair.second;
+        std::pair< uint32_t, uint32_t > &dirtyRange = batch.dirtyRanges[ i_frame ];
+        
+        if ( dirtyRange.first >= dirtyRange.second )
+        {
+            continue;
+        }
+        
+        BufferTPtr< VkDrawIndexedIndirectCommand > &indirectBuffer = batch.indirectBuffers[ i_frame ];
+        const bool missingCullBuffers = m_gpuCulling && !batch.boundsBuffers[ i_frame ];
+        if ( !indirectBuffer || batch.commands.size() > indirectBuffer->getCount() || missingCullBuffers )
+        {
+            // Retire the old buffers with the frame being built, the new ones need everything
+            const size_t count = std::max< size_t >( batch.commands.size(), indirectBuffer ? indirectBuffer->getCount() * 2 : 64 );
+            retireBuffers( batch, i_frame );
+            
+            indirectBuffer = BufferT< VkDrawIndexedIndirectCommand >::create( m_device, m_physicalDevice, s_indirectUsage, BufferMode::Device, nullptr, count );
+            
+            batch.boundsBuffers[ i_frame ] = nullptr;
+            batch.visibleBuffers[ i_frame ] = nullptr;
+            if ( m_gpuCulling )
+            {
+                batch.boundsBuffers[ i_frame ] = BufferT< DrawBounds >::create( m_device, m_physicalDevice, s_boundsUsage, BufferMode::Device, nullptr, count );
+                batch.visibleBuffers[ i_frame ] = BufferT< VkDrawIndexedIndirectCommand >::create( m_device, m_physicalDevice, s_indirectUsage, BufferMode::Device, nullptr, count + 1 );
+            }
+            
+            dirtyRange = { 0, static_cast< uint32_t >( batch.commands.size() ) };
+        }
+        
+        // Slots past the end were removed, the draw count already excludes them
+        const uint32_t end = std::min( dirtyRange.second, static_cast< uint32_t >( batch.commands.size() ) );
+        if ( dirtyRange.first < end )
+        {
+            indirectBuffer->updateData( batch.commands.data() + dirtyRange.first, dirtyRange.first, end - dirtyRange.first );
+            
+            if ( m_gpuCulling )
+            {
+                m_boundsScratch.resize( end - dirtyRange.first );
+                for ( uint32_t i = dirtyRange.first; i < end; i++ )
+                {
+                    // Spheres go into the quantized space the device transforms expect
+                    const Vec4f dequantization = getDequantization( batch.commands[ i ].firstInstance );
+                    const Vec3f center = ( Vec3f( batch.sphereX[ i ], batch.sphereY[ i ], batch.sphereZ[ i ] ) - Vec3f( dequantization ) ) / dequantization.w;
+                    
+                    m_boundsScratch[ i - dirtyRange.first ] = {
+                        .sphere = Vec4f( center, batch.sphereRadius[ i ] / dequantization.w ),
+                        .cone = batch.cones[ i ],
+                    };
+                }
+                
+                batch.boundsBuffers[ i_frame ]->updateData( m_boundsScratch.data(), dirtyRange.first, end - dirtyRange.first );
+            }
+        }
+        
+        dirtyRange = { UINT32_MAX, 0 };
+    }
+}
+
+const IndirectBatches & RenderStorage::getIndirectBatches() const
+{
+    return m_indirectBatches;
+}
+
+void RenderStorage::updateTransforms( TransformStore &io_transforms, uint32_t i_frame )
+{
+    // Every frame's copy is missing what was written since the last take
+    const std::pair< uint32_t, uint32_t > written = io_transforms.takeDirtyRange();
+    if ( written.first < written.second )
+    {
+        for ( std::pair< uint32_t, uint32_t > &dirtyRange : m_transformDirtyRanges )
+        {
+            dirtyRange.first = std::min( dirtyRange.first, written.first );
+            dirtyRange.second = std::max( dirtyRange.second, written.second );
+        }
+    }
+    
+    const uint32_t size = io_transforms.getSize();
+    std::pair< uint32_t, uint32_t > &dirtyRange = m_transformDirtyRanges[ i_frame ];
+    
+    BufferTPtr< Mat4f > &transformBuffer = m_transformBuffers[ i_frame ];
+    if ( !transformBuffer || size > transformBuffer->getCount() )
+    {
+        if ( transformBuffer )
+        {
+            BufferTPtr< Mat4f > retired = transformBuffer;
+            m_device->getUploadScheduler()->defer( [ retired ]() {
+                retired->destroy();
+            });
+        }
+        
+        const size_t count = std::max< size_t >( size, transformBuffer ? transformBuffer->getCount() * 2 : 64 );
+        transformBuffer = BufferT< Mat4f >::create( m_device, m_physicalDevice, s_transformUsage, BufferMode::Device, nullptr, count );
+        
+        dirtyRange = { 0, size };
+        m_revision++;
+    }
+    
+    const uint32_t end = std::min( dirtyRange.second, size );
+    if ( dirtyRange.first < end )
+    {
+        m_transformScratch.resize( end - dirtyRange.first );
+        io_transforms.gather( dirtyRange.first, end, m_transformScratch.data() );
+        
+        // Quantized positions are scaled and offset back into object space first
+        const uint32_t quantizedEnd = std::min( end, static_cast< uint32_t >( m_dequantization.size() ) );
+        for ( uint32_t slot = dirtyRange.first; slot < quantizedEnd; slot++ )
+        {
+            const Vec4f &dequantization = m_dequantization[ slot ];
+            if ( dequantization == s_identityDequantization )
+            {
+                continue;
+            }
+            
+            Mat4f &transform = m_transformScratch[ slot - dirtyRange.first ];
+            transform[ 3 ] = transform * Vec4f( Vec3f( dequantization ), 1.0f );
+            transform[ 0 ] *= dequantization.w;
+            transform[ 1 ] *= dequantization.w;
+            transform[ 2 ] *= dequantization.w;
+        }
+        transformBuffer->updateData( m_transformScratch.data(), dirtyRange.first, end - dirtyRange.first );
+    }
+    
+    dirtyRange = { UINT32_MAX, 0 };
+}
+
+BufferTPtr< Mat4f > RenderStorage::getTransformBuffer( uint32_t i_frame ) const
+{
+    return m_transformBuffers[ i_frame ];
+}
+
+void RenderStorage::defragment()
+{
+    size_t vertexEntry = 0;
+    size_t indexEntry = 0;
+    bool moveIndices = m_indexPool.getEvacuationCandidate( indexEntry );
+    
+    // One layout's pool at a time
+    bool moveVertices = false;
+    uint8_t vertexLayoutKey = 0;
+    for ( const auto &[ layoutKey, pool ] : m_vertexPools )
+    {
+        if ( pool->getEvacuationCandidate( vertexEntry ) )
+        {
+            moveVertices = true;
+            vertexLayoutKey = layoutKey;
+            break;
+        }
+    }
+    
+    const VertexLayout vertexLayout = VertexLayout::fromKey( vertexLayoutKey );
+    
+    uint32_t vertexBudget = s_defragmentBudget;
+    uint32_t indexBudget = s_defragmentBudget;
+    
+    for ( size_t i = 0; i < m_meshStorage.size(); i++ )
+    {
+        if ( !moveVertices && !moveIndices )
+        {
+            break;
+        }
+        
+        MeshLODs &meshLODs = m_meshStorage.getValue( i );
+        for ( uint8_t lodIndex = 0; lodIndex < s_maxLODs; lodIndex++ )
+        {
+            MeshStorage &meshLOD = meshLODs.meshLODs[ lodIndex ];
+            bool moved = false;
+            
+            if ( moveVertices && meshLOD.vertexHandle.isValid() && meshLOD.layout.getKey() == vertexLayoutKey && meshLOD.vertexHandle.index == vertexEntry && vertexBudget > 0 )
+            {
+                BufferPoolT< uint32_t > &vertexPool = getVertexPool( vertexLayout );
+                VertexPoolHandle handle = vertexPool.allocateElsewhere( meshLOD.vertexCount, vertexEntry );
+                if ( handle.isValid() )
+                {
+                    // Separate layouts move every stream, entries may differ in size
+                    const uint32_t stride = vertexPool.getStride();
+                    const std::vector< VkDeviceSize > srcStreams = vertexLayout.getStreamOffsets( m_vertexEncoding, static_cast< uint32_t >( meshLOD.vertexHandle.buffer->getCount() / stride ) );
+                    const std::vector< VkDeviceSize > dstStreams = vertexLayout.getStreamOffsets( m_vertexEncoding, static_cast< uint32_t >( handle.buffer->getCount() / stride ) );
+                    const std::vector< VertexAttribute > attributes = vertexLayout.getAttributes();
+                    
+                    for ( size_t stream = 0; stream < srcStreams.size(); stream++ )
+                    {
+                        const VkDeviceSize vertexSize = vertexLayout.interleaved ? vertexLayout.getVertexSize( m_vertexEncoding ) : getAttributeSize( attributes[ stream ], m_vertexEncoding );
+                        PendingMove move {
+                            .srcBuffer = meshLOD.vertexHandle.buffer->getObject(),
+                            .dstBuffer = handle.buffer->getObject(),
+                            .region = { srcStreams[ stream ] + meshLOD.vertexHandle.allocation.offset * vertexSize, dstStreams[ stream ] + handle.allocation.offset * vertexSize, meshLOD.vertexCount * vertexSize },
+                        };
+                        m_pendingMoves.push_back( move );
+                    }
+                    
+                    removeDraw( meshLOD );
+                    deallocateVertexBuffer( meshLOD.layout, meshLOD.vertexHandle );
+                    
+                    meshLOD.vertexHandle = handle;
+                    meshLOD.vertexOffset = static_cast< int32_t >( handle.allocation.offset );
+                    vertexBudget -= std::min( vertexBudget, meshLOD.vertexCount );
+                    moved = true;
+                }
+                else
+                {
+                    moveVertices = false;
+                }
+            }
+            
+            if ( moveIndices && meshLOD.indexHandle.isValid() && meshLOD.indexHandle.index == indexEntry && indexBudget > 0 )
+            {
+                IndexPoolHandle handle = m_indexPool.allocateElsewhere( meshLOD.indexCount, indexEntry );
+                if ( handle.isValid() )
+                {
+                    PendingMove move {
+                        .srcBuffer = meshLOD.indexHandle.buffer->getObject(),
+                        .dstBuffer = handle.buffer->getObject(),
+                        .region = { meshLOD.indexHandle.allocation.offset * sizeof( uint32_t ), handle.allocation.offset * sizeof( uint32_t ), meshLOD.indexCount * sizeof( uint32_t ) },
+                    };
+                    m_pendingMoves.push_back( move );
+                    
+                    removeDraw( meshLOD );
+                    deallocateIndexBuffer( meshLOD.indexHandle );
+                    
+                    meshLOD.indexHandle = handle;
+                    meshLOD.firstIndex = handle.allocation.offset;
+                    indexBudget -= std::min( indexBudget, meshLOD.indexCount );
+                    moved = true;
+                }
+                else
+                {
+                    moveIndices = false;
+                }
+            }
+            
+            // The draw may now belong to a different batch
+            if ( moved )
+            {
+                addDraw( m_meshStorage.getHandle( i ), lodIndex, meshLOD );
+            }
+        }
+    }
+}
+
+bool RenderStorage::hasPendingMoves() const
+{
+    return !m_pendingMoves.empty();
+}
+
+void RenderStorage::recordMoves( VkCommandBuffer i_commandBuffer )
+{
+    if ( m_pendingMoves.empty() )
+    {
+        return;
+    }
+    
+    for ( const PendingMove &move : m_pendingMoves )
+    {
+        vkCmdCopyBuffer( i_commandBuffer, move.srcBuffer, move.dstBuffer, 1, &move.region );
+    }
+    
+    // Later frames may move the same data again, so copies are consumers too
+    VkMemoryBarrier barrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+    };
+    
+    vkCmdPipelineBarrier( i_commandBuffer,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          0, 1, &barrier, 0, nullptr, 0, nullptr );
+    
+    m_pendingMoves.clear();
+}
+
+uint64_t RenderStorage::getRevision() const
+{
+    return m_revision;
+}
+
+BufferPoolStats RenderStorage::getVertexPoolStats() const
+{
+    BufferPoolStats stats;
+    for ( const auto &[ layoutKey, pool ] : m_vertexPools )
+    {
+        const BufferPoolStats poolStats = pool->getStats();
+        stats.entryCount += poolStats.entryCount;
+        stats.dedicatedCount += poolStats.dedicatedCount;
+        stats.totalSize += poolStats.totalSize;
+        stats.freeSize += poolStats.freeSize;
+        stats.largestFreeRegion = std::max( stats.largestFreeRegion, poolStats.largestFreeRegion );
+        
+        for ( size_t i = 0; i < stats.freeRegionHistogram.size(); i++ )
+        {
+            stats.freeRegionHistogram[ i ] += poolStats.freeRegionHistogram[ i ];
+        }
+    }
+    
+    // A layout's allocations only fit its own pool, so this overstates fragmentation
+    stats.fragmentation = stats.freeSize > 0 ? 1.0f - static_cast< float >( stats.largestFreeRegion ) / static_cast< float >( stats.freeSize ) : 0.0f;
+    
+    return stats;
+}
+
+BufferPoolStats RenderStorage::getIndexPoolStats() const
+{
+    return m_indexPool.getStats();
+}
+
+void RenderStorage::addDraw( SlotHandle i_handle, uint8_t i_lodIndex, MeshStorage &io_storage )
+{
+    if ( io_storage.indexCount == 0 || !io_storage.vertexHandle.isValid() || !io_storage.indexHandle.isValid() )
+    {
+        return;
+    }
+    
+    const IndirectBatchKey key = ( static_cast< IndirectBatchKey >( io_storage.layout.getKey() ) << 56 ) | ( static_cast< IndirectBatchKey >( io_storage.vertexHandle.index ) << 32 ) | io_storage.indexHandle.index;
+    
+    auto itr = m_indirectBatches.find( key );
+    if ( itr == m_indirectBatches.end() )
+    {
+        const uint32_t stride = getVertexPool( io_storage.layout ).getStride();
+        
+        IndirectBatch batch;
+        batch.layout = io_storage.layout;
+        batch.vertexBuffer = io_storage.vertexHandle.buffer;
+        batch.vertexOffsets = io_storage.layout.getStreamOffsets( m_vertexEncoding, static_cast< uint32_t >( batch.vertexBuffer->getCount() / stride ) );
+        batch.indexBuffer = io_storage.indexHandle.buffer;
+        batch.indirectBuffers.resize( m_frameCount );
+        batch.dirtyRanges.resize( m_frameCount, { UINT32_MAX, 0 } );
+        batch.boundsBuffers.resize( m_frameCount );
+        batch.visibleBuffers.resize( m_frameCount );
+        
+        itr = m_indirectBatches.emplace( key, std::move( batch ) ).first;
+    }
+    
+    IndirectBatch &batch = itr->second;
+    
+    const MeshLODs &meshLODs = *m_meshStorage.find( i_handle );
+    const uint8_t selected = meshLODs.selectedLOD == i_lodIndex ? 1 : 0;
+    
+    // An unclustered LOD is one meshlet covering every index
+    const Meshlet whole {
+        .indexOffset = 0,
+        .indexCount = io_storage.indexCount,
+        .boundingSphere = io_storage.boundingSphere,
+        .cone = s_unculledCone,
+    };
+    
+    const bool clustered = !io_storage.meshlets.empty();
+    const uint32_t drawCount = clustered ? static_cast< uint32_t >( io_storage.meshlets.size() ) : 1;
+    
+    io_storage.batchKey = key;
+    io_storage.drawSlots.resize( drawCount );
+    
+    for ( uint32_t i = 0; i < drawCount; i++ )
+    {
+        const Meshlet &meshlet = clustered ? io_storage.meshlets[ i ] : whole;
+        
+        VkDrawIndexedIndirectCommand command {
+            .indexCount = meshlet.indexCount,
+            .instanceCount = selected,
+            .firstIndex = io_storage.firstIndex + meshlet.indexOffset,
+            .vertexOffset = io_storage.vertexOffset,
+            .firstInstance = meshLODs.transformSlot,
+        };
+        
+        io_storage.drawSlots[ i ] = static_cast< uint32_t >( batch.commands.size() );
+        
+        batch.commands.push_back( command );
+        batch.owners.push_back( { .handle = i_handle, .lodIndex = i_lodIndex, .drawIndex = i } );
+        
+        batch.sphereX.push_back( meshlet.boundingSphere.x );
+        batch.sphereY.push_back( meshlet.boundingSphere.y );
+        batch.sphereZ.push_back( meshlet.boundingSphere.z );
+        batch.sphereRadius.push_back( meshlet.boundingSphere.w );
+        batch.cones.push_back( meshlet.cone );
+        batch.selected.push_back( selected );
+    }
+    
+    // The draws were appended, so the range covers them all
+    markDirty( batch, io_storage.drawSlots.front() );
+    markDirty( batch, io_storage.drawSlots.back() );
+    m_revision++;
+}
+
+void RenderStorage::removeDraw( MeshStorage &io_storage )
+{
+    if ( io_storage.drawSlots.empty() )
+    {
+        return;
+    }
+    
+    auto itr = m_indirectBatches.find( io_storage.batchKey );
+    IndirectBatch &batch = itr->second;
+    
+    // Slots are read as we go, the draw swapped down may be one of ours
+    for ( size_t i = io_storage.drawSlots.size(); i-- > 0; )
+    {
+        const uint32_t slot = io_storage.drawSlots[ i ];
+        const uint32_t last = static_cast< uint32_t >( batch.commands.size() - 1 );
+        
+        // Swap the last draw into the hole so the batch stays packed
+        if ( slot != last )
+        {
+            batch.commands[ slot ] = batch.commands[ last ];
+            batch.owners[ slot ] = batch.owners[ last ];
+            batch.sphereX[ slot ] = batch.sphereX[ last ];
+            batch.sphereY[ slot ] = batch.sphereY[ last ];
+            batch.sphereZ[ slot ] = batch.sphereZ[ last ];
+            batch.sphereRadius[ slot ] = batch.sphereRadius[ last ];
+            batch.cones[ slot ] = batch.cones[ last ];
+            batch.selected[ slot ] = batch.selected[ last ];
+            
+            const DrawOwner &owner = batch.owners[ slot ];
+            m_meshStorage.find( owner.handle )->meshLODs[ owner.lodIndex ].drawSlots[ owner.drawIndex ] = slot;
+            
+            markDirty( batch, slot );
+        }
+        
+        batch.commands.pop_back();
+        batch.owners.pop_back();
+        batch.sphereX.pop_back();
+        batch.sphereY.pop_back();
+        batch.sphereZ.pop_back();
+        batch.sphereRadius.pop_back();
+        batch.cones.pop_back();
+        batch.selected.pop_back();
+    }
+    
+    io_storage.drawSlots.clear();
+    m_revision++;
+    
+    if ( batch.commands.empty() )
+    {
+        for ( uint32_t frame = 0; frame < m_frameCount; frame++ )
+        {
+            retireBuffers( batch, frame );
+        }
+        
+        m_indirectBatches.erase( itr );
+    }
+}
+
+void RenderStorage::markDirty( IndirectBatch &io_batch, uint32_t i_slot )
+{
+    for ( std::pair< uint32_t, uint32_t > &dirtyRange : io_batch.dirtyRanges )
+    {
+        dirtyRange.first = std::min( dirtyRange.first, i_slot );
+        dirtyRange.second = std::max( dirtyRange.second, i_slot + 1 );
+    }
+}
+
+void RenderStorage::setSelected( const MeshStorage &i_storage, bool i_selected )
+{
+    if ( i_storage.drawSlots.empty() )
+    {
+        return;
+    }
+    
+    IndirectBatch &batch = m_indirectBatches.find( i_storage.batchKey )->second;
+    for ( uint32_t slot : i_storage.drawSlots )
+    {
+        batch.selected[ slot ] = i_selected ? 1 : 0;
+        batch.commands[ slot ].instanceCount = i_selected ? 1 : 0;
+        
+        markDirty( batch, slot );
+    }
+}
+
+void RenderStorage::setDequantization( TransformSlot i_slot, const Vec4f &i_dequantization )
+{
+    if ( i_slot == s_invalidTransformSlot || getDequantization( i_slot ) == i_dequantization )
+    {
+        return;
+    }
+    
+    if ( i_slot >= m_dequantization.size() )
+    {
+        m_dequantization.resize( i_slot + 1, s_identityDequantization );
+    }
+    m_dequantization[ i_slot ] = i_dequantization;
+    
+    // Every frame's device matrix for the slot is stale
+    for ( std::pair< uint32_t, uint32_t > &dirtyRange : m_transformDirtyRanges )
+    {
+        dirtyRange.first = std::min( dirtyRange.first, i_slot );
+        dirtyRange.second = std::max( dirtyRange.second, i_slot + 1 );
+    }
+}
+
+Vec4f RenderStorage::getDequantization( TransformSlot i_slot ) const
+{
+    return i_slot < m_dequantization.size() ? m_dequantization[ i_slot ] : s_identityDequantization;
+}
+
+BufferPoolT< uint32_t > & RenderStorage::getVertexPool( const VertexLayout &i_layout )
+{
+    std::unique_ptr< BufferPoolT< uint32_t > > &pool = m_vertexPools[ i_layout.getKey() ];
+    if ( !pool )
+    {
+        const uint32_t stride = i_layout.getVertexSize( m_vertexEncoding ) / sizeof( uint32_t );
+        pool = std::make_unique< BufferPoolT< uint32_t > >( m_device, m_physicalDevice, PoolUsage::Vertex, m_poolEntryBytes / ( stride * sizeof( uint32_t ) ), stride );
+    }
+    
+    return *pool;
+}
+
+void RenderStorage::uploadVertices( const MeshStorage &i_storage, const VertexSource &i_vertices, const Vec4f &i_dequantization )
+{
+    const VertexPoolHandle &handle = i_storage.vertexHandle;
+    const uint32_t stride = getVertexPool( i_storage.layout ).getStride();
+    
+    if ( i_storage.layout.interleaved )
+    {
+        BufferSpanT< uint32_t > staged = handle.buffer->stageData( handle.allocation.offset * stride, i_vertices.count * stride );
+        encodeVertices( i_vertices, m_vertexEncoding, i_storage.layout, i_dequantization, staged.data );
+        return;
+    }
+    
+    // Every stream lands in its own part of the entry
+    const uint32_t entrySize = static_cast< uint32_t >( handle.buffer->getCount() / stride );
+    const std::vector< VkDeviceSize > streamOffsets = i_storage.layout.getStreamOffsets( m_vertexEncoding, entrySize );
+    const std::vector< VertexAttribute > attributes = i_storage.layout.getAttributes();
+    
+    for ( size_t stream = 0; stream < attributes.size(); stream++ )
+    {
+        const size_t attributeSize = getAttributeSize( attributes[ stream ], m_vertexEncoding );
+        const size_t attributeWords = attributeSize / sizeof( uint32_t );
+        const size_t destination = streamOffsets[ stream ] / sizeof( uint32_t ) + handle.allocation.offset * attributeWords;
+        
+        BufferSpanT< uint32_t > staged = handle.buffer->stageData( destination, i_vertices.count * attributeWords );
+        encodeAttribute( i_vertices, attributes[ stream ], m_vertexEncoding, i_dequantization, staged.data, attributeSize );
+    }
+}
+
+void RenderStorage::retireBuffers( const IndirectBatch &i_batch, uint32_t i_frame )
+{
+    // Frames in flight may still read them
+    BufferTPtr< VkDrawIndexedIndirectCommand > indirectBuffer = i_batch.indirectBuffers[ i_frame ];
+    BufferTPtr< DrawBounds > boundsBuffer = i_batch.boundsBuffers[ i_frame ];
+    BufferTPtr< VkDrawIndexedIndirectCommand > visibleBuffer = i_batch.visibleBuffers[ i_frame ];
+    
+    if ( !indirectBuffer && !boundsBuffer && !visibleBuffer )
+    {
+        return;
+    }
+    
+    m_device->getUploadScheduler()->defer( [ indirectBuffer, boundsBuffer, visibleBuffer ]() {
+        if ( indirectBuffer )
+        {
+            indirectBuffer->destroy();
+        }
+        
+        if ( boundsBuffer )
+        {
+            boundsBuffer->destroy();
+        }
+        
+        if ( visibleBuffer )
+        {
+            visibleBuffer->destroy();
+        }
+    });
+}
 
 } // namespace marlin
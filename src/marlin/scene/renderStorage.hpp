@@ -9,59 +9,268 @@
 #ifndef MARLIN_RENDERSTORAGE_HPP
 #define MARLIN_RENDERSTORAGE_HPP
 
+#include <marlin/scene/frustum.hpp>
+#include <marlin/scene/lodSelector.hpp>
 #include <marlin/scene/mesh.hpp>
+#include <marlin/scene/meshlets.hpp>
 #include <marlin/scene/scene.hpp>
+#include <marlin/scene/slotMap.hpp>
+#include <marlin/scene/vertexEncoding.hpp>
 #include <marlin/vulkan/bufferPool.hpp>
+#include <marlin/vulkan/pipeline.hpp>
 
-#include <unordered_map>
+#include <array>
 
 namespace marlin
 {
 
-using VertexPoolHandle = BufferPoolHandleT< std::byte >;
+// Pools hand out element offsets, so every mesh in an entry shares one bind.
+// Vertices are runs of words whose length depends on the encoding and layout.
+using VertexPoolHandle = BufferPoolHandleT< uint32_t >;
 using IndexPoolHandle = BufferPoolHandleT< uint32_t >;
 
+// Bytes in each shared vertex and index pool entry. Every entry is a batch
+// key, so entries are large enough that a scene of small meshes draws from a
+// handful of batches, and small enough to share the memory allocator's blocks.
+static const size_t s_defaultPoolEntryBytes = 16 * 1024 * 1024;
+
+// Vertex layout in the top byte, vertex pool entry in the rest of the high
+// bits, index pool entry in the low bits. Batches sort by layout, so the
+// pipeline changes once per layout.
+using IndirectBatchKey = uint64_t;
+
 struct MeshStorage
 {
+    VertexLayout layout;
     VertexPoolHandle vertexHandle;
     IndexPoolHandle indexHandle;
-    uint32_t vertexCount;
-    uint32_t indexCount;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    
+    // Element offsets into the bound pool buffers
+    uint32_t firstIndex = 0;
+    int32_t vertexOffset = 0;
+    
+    // Object space bounds, the sphere is centered on the box
+    Vec3f boundsMin = Vec3f( 0.0f );
+    Vec3f boundsMax = Vec3f( 0.0f );
+    Vec4f boundingSphere = Vec4f( 0.0f );
+    
+    // Object space distance from the full detail surface
+    float error = 0.0f;
+    
+    // Empty when the LOD is drawn whole
+    std::vector< Meshlet > meshlets;
+    
+    // Where this LOD's draws live in its indirect batch, one per meshlet
+    IndirectBatchKey batchKey = 0;
+    std::vector< uint32_t > drawSlots;
 };
 
 struct MeshLODs
 {
-    std::map< uint8_t, MeshStorage > meshLODs;
+    // Instance index of every draw, selects the object's world matrix
+    TransformSlot transformSlot = s_invalidTransformSlot;
+    std::array< MeshStorage, s_maxLODs > meshLODs;
+    
+    // The only LOD whose draw has instances, chosen by selectLODs
+    uint8_t selectedLOD = s_invalidLOD;
+};
+
+using MeshStorageMap = SlotMapT< MeshLODs >;
+
+struct DrawOwner
+{
+    SlotHandle handle;
+    uint8_t lodIndex;
+    
+    // Index into the LOD's draw slots
+    uint32_t drawIndex;
 };
 
+// What the device culling pass reads per draw, see cull.comp
+struct DrawBounds
+{
+    Vec4f sphere;
+    Vec4f cone;
+};
+
+// All draws that share one vertex pool entry and one index pool entry, and
+// so can be issued with a single bind and a single indirect draw
+struct IndirectBatch
+{
+    VertexLayout layout;
+    BufferTPtr< uint32_t > vertexBuffer;
+    
+    // Byte offset of every stream in the vertex buffer, one per binding
+    std::vector< VkDeviceSize > vertexOffsets;
+    
+    BufferTPtr< uint32_t > indexBuffer;
+    
+    std::vector< VkDrawIndexedIndirectCommand > commands;
+    std::vector< DrawOwner > owners;
+    
+    // Object space bounding sphere of every draw, parallel to the commands
+    std::vector< float > sphereX;
+    std::vector< float > sphereY;
+    std::vector< float > sphereZ;
+    std::vector< float > sphereRadius;
+    
+    // Normal cone of every draw, only the device culls with them
+    std::vector< Vec4f > cones;
+    
+    // One for the draws of selected LODs, the rest never have instances
+    std::vector< uint8_t > selected;
+    
+    // Per frame in flight device copy and the slots it is missing
+    std::vector< BufferTPtr< VkDrawIndexedIndirectCommand > > indirectBuffers;
+    std::vector< std::pair< uint32_t, uint32_t > > dirtyRanges;
+    
+    // Only with device culling. Bounds follow the commands, the visible
+    // draws are written one slot in, behind the draw count.
+    std::vector< BufferTPtr< DrawBounds > > boundsBuffers;
+    std::vector< BufferTPtr< VkDrawIndexedIndirectCommand > > visibleBuffers;
+};
+
+using IndirectBatches = std::map< IndirectBatchKey, IndirectBatch >;
+
+
 class RenderStorage
 {
 public:
 
-    RenderStorage( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice );
+    RenderStorage( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, uint32_t i_frameCount, VertexEncoding i_vertexEncoding, size_t i_poolEntryBytes );
     ~RenderStorage() = default;
     
-    VertexPoolHandle allocateVertexBuffer( uint32_t i_size );
-    void deallocateVertexBuffer( const VertexPoolHandle &i_handle );
+    // The graphics pipeline's vertex input has to match
+    VertexEncoding getVertexEncoding() const;
+    
+    // Every layout has its own pool
+    VertexPoolHandle allocateVertexBuffer( const VertexLayout &i_layout, uint32_t i_size );
+    void deallocateVertexBuffer( const VertexLayout &i_layout, const VertexPoolHandle &i_handle );
+    
+    // One of every attribute, bound for the attributes a layout lacks
+    BufferTPtr< uint32_t > getDefaultAttributeBuffer() const;
     
     IndexPoolHandle allocateIndexBuffer( uint32_t i_size );
     void deallocateIndexBuffer( const IndexPoolHandle &i_handle );
     
-    void updateLOD( ObjectId i_id, uint32_t i_lodIndex, const Mesh &i_mesh );
-    const MeshLODs* getLODs( ObjectId i_id ) const;
+    // Geometry is created on the first update, io_handle then refers to it.
+    // Negative errors are estimated from the bounds and triangle count.
+    // Quantized positions are encoded against the dequantization, which is
+    // shared by every LOD of the geometry and folded into its transform.
+    // Clusters built ahead of time are used when meshlet clustering is on,
+    // otherwise they are built here. Only the attributes in the layout are
+    // uploaded, encoded straight into staging memory. Nothing is read once
+    // this returns.
+    void updateLOD( SlotHandle &io_handle, TransformSlot i_transformSlot, uint32_t i_lodIndex, const VertexLayout &i_layout, const VertexSource &i_vertices, MeshSpanT< uint32_t > i_indices, float i_error, const Vec4f &i_dequantization, const MeshletClusters* i_clusters = nullptr );
+    void removeGeometry( SlotHandle i_handle );
+    const MeshLODs* getLODs( SlotHandle i_handle ) const;
+    
+    // Densely packed, iterate directly
+    const MeshStorageMap & getGeometries() const;
+    
+    // Choose one LOD per geometry. Only the draws of geometries whose choice
+    // changed are uploaded, the others keep their instance counts.
+    void selectLODs( const TransformStore &i_transforms, const LODSelector &i_selector );
+    
+    // Draws outside the frustum get an instance count of zero. Only draws
+    // whose visibility flipped are uploaded, recorded frames stay valid.
+    void cull( const TransformStore &i_transforms, const Frustum &i_frustum );
+    const CullStats & getCullStats() const;
+    
+    // Keep every draw visible and upload the bounds and visible buffers the
+    // device culling pass needs, cull must not be called while enabled
+    void setGpuCulling( bool i_enabled );
+    bool getGpuCulling() const;
+    
+    // Draw each LOD as meshlets with their own bounds and normal cones. Only
+    // LODs uploaded afterwards are split, the host cull skips the cones.
+    void setMeshletClustering( bool i_enabled );
+    bool getMeshletClustering() const;
+    
+    // Store the attributes of each vertex together, or every attribute in a
+    // stream of its own. Only LODs uploaded afterwards change.
+    void setInterleavedVertices( bool i_enabled );
+    bool getInterleavedVertices() const;
     
-    std::vector< ObjectId > getGeometryIds() const;
+    // Upload the draws that changed since this frame's copy was last written
+    void updateIndirectBatches( uint32_t i_frame );
+    const IndirectBatches & getIndirectBatches() const;
     
-    BufferTPtr< VkDrawIndexedIndirectCommand > getIndirectBuffer() const;
+    // Upload the matrices written since this frame's copy was last updated.
+    // The buffer is replaced when it grows, which changes the revision. The
+    // device copy maps quantized positions, the host matrices do not.
+    void updateTransforms( TransformStore &io_transforms, uint32_t i_frame );
+    BufferTPtr< Mat4f > getTransformBuffer( uint32_t i_frame ) const;
+    
+    // Move a bounded number of live allocations out of sparse pool entries so
+    // the entries can be released. Copies run on the device, see recordMoves.
+    void defragment();
+    bool hasPendingMoves() const;
+    void recordMoves( VkCommandBuffer i_commandBuffer );
+    
+    // Changes whenever the set of draws or the buffers they use change
+    uint64_t getRevision() const;
+    
+    // Summed over the pools of every layout
+    BufferPoolStats getVertexPoolStats() const;
+    BufferPoolStats getIndexPoolStats() const;
 
 private:
     
-    BufferPoolT< std::byte > m_vertexPool;
+    void addDraw( SlotHandle i_handle, uint8_t i_lodIndex, MeshStorage &io_storage );
+    void removeDraw( MeshStorage &io_storage );
+    void markDirty( IndirectBatch &io_batch, uint32_t i_slot );
+    void setSelected( const MeshStorage &i_storage, bool i_selected );
+    void retireBuffers( const IndirectBatch &i_batch, uint32_t i_frame );
+    void setDequantization( TransformSlot i_slot, const Vec4f &i_dequantization );
+    Vec4f getDequantization( TransformSlot i_slot ) const;
+    BufferPoolT< uint32_t > & getVertexPool( const VertexLayout &i_layout );
+    void uploadVertices( const MeshStorage &i_storage, const VertexSource &i_vertices, const Vec4f &i_dequantization );
+    
+    struct PendingMove
+    {
+        VkBuffer srcBuffer;
+        VkBuffer dstBuffer;
+        VkBufferCopy region;
+    };
+    
+    DevicePtr m_device;
+    PhysicalDevicePtr m_physicalDevice;
+    uint32_t m_frameCount;
+    VertexEncoding m_vertexEncoding;
+    size_t m_poolEntryBytes;
+    
+    // Keyed by layout, created on first use and never released
+    std::map< uint8_t, std::unique_ptr< BufferPoolT< uint32_t > > > m_vertexPools;
+    BufferTPtr< uint32_t > m_defaultAttributes;
+    bool m_interleavedVertices = true;
     BufferPoolT< uint32_t > m_indexPool;
     
-    BufferTPtr< VkDrawIndexedIndirectCommand > m_indirectBuffer;
+    IndirectBatches m_indirectBatches;
+    
+    std::vector< BufferTPtr< Mat4f > > m_transformBuffers;
+    std::vector< std::pair< uint32_t, uint32_t > > m_transformDirtyRanges;
+    std::vector< Mat4f > m_transformScratch;
+    
+    // Per transform slot, only geometries with quantized positions differ from identity
+    std::vector< Vec4f > m_dequantization;
+    
+    // World space spheres of the batch being culled
+    std::array< std::vector< float >, 4 > m_cullSpheres;
+    std::vector< uint8_t > m_cullVisibility;
+    CullStats m_cullStats;
+    
+    bool m_gpuCulling = false;
+    std::vector< DrawBounds > m_boundsScratch;
+    
+    bool m_meshletClustering = false;
+
+    std::vector< PendingMove > m_pendingMoves;
+    uint64_t m_revision = 0;
     
-    std::unordered_map< ObjectId, MeshLODs > m_meshStorage;
+    MeshStorageMap m_meshStorage;
 };
 
 
@@ -10,18 +10,57 @@
 #include <marlin/scene/renderStorage.hpp>
 
 #include <marlin/vulkan/instance.hpp>
+#include <marlin/vulkan/jobSystem.hpp>
+#include <marlin/vulkan/taskQueue.hpp>
 
 #include <iostream>
-#include <set>
 
 namespace marlin
 {
 
+// Dirty objects handed to a thread at a time for preparation
+static const size_t s_prepareChunkSize = 16;
+
+void SceneMailbox::post( std::function< void () > i_completion )
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_completions.push_back( std::move( i_completion ) );
+}
+
+void SceneMailbox::drain()
+{
+    std::vector< std::function< void () > > completions;
+    
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        completions.swap( m_completions );
+    }
+    
+    // Completions may post again, those wait for the next drain
+    for ( std::function< void () > &completion : completions )
+    {
+        completion();
+    }
+}
+
 SceneObject::SceneObject( ScenePtr i_scene )
 : m_parentScene( i_scene )
 {
     static std::atomic< ObjectId > idCounter = 0;
     m_id = idCounter++;
+    
+    m_transformSlot = i_scene->getTransformStore().allocate();
+    i_scene->getTransformHierarchy().insert( m_transformSlot );
+}
+
+SceneObject::~SceneObject()
+{
+    ScenePtr scene = m_parentScene.lock();
+    if ( scene )
+    {
+        scene->getTransformHierarchy().erase( m_transformSlot );
+        scene->getTransformStore().free( m_transformSlot );
+    }
 }
 
 ObjectId SceneObject::getId() const
@@ -29,20 +68,40 @@ ObjectId SceneObject::getId() const
     return m_id;
 }
 
+TransformSlot SceneObject::getTransformSlot() const
+{
+    return m_transformSlot;
+}
+
 void SceneObject::setMatrix( const Mat4d &i_matrix )
 {
-    m_matrix = i_matrix;
+    ScenePtr scene = m_parentScene.lock();
+    scene->getTransformHierarchy().setLocal( m_transformSlot, Mat4f( i_matrix ) );
 }
 
 Mat4d SceneObject::getMatrix() const
 {
-    return m_matrix;
+    ScenePtr scene = m_parentScene.lock();
+    return Mat4d( scene->getTransformHierarchy().getLocal( m_transformSlot ) );
+}
+
+Mat4d SceneObject::getWorldMatrix() const
+{
+    ScenePtr scene = m_parentScene.lock();
+    return Mat4d( scene->getTransformStore().get( m_transformSlot ) );
+}
+
+void SceneObject::setParent( const SceneObjectPtr &i_parent )
+{
+    ScenePtr scene = m_parentScene.lock();
+    const TransformSlot parentSlot = i_parent ? i_parent->getTransformSlot() : s_invalidTransformSlot;
+    scene->getTransformHierarchy().setParent( m_transformSlot, parentSlot );
 }
 
 void SceneObject::setDirty()
 {
     ScenePtr scene = m_parentScene.lock();
-    scene->setDirty( m_id );
+    scene->setDirty( m_sceneHandle );
 }
 
 GeometryPtr Geometry::create( ScenePtr i_scene )
@@ -58,21 +117,219 @@ Geometry::Geometry( ScenePtr i_scene )
     {
         pair.second = true;
     }
+    
+    m_lodErrors.fill( s_estimateLODError );
+    m_lodBounds.fill( { Vec3f( s_InfinityFloat ), Vec3f( -s_InfinityFloat ) } );
 }
 
-void Geometry::setLOD( const Mesh &mesh, uint32_t lodIndex )
+void Geometry::setLOD( const Mesh &mesh, uint32_t lodIndex, float error )
+{
+    setLOD( Mesh( mesh ), lodIndex, error );
+}
+
+void Geometry::setLOD( Mesh &&mesh, uint32_t lodIndex, float error )
 {
     if ( lodIndex >= s_maxLODs )
     {
         std::cerr << "Warning: LOD index greater than max supported indices. Ignoring." << std::endl;
+        return;
     }
     
-    m_lods[ lodIndex ] = { mesh, true };
+    m_lods[ lodIndex ] = { std::move( mesh ), true };
+    m_lodErrors[ lodIndex ] = error;
+    m_released[ lodIndex ] = false;
+    m_compressed[ lodIndex ] = CompressedMesh();
+    m_lodGeneration++;
     
     // Mark ourselves as dirty
     setDirty();
 }
 
+bool Geometry::hasPendingUploads() const
+{
+    for ( const auto &pair : m_lods )
+    {
+        if ( pair.second )
+        {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void Geometry::setResidency( MeshResidency i_residency )
+{
+    m_residency = i_residency;
+}
+
+MeshResidency Geometry::getResidency() const
+{
+    return m_residency;
+}
+
+size_t Geometry::getResidentSize() const
+{
+    size_t size = 0;
+    for ( uint32_t i = 0; i < s_maxLODs; i++ )
+    {
+        size += m_lods[ i ].first.getOwnedSize() + m_compressed[ i ].getSize();
+    }
+    
+    return size;
+}
+
+void Geometry::generateLODs( const LODChainSettings &i_settings )
+{
+    // Views may be released before the task runs, it gets its own copy
+    const bool evicted = m_lods[ 0 ].first.getIndices().empty() && !m_compressed[ 0 ].empty();
+    const Mesh source = evicted ? decompressMesh( m_compressed[ 0 ] ) : m_lods[ 0 ].first.copyViews();
+    if ( source.getIndices().empty() )
+    {
+        std::cerr << "Warning: Generating LODs without a LOD 0 mesh. Ignoring." << std::endl;
+        return;
+    }
+    
+    // Generated errors are measured from LOD 0, so it is exact
+    if ( m_lodErrors[ 0 ] != 0.0f )
+    {
+        m_lodErrors[ 0 ] = 0.0f;
+        m_lods[ 0 ].second = true;
+        setDirty();
+    }
+    
+    const uint64_t generation = ++m_lodGeneration;
+    const uint32_t levelCount = std::min( i_settings.levelCount, s_maxLODs - 1 );
+    
+    LODChainSettings settings = i_settings;
+    settings.levelCount = levelCount;
+    
+    std::weak_ptr< SceneObject > self = weak_from_this();
+    SceneMailboxPtr mailbox = m_parentScene.lock()->getMailbox();
+    
+    // The source is captured by value, it may be replaced while the task runs
+    marlin::MlnInstance::getInstance().getTaskQueue().submit( [ source, settings, generation, self, mailbox ]() {
+        
+        std::vector< GeneratedLOD > lods = generateLODChain( source, settings );
+        
+        mailbox->post( [ lods = std::move( lods ), generation, levelCount = settings.levelCount, self ]() mutable {
+            
+            std::shared_ptr< Geometry > geometry = std::static_pointer_cast< Geometry >( self.lock() );
+            if ( !geometry || geometry->m_lodGeneration != generation )
+            {
+                return;
+            }
+            
+            // Levels simplification could not reach are cleared, not left stale
+            for ( uint32_t level = 0; level < levelCount; level++ )
+            {
+                const uint32_t lodIndex = level + 1;
+                geometry->m_released[ lodIndex ] = false;
+                geometry->m_compressed[ lodIndex ] = CompressedMesh();
+                if ( level < lods.size() )
+                {
+                    geometry->m_lods[ lodIndex ] = { std::move( lods[ level ].mesh ), true };
+                    geometry->m_lodErrors[ lodIndex ] = lods[ level ].error;
+                }
+                else
+                {
+                    geometry->m_lods[ lodIndex ] = { Mesh(), true };
+                    geometry->m_lodErrors[ lodIndex ] = s_estimateLODError;
+                }
+            }
+            
+            geometry->setDirty();
+        });
+    });
+}
+
+void Geometry::setIngestOptimization( bool i_enabled )
+{
+    if ( m_optimizeIngest == i_enabled )
+    {
+        return;
+    }
+    
+    m_optimizeIngest = i_enabled;
+    
+    // Released views can not be read again, those LODs stay as uploaded
+    for ( uint32_t i = 0; i < s_maxLODs; i++ )
+    {
+        m_lods[ i ].second = m_lods[ i ].second || !m_released[ i ];
+        m_ingestStats[ i ] = m_released[ i ] ? m_ingestStats[ i ] : IngestStats();
+    }
+    
+    setDirty();
+}
+
+const IngestStats & Geometry::getIngestStats( uint32_t i_lodIndex ) const
+{
+    return m_ingestStats[ i_lodIndex ];
+}
+
+void Geometry::prepare()
+{
+    restoreLODs();
+    
+    // New bounds dirty every LOD, evicted ones included
+    const RenderStorage &renderStorage = MlnInstance::getInstance().getRenderStorage();
+    if ( renderStorage.getVertexEncoding() == VertexEncoding::Quantized )
+    {
+        updateDequantization();
+        restoreLODs();
+    }
+    
+    for ( uint32_t i = 0; i < s_maxLODs; i++ )
+    {
+        const auto &pair = m_lods[ i ];
+        if ( !pair.second )
+        {
+            continue;
+        }
+        
+        // Without optimization the mesh streams are encoded where they are
+        if ( !m_optimizeIngest )
+        {
+            if ( renderStorage.getMeshletClustering() )
+            {
+                m_preparedClusters[ i ] = buildMeshlets( getVertexSource( pair.first ), pair.first.getIndices() );
+            }
+            
+            continue;
+        }
+        
+        const MeshSpanT< Vec3f > meshVertices = pair.first.getVertices();
+        const MeshSpanT< Vec3f > meshColors = pair.first.getColors();
+        const MeshSpanT< Vec3f > meshNormals = pair.first.getNormals();
+        const MeshSpanT< Vec2f > meshUVs = pair.first.getUVs();
+        
+        std::vector< Vertex > &vertices = m_preparedVertices[ i ];
+        vertices.resize( meshVertices.size() );
+        
+        // Missing attributes are not uploaded, the layout reads defaults instead
+        const bool hasColors = meshColors.size() == meshVertices.size();
+        const bool hasNormals = meshNormals.size() == meshVertices.size();
+        const bool hasUVs = meshUVs.size() == meshVertices.size();
+        for ( size_t j = 0; j < meshVertices.size(); j++ )
+        {
+            vertices[ j ].pos = meshVertices[ j ];
+            vertices[ j ].color = hasColors ? meshColors[ j ] : Vec3f( 1.0f );
+            vertices[ j ].normal = hasNormals ? meshNormals[ j ] : Vec3f( 0.0f );
+            vertices[ j ].uv = hasUVs ? meshUVs[ j ] : Vec2f( 0.0f );
+        }
+        
+        const MeshSpanT< uint32_t > meshIndices = pair.first.getIndices();
+        m_preparedIndices[ i ] = std::vector< uint32_t >( meshIndices.begin(), meshIndices.end() );
+        m_ingestStats[ i ] = optimizeMesh( vertices, m_preparedIndices[ i ] );
+        
+        // Clustered here so the storage does not build them on the main thread
+        if ( renderStorage.getMeshletClustering() )
+        {
+            m_preparedClusters[ i ] = buildMeshlets( getVertexSource( vertices ), m_preparedIndices[ i ] );
+        }
+    }
+}
+
 void Geometry::update( RenderStorage &i_renderStorage )
 {
     for ( uint32_t i = 0; i < s_maxLODs; i++ )
@@ -87,9 +344,121 @@ void Geometry::update( RenderStorage &i_renderStorage )
         
         // Update
         const Mesh &mesh = pair.first;
-        i_renderStorage.updateLOD( getId(), i, mesh );
+        const VertexSource vertices = m_optimizeIngest ? getVertexSource( m_preparedVertices[ i ] ) : getVertexSource( mesh );
+        const MeshSpanT< uint32_t > indices = m_optimizeIngest ? MeshSpanT< uint32_t >( m_preparedIndices[ i ] ) : mesh.getIndices();
+        const MeshletClusters* clusters = m_preparedClusters[ i ].meshlets.empty() ? nullptr : &m_preparedClusters[ i ];
+        const VertexLayout layout = getMeshLayout( mesh, i_renderStorage.getInterleavedVertices() );
+        i_renderStorage.updateLOD( m_storageHandle, getTransformSlot(), i, layout, vertices, indices, m_lodErrors[ i ], m_dequantization, clusters );
         
+        m_preparedVertices[ i ] = std::vector< Vertex >();
+        m_preparedIndices[ i ] = std::vector< uint32_t >();
+        m_preparedClusters[ i ] = MeshletClusters();
         pair.second = false;
+        
+        // The caller owns viewed data again once it is staged. Without a
+        // compressed copy a dropped LOD can not be uploaded again.
+        const bool compressed = !m_compressed[ i ].empty();
+        if ( compressed || m_residency == MeshResidency::Release || mesh.hasViews() )
+        {
+            m_released[ i ] = !compressed && !mesh.getVertices().empty();
+            pair.first = Mesh();
+        }
+    }
+}
+
+void Geometry::restoreLODs()
+{
+    for ( uint32_t i = 0; i < s_maxLODs; i++ )
+    {
+        auto &pair = m_lods[ i ];
+        const bool evicted = pair.first.getVertices().empty() && pair.first.getIndices().empty();
+        if ( !pair.second || m_compressed[ i ].empty() || !evicted )
+        {
+            continue;
+        }
+        
+        // Other policies hold on to the mesh from now on
+        pair.first = decompressMesh( m_compressed[ i ] );
+        if ( m_residency != MeshResidency::Compressed )
+        {
+            m_compressed[ i ] = CompressedMesh();
+        }
+    }
+    
+    // Compressed while the data is at hand, views included
+    if ( m_residency == MeshResidency::Compressed )
+    {
+        for ( uint32_t i = 0; i < s_maxLODs; i++ )
+        {
+            if ( m_lods[ i ].second && m_compressed[ i ].empty() )
+            {
+                m_compressed[ i ] = compressMesh( m_lods[ i ].first );
+            }
+        }
+    }
+}
+
+void Geometry::updateDequantization()
+{
+    for ( uint32_t i = 0; i < s_maxLODs; i++ )
+    {
+        if ( !m_lods[ i ].second )
+        {
+            continue;
+        }
+        
+        std::pair< Vec3f, Vec3f > &bounds = m_lodBounds[ i ];
+        bounds = { Vec3f( s_InfinityFloat ), Vec3f( -s_InfinityFloat ) };
+        for ( const Vec3f &vertex : m_lods[ i ].first.getVertices() )
+        {
+            bounds.first = glm::min( bounds.first, vertex );
+            bounds.second = glm::max( bounds.second, vertex );
+        }
+    }
+    
+    // Empty LODs keep inverted bounds and drop out of the union
+    Vec3f boundsMin( s_InfinityFloat );
+    Vec3f boundsMax( -s_InfinityFloat );
+    for ( const std::pair< Vec3f, Vec3f > &bounds : m_lodBounds )
+    {
+        boundsMin = glm::min( boundsMin, bounds.first );
+        boundsMax = glm::max( boundsMax, bounds.second );
+    }
+    
+    const Vec4f dequantization = boundsMin.x <= boundsMax.x ? computeDequantization( boundsMin, boundsMax ) : s_identityDequantization;
+    if ( dequantization == m_dequantization )
+    {
+        return;
+    }
+    
+    // Released LODs can not be encoded again, so the bounds stay as they
+    // were and LODs reaching outside them are clamped
+    for ( uint32_t i = 0; i < s_maxLODs; i++ )
+    {
+        if ( m_released[ i ] )
+        {
+            return;
+        }
+    }
+    
+    // Every LOD shares the transform the bounds are folded into, encode them all again
+    m_dequantization = dequantization;
+    for ( auto &pair : m_lods )
+    {
+        pair.second = true;
+    }
+}
+
+void Geometry::remove( RenderStorage &i_renderStorage )
+{
+    i_renderStorage.removeGeometry( m_storageHandle );
+    m_storageHandle = s_invalidSlotHandle;
+    
+    // Everything has to be uploaded again if we are added back, released
+    // views have to be set again
+    for ( uint32_t i = 0; i < s_maxLODs; i++ )
+    {
+        m_lods[ i ].second = !m_released[ i ];
     }
 }
 
@@ -100,47 +469,120 @@ ScenePtr Scene::create()
 
 void Scene::addObject( SceneObjectPtr object )
 {
-    ObjectId objectId = object->getId();
-    m_objects[ objectId ] = object;
-    m_dirtyList.push_back( objectId );
+    if ( !m_objects.contains( object->m_sceneHandle ) )
+    {
+        object->m_sceneHandle = m_objects.insert( object );
+    }
+    
+    setDirty( object->m_sceneHandle );
 }
 
 void Scene::removeObject( SceneObjectPtr object )
 {
-    m_objects.erase( object->getId() );
+    if ( !m_objects.contains( object->m_sceneHandle ) )
+    {
+        return;
+    }
+    
+    RenderStorage &storage = marlin::MlnInstance::getInstance().getRenderStorage();
+    object->remove( storage );
+    
+    m_objects.erase( object->m_sceneHandle );
+    object->m_sceneHandle = s_invalidSlotHandle;
+    
+    // Its queued handle is stale now, adding it back has to queue again
+    object->m_dirtyEpoch = 0;
+    bumpRevision();
 }
 
 void Scene::update()
 {
-    std::set< ObjectId > processed;
-    for ( ObjectId id : m_dirtyList )
-    {
-        // Check that our object hasn't been deleted
-        const auto itr = m_objects.find( id );
-        if ( itr == m_objects.end() )
+    // Finished background work may dirty objects
+    m_mailbox->drain();
+    
+    JobSystem &jobSystem = marlin::MlnInstance::getInstance().getJobSystem();
+    
+    // CPU side work for distinct objects is independent. Handles go stale
+    // once the object has been removed.
+    jobSystem.parallelFor( m_dirtyList.size(), s_prepareChunkSize, [ this ]( uint32_t, size_t, size_t i_begin, size_t i_end ) {
+        for ( size_t i = i_begin; i < i_end; i++ )
         {
-            continue;
+            const SceneObjectPtr* object = m_objects.find( m_dirtyList[ i ] );
+            if ( object )
+            {
+                ( *object )->prepare();
+            }
         }
-        
-        // Check that our object hasn't already been processed
-        const auto pair = processed.insert( id );
-        if ( !pair.second )
+    });
+    
+    // Pool allocations, uploads and draw changes share state
+    RenderStorage &storage = marlin::MlnInstance::getInstance().getRenderStorage();
+    for ( SlotHandle handle : m_dirtyList )
+    {
+        SceneObjectPtr* object = m_objects.find( handle );
+        if ( object )
         {
-            continue;
+            ( *object )->update( storage );
         }
-        
-        SceneObjectPtr object = itr->second;
-        
-        RenderStorage &storage = marlin::MlnInstance::getInstance().getRenderStorage();
-        object->update( storage );
     }
     
     m_dirtyList.clear();
+    m_updateEpoch++;
+    
+    // Each depth runs across the worker threads
+    m_hierarchy.update( m_transforms, jobSystem );
+}
+
+void Scene::setDirty( SlotHandle i_handle )
+{
+    // Objects that are not added yet are queued by addObject
+    SceneObjectPtr* object = m_objects.find( i_handle );
+    if ( !object || ( *object )->m_dirtyEpoch == m_updateEpoch )
+    {
+        return;
+    }
+    
+    ( *object )->m_dirtyEpoch = m_updateEpoch;
+    m_dirtyList.push_back( i_handle );
+    bumpRevision();
+}
+
+uint64_t Scene::getRevision() const
+{
+    return m_revision;
+}
+
+TransformStore & Scene::getTransformStore()
+{
+    return m_transforms;
+}
+
+TransformHierarchy & Scene::getTransformHierarchy()
+{
+    return m_hierarchy;
+}
+
+SceneMailboxPtr Scene::getMailbox() const
+{
+    return m_mailbox;
+}
+
+void Scene::setLODBias( float i_bias )
+{
+    // Selection only changes uploaded instance counts, recorded frames stay valid
+    m_lodBias = i_bias;
+}
+
+float Scene::getLODBias() const
+{
+    return m_lodBias;
 }
 
-void Scene::setDirty( ObjectId id )
+void Scene::bumpRevision()
 {
-    m_dirtyList.push_back( id );
+    // Shared counter, so a different scene never matches a cached revision
+    static std::atomic< uint64_t > revisionCounter = 0;
+    m_revision = ++revisionCounter;
 }
 
 } // namespace marlin
@@ -10,10 +10,21 @@
 #define MARLIN_SCENE_HPP
 
 #include <marlin/vulkan/../defs.hpp>
+#include <marlin/scene/lodGenerator.hpp>
+#include <marlin/scene/lodSelector.hpp>
 #include <marlin/scene/mesh.hpp>
+#include <marlin/scene/meshCompression.hpp>
+#include <marlin/scene/meshIngest.hpp>
+#include <marlin/scene/meshlets.hpp>
+#include <marlin/scene/slotMap.hpp>
+#include <marlin/scene/transformHierarchy.hpp>
+#include <marlin/scene/transformStore.hpp>
+#include <marlin/scene/vertexEncoding.hpp>
+#include <marlin/vulkan/pipeline.hpp>
 
 #include <array>
-#include <unordered_map>
+#include <functional>
+#include <mutex>
 
 namespace marlin
 {
@@ -30,31 +41,64 @@ class RenderStorage;
 
 using ObjectId = uint64_t;
 
-class SceneObject
+// Work finished on other threads is posted here and runs on the thread
+// calling Scene::update, where objects may be edited again
+class SceneMailbox
+{
+public:
+    
+    void post( std::function< void () > i_completion );
+    void drain();
+    
+private:
+    
+    std::mutex m_mutex;
+    std::vector< std::function< void () > > m_completions;
+};
+
+using SceneMailboxPtr = std::shared_ptr< SceneMailbox >;
+
+class SceneObject : public std::enable_shared_from_this< SceneObject >
 {
     friend class Scene;
     
 public:
     
     explicit SceneObject( ScenePtr i_scene );
-    ~SceneObject() = default;
+    virtual ~SceneObject();
     
     ObjectId getId() const;
+    TransformSlot getTransformSlot() const;
     
+    // Relative to the parent, world matrices are resolved by Scene::update
     void setMatrix( const Mat4d &i_matrix );
     Mat4d getMatrix() const;
+    Mat4d getWorldMatrix() const;
+    
+    // Both objects must belong to the same scene, nullptr detaches
+    void setParent( const SceneObjectPtr &i_parent );
     
 protected:
     
     std::weak_ptr< Scene > m_parentScene;
     
+    // Runs on a worker thread alongside other objects, may only touch this
+    // object. Anything shared belongs in update, which runs serially after.
+    virtual void prepare() {}
     virtual void update( RenderStorage &i_renderStorage ) = 0;
+    virtual void remove( RenderStorage &i_renderStorage ) = 0;
     void setDirty();
 
 private:
         
     ObjectId m_id;
-    Mat4d m_matrix;
+    TransformSlot m_transformSlot;
+    
+    // Where the scene keeps us, invalid until added
+    SlotHandle m_sceneHandle = s_invalidSlotHandle;
+    
+    // Scene update epoch we were queued in, queueing twice is a no-op
+    uint64_t m_dirtyEpoch = 0;
 };
 
 class Geometry;
@@ -69,16 +113,79 @@ public:
     explicit Geometry( ScenePtr i_scene );
     ~Geometry() = default;
     
-    void setLOD( const Mesh &mesh, uint32_t lodIndex );
+    // Error is the object space distance between this LOD and the full
+    // detail surface, LOD selection estimates it when negative. Streams the
+    // mesh views are read straight into staging memory by the next
+    // Scene::update and dropped afterwards, see hasPendingUploads. Such LODs
+    // are not uploaded again, set them again after removing the geometry.
+    void setLOD( const Mesh &mesh, uint32_t lodIndex, float error = s_estimateLODError );
+    void setLOD( Mesh &&mesh, uint32_t lodIndex, float error = s_estimateLODError );
+    
+    // Some LOD has not been uploaded yet, viewed data must stay alive until then
+    bool hasPendingUploads() const;
+    
+    // What is kept on the host after each upload, Keep by default. Applies
+    // to LODs uploaded afterwards. Viewed meshes are never kept, only
+    // compressed or released.
+    void setResidency( MeshResidency i_residency );
+    MeshResidency getResidency() const;
+    
+    // Host memory held for our LODs, meshes and compressed copies
+    size_t getResidentSize() const;
+    
+    // Simplify LOD 0 into the following LODs on a background thread. They
+    // are filled in by a later Scene::update, until then the current ones
+    // are drawn. Setting any LOD in the meantime discards the result.
+    void generateLODs( const LODChainSettings &i_settings = LODChainSettings() );
+    
+    // Reorder and deduplicate every LOD before upload, see optimizeMesh. Off
+    // by default, changing it uploads the LODs again.
+    void setIngestOptimization( bool i_enabled );
+    const IngestStats & getIngestStats( uint32_t i_lodIndex ) const;
     
 protected:
     
+    void prepare() override;
     void update( RenderStorage &i_renderStorage ) override;
+    void remove( RenderStorage &i_renderStorage ) override;
     
 private:
     
+    // Bring back dirty LODs that were evicted to a compressed copy, and
+    // compress the dirty LODs that need one
+    void restoreLODs();
+    
+    // Quantized positions are encoded against the bounds of every LOD
+    void updateDequantization();
+    
     // LOD array of mesh and dirty states
     std::array< std::pair< Mesh, bool >, s_maxLODs > m_lods;
+    std::array< float, s_maxLODs > m_lodErrors;
+    
+    // LODs whose meshes were dropped once uploaded, without a compressed copy
+    std::array< bool, s_maxLODs > m_released {};
+    
+    // Replaces the mesh once uploaded with Compressed residency
+    std::array< CompressedMesh, s_maxLODs > m_compressed;
+    MeshResidency m_residency = MeshResidency::Keep;
+    
+    // Interleaved by prepare for the dirty LODs that are optimized, released
+    // once uploaded. Other LODs are encoded from their mesh streams.
+    std::array< std::vector< Vertex >, s_maxLODs > m_preparedVertices;
+    std::array< std::vector< uint32_t >, s_maxLODs > m_preparedIndices;
+    std::array< MeshletClusters, s_maxLODs > m_preparedClusters;
+    
+    std::array< std::pair< Vec3f, Vec3f >, s_maxLODs > m_lodBounds;
+    Vec4f m_dequantization = s_identityDequantization;
+    
+    bool m_optimizeIngest = false;
+    std::array< IngestStats, s_maxLODs > m_ingestStats;
+    
+    // Our entry in the render storage, created by the first update
+    SlotHandle m_storageHandle = s_invalidSlotHandle;
+    
+    // Only the latest generation request may fill in LODs
+    uint64_t m_lodGeneration = 0;
 };
 
 class Scene
@@ -90,12 +197,37 @@ public:
     void addObject( SceneObjectPtr object );
     void removeObject( SceneObjectPtr object );
     void update();
-    void setDirty( ObjectId id );
+    void setDirty( SlotHandle i_handle );
+    
+    // Changes on every edit, unique across scenes
+    uint64_t getRevision() const;
+    
+    TransformStore & getTransformStore();
+    TransformHierarchy & getTransformHierarchy();
+    
+    // Shared so background work can outlive the scene
+    SceneMailboxPtr getMailbox() const;
+    
+    // Scales the on screen error LODs may show, above one favours coarser LODs
+    void setLODBias( float i_bias );
+    float getLODBias() const;
     
 private:
+    
+    void bumpRevision();
         
-    std::unordered_map< ObjectId, SceneObjectPtr > m_objects;
-    std::vector< ObjectId > m_dirtyList;
+    SlotMapT< SceneObjectPtr > m_objects;
+    // At most one entry per object and epoch
+    std::vector< SlotHandle > m_dirtyList;
+    uint64_t m_updateEpoch = 1;
+    uint64_t m_revision = 0;
+    
+    TransformStore m_transforms;
+    TransformHierarchy m_hierarchy;
+    
+    float m_lodBias = 1.0f;
+    
+    SceneMailboxPtr m_mailbox = std::make_shared< SceneMailbox >();
 };
 
 } // namespace marlin
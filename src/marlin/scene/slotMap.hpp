@@ -0,0 +1,79 @@
+//
+//  slotMap.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_SLOTMAP_HPP
+#define MARLIN_SLOTMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace marlin
+{
+
+// Slot index in the low bits, generation in the high bits. Generations
+// start at one so a zero handle never refers to anything.
+using SlotHandle = uint64_t;
+
+static const SlotHandle s_invalidSlotHandle = 0;
+
+// Values packed densely for iteration, handles stay valid until the value
+// is erased and go stale afterwards even if the slot is reused
+template < class T >
+class SlotMapT
+{
+public:
+
+    SlotHandle insert( T i_value );
+
+    // Stale handles are ignored
+    bool erase( SlotHandle i_handle );
+
+    T* find( SlotHandle i_handle );
+    const T* find( SlotHandle i_handle ) const;
+    bool contains( SlotHandle i_handle ) const;
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+
+    // Dense order, changes when values are erased
+    T* begin();
+    T* end();
+    const T* begin() const;
+    const T* end() const;
+
+    T & getValue( size_t i_denseIndex );
+    SlotHandle getHandle( size_t i_denseIndex ) const;
+
+    // Generation a slot moves to once its value is erased, never zero
+    static uint32_t nextGeneration( uint32_t i_generation );
+
+private:
+
+    struct Slot
+    {
+        uint32_t denseIndex;
+        uint32_t generation;
+    };
+
+    static SlotHandle makeHandle( uint32_t i_index, uint32_t i_generation );
+    const Slot* findSlot( SlotHandle i_handle ) const;
+
+    std::vector< T > m_values;
+    std::vector< uint32_t > m_denseToSlot;
+
+    std::vector< Slot > m_slots;
+    std::vector< uint32_t > m_freeSlots;
+};
+
+} // namespace marlin
+
+#include "slotMap.tpp"
+
+#endif /* MARLIN_SLOTMAP_HPP */
@@ -0,0 +1,182 @@
+//
+//  slotMap.tpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/slotMap.hpp>
+
+#include <utility>
+
+namespace marlin
+{
+
+template < class T >
+SlotHandle SlotMapT< T >::insert( T i_value )
+{
+    uint32_t index;
+    if ( !m_freeSlots.empty() )
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        index = static_cast< uint32_t >( m_slots.size() );
+        m_slots.push_back( { 0, 1 } );
+    }
+
+    Slot &slot = m_slots[ index ];
+    slot.denseIndex = static_cast< uint32_t >( m_values.size() );
+
+    m_values.push_back( std::move( i_value ) );
+    m_denseToSlot.push_back( index );
+
+    return makeHandle( index, slot.generation );
+}
+
+template < class T >
+bool SlotMapT< T >::erase( SlotHandle i_handle )
+{
+    const Slot* found = findSlot( i_handle );
+    if ( !found )
+    {
+        return false;
+    }
+
+    const uint32_t index = static_cast< uint32_t >( i_handle );
+    const uint32_t denseIndex = found->denseIndex;
+    const uint32_t lastIndex = static_cast< uint32_t >( m_values.size() - 1 );
+
+    // Move the last value into the hole so the values stay packed
+    if ( denseIndex != lastIndex )
+    {
+        m_values[ denseIndex ] = std::move( m_values[ lastIndex ] );
+        m_denseToSlot[ denseIndex ] = m_denseToSlot[ lastIndex ];
+        m_slots[ m_denseToSlot[ denseIndex ] ].denseIndex = denseIndex;
+    }
+
+    m_values.pop_back();
+    m_denseToSlot.pop_back();
+
+    Slot &slot = m_slots[ index ];
+    slot.generation = nextGeneration( slot.generation );
+    m_freeSlots.push_back( index );
+
+    return true;
+}
+
+template < class T >
+T* SlotMapT< T >::find( SlotHandle i_handle )
+{
+    const Slot* slot = findSlot( i_handle );
+    return slot ? &m_values[ slot->denseIndex ] : nullptr;
+}
+
+template < class T >
+const T* SlotMapT< T >::find( SlotHandle i_handle ) const
+{
+    const Slot* slot = findSlot( i_handle );
+    return slot ? &m_values[ slot->denseIndex ] : nullptr;
+}
+
+template < class T >
+bool SlotMapT< T >::contains( SlotHandle i_handle ) const
+{
+    return findSlot( i_handle ) != nullptr;
+}
+
+template < class T >
+size_t SlotMapT< T >::size() const
+{
+    return m_values.size();
+}
+
+template < class T >
+bool SlotMapT< T >::empty() const
+{
+    return m_values.empty();
+}
+
+template < class T >
+void SlotMapT< T >::clear()
+{
+    // Every live handle goes stale
+    for ( uint32_t index : m_denseToSlot )
+    {
+        Slot &slot = m_slots[ index ];
+        slot.generation = nextGeneration( slot.generation );
+        m_freeSlots.push_back( index );
+    }
+
+    m_values.clear();
+    m_denseToSlot.clear();
+}
+
+template < class T >
+T* SlotMapT< T >::begin()
+{
+    return m_values.data();
+}
+
+template < class T >
+T* SlotMapT< T >::end()
+{
+    return m_values.data() + m_values.size();
+}
+
+template < class T >
+const T* SlotMapT< T >::begin() const
+{
+    return m_values.data();
+}
+
+template < class T >
+const T* SlotMapT< T >::end() const
+{
+    return m_values.data() + m_values.size();
+}
+
+template < class T >
+T & SlotMapT< T >::getValue( size_t i_denseIndex )
+{
+    return m_values[ i_denseIndex ];
+}
+
+template < class T >
+SlotHandle SlotMapT< T >::getHandle( size_t i_denseIndex ) const
+{
+    const uint32_t index = m_denseToSlot[ i_denseIndex ];
+    return makeHandle( index, m_slots[ index ].generation );
+}
+
+template < class T >
+uint32_t SlotMapT< T >::nextGeneration( uint32_t i_generation )
+{
+    // Skip zero on wrap around so the handle can never become invalid
+    return i_generation == UINT32_MAX ? 1 : i_generation + 1;
+}
+
+template < class T >
+SlotHandle SlotMapT< T >::makeHandle( uint32_t i_index, uint32_t i_generation )
+{
+    return ( static_cast< SlotHandle >( i_generation ) << 32 ) | i_index;
+}
+
+template < class T >
+const typename SlotMapT< T >::Slot* SlotMapT< T >::findSlot( SlotHandle i_handle ) const
+{
+    const uint32_t index = static_cast< uint32_t >( i_handle );
+    const uint32_t generation = static_cast< uint32_t >( i_handle >> 32 );
+
+    if ( index >= m_slots.size() || m_slots[ index ].generation != generation )
+    {
+        return nullptr;
+    }
+
+    return &m_slots[ index ];
+}
+
+} // namespace marlin
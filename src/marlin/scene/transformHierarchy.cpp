@@ -0,0 +1,291 @@
+//
+//  transformHierarchy.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/transformHierarchy.hpp>
+
+#include <marlin/vulkan/jobSystem.hpp>
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Weverything"
+#include <glm/gtc/type_ptr.hpp>
+#pragma clang diagnostic pop
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+namespace marlin
+{
+
+// Nodes of one level handed to a thread at a time
+static const size_t s_propagateChunkSize = 1024;
+
+// o_result = i_lhs * i_rhs, each result column is the lhs columns scaled by
+// the rhs column and summed
+static inline void multiply( const Mat4f &i_lhs, const Mat4f &i_rhs, Mat4f &o_result )
+{
+    // Column major, so the float arrays are four columns back to back
+    Float4 lhs[ 4 ];
+    std::memcpy( lhs, glm::value_ptr( i_lhs ), sizeof( lhs ) );
+    float* result = glm::value_ptr( o_result );
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        const Vec4f &column = i_rhs[ i ];
+        const Float4 sum = lhs[ 0 ] * column.x + lhs[ 1 ] * column.y + lhs[ 2 ] * column.z + lhs[ 3 ] * column.w;
+        std::memcpy( result + i * 4, &sum, sizeof( sum ) );
+    }
+}
+
+void TransformHierarchy::insert( TransformSlot i_slot )
+{
+    if ( i_slot >= m_parents.size() )
+    {
+        m_parents.resize( i_slot + 1, s_invalidTransformSlot );
+        m_childCounts.resize( i_slot + 1, 0 );
+        m_locations.resize( i_slot + 1, { s_invalidIndex, s_invalidIndex } );
+    }
+
+    m_parents[ i_slot ] = s_invalidTransformSlot;
+    m_childCounts[ i_slot ] = 0;
+
+    // Roots can go on the end of the first level without a rebuild
+    append( 0, i_slot, s_invalidIndex, Mat4f( 1.0f ) );
+}
+
+void TransformHierarchy::erase( TransformSlot i_slot )
+{
+    const Location location = m_locations[ i_slot ];
+    m_levels[ location.depth ].slots[ location.index ] = s_invalidTransformSlot;
+    m_locations[ i_slot ] = { s_invalidIndex, s_invalidIndex };
+
+    const TransformSlot parent = m_parents[ i_slot ];
+    if ( parent != s_invalidTransformSlot )
+    {
+        m_childCounts[ parent ]--;
+    }
+
+    if ( m_childCounts[ i_slot ] > 0 )
+    {
+        std::replace( m_parents.begin(), m_parents.end(), i_slot, s_invalidTransformSlot );
+        m_childCounts[ i_slot ] = 0;
+    }
+
+    m_parents[ i_slot ] = s_invalidTransformSlot;
+    m_layoutDirty = true;
+}
+
+void TransformHierarchy::setParent( TransformSlot i_slot, TransformSlot i_parent )
+{
+    const TransformSlot oldParent = m_parents[ i_slot ];
+    if ( oldParent == i_parent )
+    {
+        return;
+    }
+
+    for ( TransformSlot ancestor = i_parent; ancestor != s_invalidTransformSlot; ancestor = m_parents[ ancestor ] )
+    {
+        if ( ancestor == i_slot )
+        {
+            throw std::runtime_error( "Error: Transform parent would create a cycle." );
+        }
+    }
+
+    if ( oldParent != s_invalidTransformSlot )
+    {
+        m_childCounts[ oldParent ]--;
+    }
+
+    if ( i_parent != s_invalidTransformSlot )
+    {
+        m_childCounts[ i_parent ]++;
+    }
+
+    m_parents[ i_slot ] = i_parent;
+    m_layoutDirty = true;
+}
+
+TransformSlot TransformHierarchy::getParent( TransformSlot i_slot ) const
+{
+    return m_parents[ i_slot ];
+}
+
+void TransformHierarchy::setLocal( TransformSlot i_slot, const Mat4f &i_matrix )
+{
+    const Location location = m_locations[ i_slot ];
+    Level &level = m_levels[ location.depth ];
+
+    level.locals[ location.index ] = i_matrix;
+    level.dirty[ location.index ] = 1;
+    level.hasDirty = true;
+}
+
+const Mat4f & TransformHierarchy::getLocal( TransformSlot i_slot ) const
+{
+    const Location location = m_locations[ i_slot ];
+    return m_levels[ location.depth ].locals[ location.index ];
+}
+
+void TransformHierarchy::update( TransformStore &io_transforms, JobSystem &i_jobSystem )
+{
+    if ( m_layoutDirty )
+    {
+        rebuild();
+    }
+
+    for ( size_t depth = 0; depth < m_levels.size(); depth++ )
+    {
+        Level &level = m_levels[ depth ];
+        const Level* parentLevel = depth > 0 ? &m_levels[ depth - 1 ] : nullptr;
+
+        // Nothing edited here and nothing moved above, the whole level is clean
+        const bool parentChanged = parentLevel && parentLevel->hasChanged;
+        if ( !level.hasDirty && !parentChanged )
+        {
+            level.hasChanged = false;
+            continue;
+        }
+
+        const size_t count = level.slots.size();
+        m_chunkRanges.assign( ( count + s_propagateChunkSize - 1 ) / s_propagateChunkSize, { UINT32_MAX, 0 } );
+
+        std::atomic< bool > levelChanged { false };
+
+        i_jobSystem.parallelFor( count, s_propagateChunkSize, [ & ]( uint32_t, size_t i_chunkIndex, size_t i_begin, size_t i_end ) {
+
+            std::pair< uint32_t, uint32_t > written { UINT32_MAX, 0 };
+
+            for ( size_t i = i_begin; i < i_end; i++ )
+            {
+                const bool changed = level.dirty[ i ] || ( parentChanged && parentLevel->changed[ level.parents[ i ] ] );
+                level.changed[ i ] = changed;
+                level.dirty[ i ] = 0;
+
+                if ( !changed )
+                {
+                    continue;
+                }
+
+                if ( parentLevel )
+                {
+                    multiply( parentLevel->worlds[ level.parents[ i ] ], level.locals[ i ], level.worlds[ i ] );
+                }
+                else
+                {
+                    level.worlds[ i ] = level.locals[ i ];
+                }
+
+                const TransformSlot slot = level.slots[ i ];
+                io_transforms.write( slot, level.worlds[ i ] );
+
+                written.first = std::min( written.first, slot );
+                written.second = std::max( written.second, slot + 1 );
+            }
+
+            m_chunkRanges[ i_chunkIndex ] = written;
+            if ( written.first < written.second )
+            {
+                levelChanged.store( true, std::memory_order_relaxed );
+            }
+        });
+
+        level.hasDirty = false;
+        level.hasChanged = levelChanged.load( std::memory_order_relaxed );
+
+        for ( const std::pair< uint32_t, uint32_t > &written : m_chunkRanges )
+        {
+            io_transforms.markDirty( written.first, written.second );
+        }
+    }
+}
+
+void TransformHierarchy::rebuild()
+{
+    const size_t slotCount = m_parents.size();
+
+    // Keep the local matrices of every live node across the new layout
+    std::vector< Mat4f > locals( slotCount );
+    std::vector< TransformSlot > roots;
+    for ( TransformSlot slot = 0; slot < slotCount; slot++ )
+    {
+        const Location location = m_locations[ slot ];
+        if ( location.depth == s_invalidIndex )
+        {
+            continue;
+        }
+
+        locals[ slot ] = m_levels[ location.depth ].locals[ location.index ];
+        if ( m_parents[ slot ] == s_invalidTransformSlot )
+        {
+            roots.push_back( slot );
+        }
+    }
+
+    // Children of every slot packed together, offsets from the child counts
+    std::vector< uint32_t > childOffsets( slotCount + 1, 0 );
+    for ( TransformSlot slot = 0; slot < slotCount; slot++ )
+    {
+        childOffsets[ slot + 1 ] = childOffsets[ slot ] + m_childCounts[ slot ];
+    }
+
+    std::vector< TransformSlot > children( childOffsets[ slotCount ] );
+    std::vector< uint32_t > childCursors( childOffsets.begin(), childOffsets.end() - 1 );
+    for ( TransformSlot slot = 0; slot < slotCount; slot++ )
+    {
+        const TransformSlot parent = m_parents[ slot ];
+        if ( parent != s_invalidTransformSlot && m_locations[ slot ].depth != s_invalidIndex )
+        {
+            children[ childCursors[ parent ]++ ] = slot;
+        }
+    }
+
+    m_levels.clear();
+
+    for ( TransformSlot root : roots )
+    {
+        append( 0, root, s_invalidIndex, locals[ root ] );
+    }
+
+    // Breadth first, a level is complete before the next one is filled
+    for ( uint32_t depth = 0; depth < m_levels.size(); depth++ )
+    {
+        for ( uint32_t i = 0; i < m_levels[ depth ].slots.size(); i++ )
+        {
+            const TransformSlot slot = m_levels[ depth ].slots[ i ];
+            for ( uint32_t child = childOffsets[ slot ]; child < childOffsets[ slot + 1 ]; child++ )
+            {
+                append( depth + 1, children[ child ], i, locals[ children[ child ] ] );
+            }
+        }
+    }
+
+    m_layoutDirty = false;
+}
+
+void TransformHierarchy::append( uint32_t i_depth, TransformSlot i_slot, uint32_t i_parent, const Mat4f &i_local )
+{
+    if ( i_depth >= m_levels.size() )
+    {
+        m_levels.resize( i_depth + 1 );
+    }
+
+    Level &level = m_levels[ i_depth ];
+    m_locations[ i_slot ] = { i_depth, static_cast< uint32_t >( level.slots.size() ) };
+
+    // Everything new is written once, moved nodes may have a new parent
+    level.slots.push_back( i_slot );
+    level.parents.push_back( i_parent );
+    level.locals.push_back( i_local );
+    level.worlds.push_back( i_local );
+    level.dirty.push_back( 1 );
+    level.changed.push_back( 0 );
+    level.hasDirty = true;
+}
+
+} // namespace marlin
@@ -0,0 +1,92 @@
+//
+//  transformHierarchy.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_TRANSFORMHIERARCHY_HPP
+#define MARLIN_TRANSFORMHIERARCHY_HPP
+
+#include <marlin/scene/transformStore.hpp>
+
+#include <vector>
+
+namespace marlin
+{
+
+class JobSystem;
+
+// Parent links between transform slots. Nodes are laid out breadth first,
+// one set of flat arrays per depth, so a level only reads the level above
+// it and every node in a level can be computed independently.
+class TransformHierarchy
+{
+public:
+
+    // New nodes are roots with an identity local matrix
+    void insert( TransformSlot i_slot );
+
+    // Children of an erased node become roots
+    void erase( TransformSlot i_slot );
+
+    // Pass s_invalidTransformSlot to make the node a root
+    void setParent( TransformSlot i_slot, TransformSlot i_parent );
+    TransformSlot getParent( TransformSlot i_slot ) const;
+
+    void setLocal( TransformSlot i_slot, const Mat4f &i_matrix );
+    const Mat4f & getLocal( TransformSlot i_slot ) const;
+
+    // Recompute the world matrix of every node under an edited node and
+    // write it to the store, one depth at a time across the job system
+    void update( TransformStore &io_transforms, JobSystem &i_jobSystem );
+
+private:
+
+    struct Level
+    {
+        std::vector< TransformSlot > slots;
+
+        // Index of the parent in the level above, unused for roots
+        std::vector< uint32_t > parents;
+
+        std::vector< Mat4f > locals;
+        std::vector< Mat4f > worlds;
+
+        // Local matrix edited, and world recomputed by the last update
+        std::vector< uint8_t > dirty;
+        std::vector< uint8_t > changed;
+
+        bool hasDirty = false;
+        bool hasChanged = false;
+    };
+
+    struct Location
+    {
+        uint32_t depth;
+        uint32_t index;
+    };
+
+    static const uint32_t s_invalidIndex = UINT32_MAX;
+
+    void rebuild();
+    void append( uint32_t i_depth, TransformSlot i_slot, uint32_t i_parent, const Mat4f &i_local );
+
+    std::vector< Level > m_levels;
+
+    // Indexed by slot
+    std::vector< TransformSlot > m_parents;
+    std::vector< uint32_t > m_childCounts;
+    std::vector< Location > m_locations;
+
+    // Parent links changed, levels are rebuilt before the next update
+    bool m_layoutDirty = false;
+
+    // Scratch for the per chunk slot ranges written to the store
+    std::vector< std::pair< uint32_t, uint32_t > > m_chunkRanges;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_TRANSFORMHIERARCHY_HPP */
@@ -0,0 +1,96 @@
+//
+//  transformStore.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/transformStore.hpp>
+
+#include <algorithm>
+
+namespace marlin
+{
+
+TransformSlot TransformStore::allocate()
+{
+    TransformSlot slot;
+    if ( !m_freeSlots.empty() )
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = getSize();
+        for ( std::vector< Vec4f > &column : m_columns )
+        {
+            column.emplace_back();
+        }
+    }
+    
+    set( slot, Mat4f( 1.0f ) );
+    return slot;
+}
+
+void TransformStore::free( TransformSlot i_slot )
+{
+    m_freeSlots.push_back( i_slot );
+}
+
+void TransformStore::set( TransformSlot i_slot, const Mat4f &i_matrix )
+{
+    write( i_slot, i_matrix );
+    markDirty( i_slot, i_slot + 1 );
+}
+
+void TransformStore::write( TransformSlot i_slot, const Mat4f &i_matrix )
+{
+    for ( uint32_t i = 0; i < 4; i++ )
+    {
+        m_columns[ i ][ i_slot ] = i_matrix[ i ];
+    }
+}
+
+Mat4f TransformStore::get( TransformSlot i_slot ) const
+{
+    return Mat4f( m_columns[ 0 ][ i_slot ], m_columns[ 1 ][ i_slot ], m_columns[ 2 ][ i_slot ], m_columns[ 3 ][ i_slot ] );
+}
+
+uint32_t TransformStore::getSize() const
+{
+    return static_cast< uint32_t >( m_columns[ 0 ].size() );
+}
+
+void TransformStore::gather( uint32_t i_begin, uint32_t i_end, Mat4f* o_matrices ) const
+{
+    for ( uint32_t i = 0; i < 4; i++ )
+    {
+        const Vec4f* column = m_columns[ i ].data();
+        for ( uint32_t slot = i_begin; slot < i_end; slot++ )
+        {
+            o_matrices[ slot - i_begin ][ i ] = column[ slot ];
+        }
+    }
+}
+
+std::pair< uint32_t, uint32_t > TransformStore::takeDirtyRange()
+{
+    const std::pair< uint32_t, uint32_t > dirtyRange = m_dirtyRange;
+    m_dirtyRange = { UINT32_MAX, 0 };
+    return dirtyRange;
+}
+
+void TransformStore::markDirty( uint32_t i_begin, uint32_t i_end )
+{
+    if ( i_begin >= i_end )
+    {
+        return;
+    }
+    
+    m_dirtyRange.first = std::min( m_dirtyRange.first, i_begin );
+    m_dirtyRange.second = std::max( m_dirtyRange.second, i_end );
+}
+
+} // namespace marlin
@@ -0,0 +1,62 @@
+//
+//  transformStore.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_TRANSFORMSTORE_HPP
+#define MARLIN_TRANSFORMSTORE_HPP
+
+#include <marlin/vulkan/../defs.hpp>
+
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace marlin
+{
+
+using TransformSlot = uint32_t;
+
+static const TransformSlot s_invalidTransformSlot = UINT32_MAX;
+
+// World matrices of a scene as structure of arrays, one array per matrix
+// column, indexed by a dense slot per object. Freed slots are reused so the
+// arrays stay packed. Writes widen a dirty range that the render storage
+// takes when it uploads.
+class TransformStore
+{
+public:
+    
+    TransformSlot allocate();
+    void free( TransformSlot i_slot );
+    
+    void set( TransformSlot i_slot, const Mat4f &i_matrix );
+    Mat4f get( TransformSlot i_slot ) const;
+    
+    // Like set but leaves the dirty range alone, so distinct slots can be
+    // written from several threads. Follow with markDirty.
+    void write( TransformSlot i_slot, const Mat4f &i_matrix );
+    void markDirty( uint32_t i_begin, uint32_t i_end );
+    
+    // Slots handed out so far, including free ones
+    uint32_t getSize() const;
+    
+    // Interleave [i_begin, i_end) into matrices as the shader reads them
+    void gather( uint32_t i_begin, uint32_t i_end, Mat4f* o_matrices ) const;
+    
+    // Slots written since the last call, empty when first >= second
+    std::pair< uint32_t, uint32_t > takeDirtyRange();
+    
+private:
+    
+    std::array< std::vector< Vec4f >, 4 > m_columns;
+    std::vector< TransformSlot > m_freeSlots;
+    std::pair< uint32_t, uint32_t > m_dirtyRange { UINT32_MAX, 0 };
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_TRANSFORMSTORE_HPP */
@@ -0,0 +1,205 @@
+//
+//  vertexEncoding.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/scene/vertexEncoding.hpp>
+
+#include <meshoptimizer/src/meshoptimizer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace marlin
+{
+
+static const int s_positionBits = 16;
+static const int s_colorBits = 8;
+static const int s_normalBits = 8;
+
+// Read by meshes without colors, normals or UVs
+static const Vertex s_defaultVertex {
+    .pos = Vec3f( 0.0f ),
+    .color = Vec3f( 1.0f ),
+    .normal = Vec3f( 0.0f, 0.0f, 1.0f ),
+    .uv = Vec2f( 0.0f ),
+};
+
+VertexSource getVertexSource( const std::vector< Vertex > &i_vertices )
+{
+    VertexSource source;
+    source.count = i_vertices.size();
+    if ( i_vertices.empty() )
+    {
+        return source;
+    }
+    
+    const Vertex &first = i_vertices.front();
+    source.streams = {
+        reinterpret_cast< const std::byte* >( &first.pos ),
+        reinterpret_cast< const std::byte* >( &first.color ),
+        reinterpret_cast< const std::byte* >( &first.normal ),
+        reinterpret_cast< const std::byte* >( &first.uv ),
+    };
+    source.strides.fill( sizeof( Vertex ) );
+    
+    return source;
+}
+
+VertexSource getVertexSource( const Mesh &i_mesh )
+{
+    VertexSource source;
+    source.count = i_mesh.getVertices().size();
+    
+    // Partial streams are left out, like getMeshLayout does
+    const VertexLayout layout = getMeshLayout( i_mesh, true );
+    source.streams[ VertexAttributePosition ] = reinterpret_cast< const std::byte* >( i_mesh.getVertices().data );
+    source.streams[ VertexAttributeColor ] = layout.has( VertexAttributeColor ) ? reinterpret_cast< const std::byte* >( i_mesh.getColors().data ) : nullptr;
+    source.streams[ VertexAttributeNormal ] = layout.has( VertexAttributeNormal ) ? reinterpret_cast< const std::byte* >( i_mesh.getNormals().data ) : nullptr;
+    source.streams[ VertexAttributeUV ] = layout.has( VertexAttributeUV ) ? reinterpret_cast< const std::byte* >( i_mesh.getUVs().data ) : nullptr;
+    source.strides = { sizeof( Vec3f ), sizeof( Vec3f ), sizeof( Vec3f ), sizeof( Vec2f ) };
+    
+    return source;
+}
+
+void encodeAttribute( const VertexSource &i_source, VertexAttribute i_attribute, VertexEncoding i_encoding, const Vec4f &i_dequantization, void* o_data, size_t i_stride )
+{
+    const size_t size = getAttributeSize( i_attribute, i_encoding );
+    const std::byte* source = i_source.streams[ i_attribute ];
+    const size_t sourceStride = i_source.strides[ i_attribute ];
+    std::byte* data = static_cast< std::byte* >( o_data );
+    
+    if ( !source )
+    {
+        throw std::runtime_error( "Error: Encoding a vertex attribute the source does not have." );
+    }
+    
+    if ( i_encoding == VertexEncoding::Float )
+    {
+        for ( size_t i = 0; i < i_source.count; i++ )
+        {
+            std::memcpy( data + i * i_stride, source + i * sourceStride, size );
+        }
+        
+        return;
+    }
+    
+    if ( i_attribute == VertexAttributeNormal )
+    {
+        // Unit vectors with a free fourth component, as the octahedral filter wants them
+        std::vector< Vec4f > normals( i_source.count );
+        for ( size_t i = 0; i < i_source.count; i++ )
+        {
+            normals[ i ] = Vec4f( i_source.get< Vec3f >( VertexAttributeNormal, i ), 0.0f );
+        }
+        
+        std::vector< int8_t > octahedral( i_source.count * 4 );
+        meshopt_encodeFilterOct( octahedral.data(), i_source.count, 4, s_normalBits, &normals[ 0 ].x );
+        
+        for ( size_t i = 0; i < i_source.count; i++ )
+        {
+            std::memcpy( data + i * i_stride, &octahedral[ i * 4 ], size );
+        }
+        
+        return;
+    }
+    
+    const Vec3f offset = Vec3f( i_dequantization );
+    const float inverseScale = 1.0f / i_dequantization.w;
+    
+    for ( size_t i = 0; i < i_source.count; i++ )
+    {
+        PackedVertex packed {};
+        
+        if ( i_attribute == VertexAttributePosition )
+        {
+            const Vec3f position = ( i_source.getPosition( i ) - offset ) * inverseScale;
+            packed.pos[ 0 ] = static_cast< uint16_t >( meshopt_quantizeUnorm( position.x, s_positionBits ) );
+            packed.pos[ 1 ] = static_cast< uint16_t >( meshopt_quantizeUnorm( position.y, s_positionBits ) );
+            packed.pos[ 2 ] = static_cast< uint16_t >( meshopt_quantizeUnorm( position.z, s_positionBits ) );
+            std::memcpy( data + i * i_stride, packed.pos, size );
+        }
+        else if ( i_attribute == VertexAttributeColor )
+        {
+            const Vec3f &color = i_source.get< Vec3f >( VertexAttributeColor, i );
+            packed.color[ 0 ] = static_cast< uint8_t >( meshopt_quantizeUnorm( color.r, s_colorBits ) );
+            packed.color[ 1 ] = static_cast< uint8_t >( meshopt_quantizeUnorm( color.g, s_colorBits ) );
+            packed.color[ 2 ] = static_cast< uint8_t >( meshopt_quantizeUnorm( color.b, s_colorBits ) );
+            packed.color[ 3 ] = UINT8_MAX;
+            std::memcpy( data + i * i_stride, packed.color, size );
+        }
+        else
+        {
+            const Vec2f &uv = i_source.get< Vec2f >( VertexAttributeUV, i );
+            packed.uv[ 0 ] = meshopt_quantizeHalf( uv.x );
+            packed.uv[ 1 ] = meshopt_quantizeHalf( uv.y );
+            std::memcpy( data + i * i_stride, packed.uv, size );
+        }
+    }
+}
+
+Vec4f computeDequantization( const Vec3f &i_boundsMin, const Vec3f &i_boundsMax )
+{
+    const Vec3f extent = i_boundsMax - i_boundsMin;
+    const float scale = std::max( { extent.x, extent.y, extent.z } );
+    if ( !( scale > 0.0f ) )
+    {
+        return Vec4f( i_boundsMin, 1.0f );
+    }
+    
+    return Vec4f( i_boundsMin, scale );
+}
+
+VertexLayout getMeshLayout( const Mesh &i_mesh, bool i_interleaved )
+{
+    const size_t vertexCount = i_mesh.getVertices().size();
+    
+    VertexLayout layout;
+    layout.attributes = 1 << VertexAttributePosition;
+    layout.attributes |= i_mesh.getColors().size() == vertexCount ? 1 << VertexAttributeColor : 0;
+    layout.attributes |= i_mesh.getNormals().size() == vertexCount ? 1 << VertexAttributeNormal : 0;
+    layout.attributes |= i_mesh.getUVs().size() == vertexCount ? 1 << VertexAttributeUV : 0;
+    layout.interleaved = i_interleaved;
+    
+    return layout;
+}
+
+void encodeVertices( const VertexSource &i_source, VertexEncoding i_encoding, const VertexLayout &i_layout, const Vec4f &i_dequantization, uint32_t* o_words )
+{
+    const size_t vertexSize = i_layout.getVertexSize( i_encoding );
+    if ( i_source.count == 0 )
+    {
+        return;
+    }
+    
+    std::byte* data = reinterpret_cast< std::byte* >( o_words );
+    
+    size_t offset = 0;
+    for ( VertexAttribute attribute : i_layout.getAttributes() )
+    {
+        const size_t size = getAttributeSize( attribute, i_encoding );
+        if ( i_layout.interleaved )
+        {
+            encodeAttribute( i_source, attribute, i_encoding, i_dequantization, data + offset, vertexSize );
+            offset += size;
+        }
+        else
+        {
+            encodeAttribute( i_source, attribute, i_encoding, i_dequantization, data + offset, size );
+            offset += size * i_source.count;
+        }
+    }
+}
+
+void encodeDefaultAttributes( VertexEncoding i_encoding, std::vector< uint32_t > &o_words )
+{
+    const VertexLayout layout = VertexLayout::getComplete();
+    o_words.resize( layout.getVertexSize( i_encoding ) / sizeof( uint32_t ) );
+    encodeVertices( getVertexSource( { s_defaultVertex } ), i_encoding, layout, s_identityDequantization, o_words.data() );
+}
+
+} // namespace marlin
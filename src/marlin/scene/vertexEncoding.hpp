@@ -0,0 +1,67 @@
+//
+//  vertexEncoding.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_VERTEXENCODING_HPP
+#define MARLIN_VERTEXENCODING_HPP
+
+#include <marlin/scene/mesh.hpp>
+#include <marlin/vulkan/vertexLayout.hpp>
+
+#include <array>
+#include <vector>
+
+namespace marlin
+{
+
+// Offset in xyz and uniform scale in w, positions are stored as ( pos - offset ) / scale
+static const Vec4f s_identityDequantization = Vec4f( 0.0f, 0.0f, 0.0f, 1.0f );
+
+// Maps the bounds onto the unit cube. The scale is uniform so bounding
+// spheres and normal cones keep their shape once quantized.
+Vec4f computeDequantization( const Vec3f &i_boundsMin, const Vec3f &i_boundsMax );
+
+// Float attributes of a run of vertices, read in place from interleaved
+// vertices or from a mesh's streams. Strides are in bytes, attributes the
+// source lacks are null.
+struct VertexSource
+{
+    size_t count = 0;
+    std::array< const std::byte*, VertexAttributeCount > streams {};
+    std::array< size_t, VertexAttributeCount > strides {};
+    
+    template < class T >
+    const T & get( VertexAttribute i_attribute, size_t i_index ) const
+    {
+        return *reinterpret_cast< const T* >( streams[ i_attribute ] + i_index * strides[ i_attribute ] );
+    }
+    
+    const Vec3f & getPosition( size_t i_index ) const { return get< Vec3f >( VertexAttributePosition, i_index ); }
+};
+
+VertexSource getVertexSource( const std::vector< Vertex > &i_vertices );
+VertexSource getVertexSource( const Mesh &i_mesh );
+
+// Attributes a mesh has full streams for, positions are always stored
+VertexLayout getMeshLayout( const Mesh &i_mesh, bool i_interleaved );
+
+// Writes one attribute of every vertex, i_stride bytes apart. Vertices
+// outside the quantization bounds are clamped. Safe to run on any thread.
+void encodeAttribute( const VertexSource &i_source, VertexAttribute i_attribute, VertexEncoding i_encoding, const Vec4f &i_dequantization, void* o_data, size_t i_stride );
+
+// Interleaved layouts come out one vertex after another, separate layouts
+// one stream after another, o_words holds getVertexSize of each vertex.
+// The vertex pool stores words, every layout and encoding is a whole
+// number of them.
+void encodeVertices( const VertexSource &i_source, VertexEncoding i_encoding, const VertexLayout &i_layout, const Vec4f &i_dequantization, uint32_t* o_words );
+
+// What attributes missing from a mesh read, one of each in the complete layout
+void encodeDefaultAttributes( VertexEncoding i_encoding, std::vector< uint32_t > &o_words );
+
+} // namespace marlin
+
+#endif /* MARLIN_VERTEXENCODING_HPP */
@@ -1,19 +1,51 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+// Set by the pipeline for the quantized vertex encoding
+layout ( constant_id = 0 ) const bool quantizedNormals = false;
+
 layout ( binding = 0 ) uniform UniformBufferObject {
-    mat4 model;
     mat4 view;
     mat4 projection;
 } ubo;
 
+// Indexed by the draw's first instance, one matrix per object
+layout ( std430, binding = 1 ) readonly buffer Transforms {
+    mat4 models[];
+} transforms;
+
+// Attributes a mesh lacks read a constant default
 layout ( location = 0 ) in vec3 inPosition;
 layout ( location = 1 ) in vec3 inColor;
+layout ( location = 2 ) in vec4 inNormal;
+layout ( location = 3 ) in vec2 inUV;
 
 layout ( location = 0 ) out vec3 fragColor;
+layout ( location = 1 ) out vec3 fragNormal;
+layout ( location = 2 ) out vec2 fragUV;
+
+// Inverse of meshopt_encodeFilterOct, the scale is stored in z
+vec3 decodeOctahedral( vec4 i_encoded )
+{
+    vec2 xy = i_encoded.xy / i_encoded.z;
+    vec3 normal = vec3( xy, 1.0 - abs( xy.x ) - abs( xy.y ) );
+    
+    float fold = max( -normal.z, 0.0 );
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    
+    return normalize( normal );
+}
 
 void main()
 {
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4( inPosition, 1.0 );
+    mat4 model = transforms.models[ gl_InstanceIndex ];
+    vec3 normal = quantizedNormals ? decodeOctahedral( inNormal ) : inNormal.xyz;
+    
+    gl_Position = ubo.projection * ubo.view * model * vec4( inPosition, 1.0 );
     fragColor = inColor;
+    
+    // Exact for rotations and uniform scales
+    fragNormal = normalize( mat3( model ) * normal );
+    fragUV = inUV;
 }
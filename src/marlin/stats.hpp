@@ -0,0 +1,65 @@
+//
+//  stats.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_STATS_HPP
+#define MARLIN_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace marlin
+{
+
+// A finished offscreen frame. Pixels are tightly packed RGBA8 and stay valid
+// until the ring wraps around and renders into the same image again.
+struct FrameReadback
+{
+    uint64_t frameNumber = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const std::byte* pixels = nullptr;
+};
+
+// Result of one culling pass over every draw
+struct CullStats
+{
+    uint32_t drawCount = 0;
+    uint32_t visibleCount = 0;
+    uint32_t culledCount = 0;
+    double milliseconds = 0.0;
+};
+
+// How the last frame's draws were recorded. Frames that resubmit an
+// earlier recording leave everything but reused at zero.
+struct RecordStats
+{
+    uint32_t batchCount = 0;
+    uint32_t chunkCount = 0;
+    double milliseconds = 0.0;
+    bool reused = false;
+};
+
+// Memory use of one device heap
+struct MemoryHeapStats
+{
+    uint64_t heapSize = 0;
+    
+    // From VK_EXT_memory_budget when enabled, the heap size otherwise
+    uint64_t budget = 0;
+    uint64_t driverUsage = 0;
+    
+    // Memory we have allocated from the driver, and how much of it is handed out
+    uint64_t blockBytes = 0;
+    uint64_t allocationBytes = 0;
+    uint32_t blockCount = 0;
+    uint32_t allocationCount = 0;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_STATS_HPP */
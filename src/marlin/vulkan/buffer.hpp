@@ -10,6 +10,7 @@
 #define MARLIN_BUFFER_HPP
 
 #include <marlin/vulkan/defs.hpp>
+#include <marlin/vulkan/deviceMemoryAllocator.hpp>
 #include <marlin/vulkan/vkObject.hpp>
 
 namespace marlin
@@ -19,6 +20,21 @@ enum class BufferMode
 {
     Local,
     Device,
+    // Host visible and cached where available, for reading results back
+    HostCached,
+};
+
+// Typed view over the mapped memory of a host visible buffer
+template < class T >
+struct BufferSpanT
+{
+    T* data = nullptr;
+    size_t count = 0;
+    
+    T* begin() const { return data; }
+    T* end() const { return data + count; }
+    T& operator[]( size_t i_index ) const { return data[ i_index ]; }
+    size_t size() const { return count; }
 };
 
 template < class T >
@@ -59,10 +75,22 @@ public:
     BufferT() = default;
     ~BufferT() override;
     
+    // Host visible buffers are mapped for their whole lifetime
     void* mapMemory();
-    void unmapMemory();
+    BufferSpanT< T > getSpan();
+    
+    // Needed around direct span access when the memory is not coherent
+    void flush( size_t i_offset, size_t i_count );
+    void invalidate( size_t i_offset, size_t i_count );
+    
     void updateData( const T* i_data, size_t offset, size_t i_count );
     void updateData( const std::vector< T > &i_data, size_t i_offset );
+    
+    // Memory that lands at the offset like updateData, for writing the data
+    // in place instead of copying it there. Device buffers hand out staging
+    // memory that must be filled before the next submit, the others their
+    // own mapped memory, which non coherent memory has to flush.
+    BufferSpanT< T > stageData( size_t i_offset, size_t i_count );
 
     size_t getCount() const;
     void destroy();
@@ -73,7 +101,7 @@ private:
     VkDeviceSize m_size;
     DevicePtr m_device;
     PhysicalDevicePtr m_physicalDevice;
-    VkDeviceMemory m_memory;
+    MemoryAllocation m_memory;
     BufferMode m_mode;
 };
 
@@ -8,33 +8,20 @@
 
 #include <marlin/vulkan/commandBuffer.hpp>
 #include <marlin/vulkan/device.hpp>
+#include <marlin/vulkan/deviceMemoryAllocator.hpp>
 #include <marlin/vulkan/physicalDevice.hpp>
+#include <marlin/vulkan/uploadScheduler.hpp>
 
 namespace marlin
 {
 
-inline uint32_t findMemoryType( const VkPhysicalDeviceMemoryProperties &i_deviceMemoryProperties,
-                                uint32_t i_typeFilter,
-                                const VkMemoryPropertyFlags &i_properties )
-{
-    for ( uint32_t i = 0; i < i_deviceMemoryProperties.memoryTypeCount; i++ )
-    {
-        if ( ( i_typeFilter & ( 1 << i ) ) && ( i_deviceMemoryProperties.memoryTypes[i].propertyFlags & i_properties ) == i_properties )
-        {
-            return i;
-        }
-    }
-
-    throw std::runtime_error( "Error: Failed to find suitable memory type." );
-}
-
 inline void createBuffer( DevicePtr i_device,
-                   VkDeviceSize i_size,
-                   const VkPhysicalDeviceMemoryProperties &i_deviceMemoryProperties,
-                   VkBufferUsageFlags i_usage,
-                   VkMemoryPropertyFlags i_properties,
-                   VkBuffer &o_buffer,
-                   VkDeviceMemory &o_bufferMemory )
+                          VkDeviceSize i_size,
+                          VkBufferUsageFlags i_usage,
+                          VkMemoryPropertyFlags i_properties,
+                          VkMemoryPropertyFlags i_preferred,
+                          VkBuffer &o_buffer,
+                          MemoryAllocation &o_allocation )
 {
     VkBufferCreateInfo bufferInfo {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -52,47 +39,9 @@ inline void createBuffer( DevicePtr i_device,
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements( i_device->getObject(), o_buffer, &memRequirements );
 
-    VkMemoryAllocateInfo allocInfo {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memRequirements.size,
-        .memoryTypeIndex = findMemoryType( i_deviceMemoryProperties, memRequirements.memoryTypeBits, i_properties )
-    };
-
-    if ( vkAllocateMemory( i_device->getObject(), &allocInfo, nullptr, &o_bufferMemory ) != VK_SUCCESS )
-    {
-        throw std::runtime_error( "Error: Failed to allocate buffer memory" );
-    }
-
-    vkBindBufferMemory( i_device->getObject(), o_buffer, o_bufferMemory, 0 );
-}
-
-inline void copyBuffer( DevicePtr i_device, VkBuffer i_srcBuffer, VkBuffer i_dstBuffer, VkDeviceSize i_srcOffset, VkDeviceSize i_dstOffset, VkDeviceSize i_size )
-{
-    CommandBufferPtr commandBuffer = i_device->getCommandBuffer( QueueTypeTransfer, 0 );
-    commandBuffer->reset();
-    
-    {
-        CommandBufferRecordPtr scopedRecord = commandBuffer->scopedRecord( VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT );
-                
-        VkBufferCopy copyRegion {
-            .srcOffset = i_srcOffset,
-            .dstOffset = i_dstOffset,
-            .size = i_size
-        };
-
-        vkCmdCopyBuffer( commandBuffer->getObject(), i_srcBuffer, i_dstBuffer, 1, &copyRegion );
-    }
-    
-    VkCommandBuffer vkCommandBuffer = commandBuffer->getObject();
-    VkSubmitInfo submitInfo {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &vkCommandBuffer
-    };
+    o_allocation = i_device->getMemoryAllocator()->allocate( memRequirements, i_properties, MemoryResourceType::Linear, i_preferred );
 
-    VkQueue queue = i_device->getQueue( QueueTypeTransfer, 0 );
-    vkQueueSubmit( queue, 1, &submitInfo, VK_NULL_HANDLE );
-    vkQueueWaitIdle( queue );
+    vkBindBufferMemory( i_device->getObject(), o_buffer, o_allocation.memory, o_allocation.offset );
 }
 
 template < class T >
@@ -133,7 +82,7 @@ BufferT< T >::BufferT( DevicePtr i_device,
                        VkBufferUsageFlags i_usage,
                        BufferMode i_mode,
                        const std::vector< T > &i_data )
-: BufferT< T >( i_device, i_physicalDevice, i_usage, i_mode, i_data.data(), i_data.size() * sizeof( T ) )
+: BufferT< T >( i_device, i_physicalDevice, i_usage, i_mode, i_data.data(), i_data.size() )
 {
 }
 
@@ -150,42 +99,38 @@ BufferT< T >::BufferT( DevicePtr i_device,
 , m_count( i_count )
 {
     const VkDeviceSize size = i_count * sizeof( T );
-    const VkPhysicalDeviceMemoryProperties deviceMemoryProperties = i_physicalDevice->getMemoryProperties();
 
     switch ( i_mode ) {
         case BufferMode::Local:
             {
-                createBuffer( i_device, size, deviceMemoryProperties, i_usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_object, m_memory );
+                createBuffer( i_device, size, i_usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, m_object, m_memory );
              
                 if ( i_data != nullptr )
                 {
-                    void* dest;
-                    vkMapMemory( i_device->getObject(), m_memory, 0, size, 0, &dest );
-                    memcpy( dest, i_data, static_cast< size_t >( size ) );
-                    vkUnmapMemory( i_device->getObject(), m_memory );
+                    memcpy( m_memory.mapped, i_data, static_cast< size_t >( size ) );
+                }
+            }
+            break;
+        case BufferMode::HostCached:
+            {
+                // Cached memory is often not coherent, readers invalidate first
+                createBuffer( i_device, size, i_usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, m_object, m_memory );
+                
+                if ( i_data != nullptr )
+                {
+                    memcpy( m_memory.mapped, i_data, static_cast< size_t >( size ) );
+                    i_device->getMemoryAllocator()->flush( m_memory, 0, size );
                 }
             }
             break;
         case BufferMode::Device:
             {
-                createBuffer( i_device, size, deviceMemoryProperties, VK_BUFFER_USAGE_TRANSFER_DST_BIT | i_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_object, m_memory );
+                createBuffer( i_device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | i_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, m_object, m_memory );
                 
                 if ( i_data != nullptr )
                 {
-                    VkBuffer stagingBuffer;
-                    VkDeviceMemory stagingBufferMemory;
-
-                    createBuffer( i_device, size, deviceMemoryProperties, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory );
-
-                    void* dest;
-                    vkMapMemory( i_device->getObject(), stagingBufferMemory, 0, size, 0, &dest );
-                    memcpy( dest, i_data, static_cast< size_t >( size ) );
-                    vkUnmapMemory( i_device->getObject(), stagingBufferMemory );
-
-                    copyBuffer( m_device, stagingBuffer, m_object, 0, 0, size );
-
-                    vkDestroyBuffer( i_device->getObject(), stagingBuffer, nullptr );
-                    vkFreeMemory( i_device->getObject(), stagingBufferMemory, nullptr );
+                    // Lands with the next recorded frame
+                    i_device->getUploadScheduler()->stage( i_data, size, m_object, 0 );
                 }
             }
             break;
@@ -205,7 +150,7 @@ BufferT< T >::~BufferT()
         std::cerr << "Warning: Buffer object not released." << std::endl;
     }
     
-    if ( m_memory != VK_NULL_HANDLE )
+    if ( m_memory.isValid() )
     {
         std::cerr << "Warning: Buffer memory not released." << std::endl;
     }
@@ -214,25 +159,31 @@ BufferT< T >::~BufferT()
 template < class T >
 void* BufferT< T >::mapMemory()
 {
-    if ( m_mode != BufferMode::Local )
+    if ( m_mode == BufferMode::Device )
     {
         throw std::runtime_error( "Mapping non local buffers is not supported." );
     }
     
-    void *data;
-    vkMapMemory( m_device->getObject(), m_memory, 0, m_size, 0, &data );
-    return data;
+    // Host visible blocks stay mapped, hand out our range of the block
+    return m_memory.mapped;
 }
 
 template < class T >
-void BufferT< T >::unmapMemory()
+BufferSpanT< T > BufferT< T >::getSpan()
 {
-    if ( m_mode != BufferMode::Local )
-    {
-        throw std::runtime_error( "Unmapping non local buffers is not supported." );
-    }
-    
-    vkUnmapMemory( m_device->getObject(), m_memory );
+    return BufferSpanT< T > { static_cast< T* >( mapMemory() ), m_count };
+}
+
+template < class T >
+void BufferT< T >::flush( size_t i_offset, size_t i_count )
+{
+    m_device->getMemoryAllocator()->flush( m_memory, i_offset * sizeof( T ), i_count * sizeof( T ) );
+}
+
+template < class T >
+void BufferT< T >::invalidate( size_t i_offset, size_t i_count )
+{
+    m_device->getMemoryAllocator()->invalidate( m_memory, i_offset * sizeof( T ), i_count * sizeof( T ) );
 }
 
 template < class T >
@@ -248,37 +199,25 @@ void BufferT< T >::updateData( const T* i_data, size_t i_offset, size_t i_count
         throw std::runtime_error( "Trying to update out of bounds memory." );
     }
     
-    VkDevice device = m_device->getObject();
-    
     VkDeviceSize offset = i_offset * sizeof( T );
     VkDeviceSize size = i_count * sizeof( T );
 
     switch ( m_mode ) {
         case BufferMode::Local:
             {
-                void *dest;
-                vkMapMemory( device, m_memory, offset, size, 0, &dest );
-                memcpy( dest, i_data, static_cast< size_t >( size ) );
-                vkUnmapMemory( device, m_memory );
+                memcpy( m_memory.mapped + offset, i_data, static_cast< size_t >( size ) );
+            }
+            break;
+        case BufferMode::HostCached:
+            {
+                memcpy( m_memory.mapped + offset, i_data, static_cast< size_t >( size ) );
+                m_device->getMemoryAllocator()->flush( m_memory, offset, size );
             }
             break;
         case BufferMode::Device:
             {
-                VkBuffer stagingBuffer;
-                VkDeviceMemory stagingBufferMemory;
-
-                const VkPhysicalDeviceMemoryProperties deviceMemoryProperties = m_physicalDevice->getMemoryProperties();
-                createBuffer( m_device, size, deviceMemoryProperties, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory );
-
-                void* dest;
-                vkMapMemory( device, stagingBufferMemory, 0, size, 0, &dest );
-                memcpy( dest, i_data, static_cast< size_t >( size ) );
-                vkUnmapMemory( device, stagingBufferMemory );
-
-                copyBuffer( m_device, stagingBuffer, m_object, 0, offset, size );
-
-                vkDestroyBuffer( device, stagingBuffer, nullptr );
-                vkFreeMemory( device, stagingBufferMemory, nullptr );
+                // Lands with the next recorded frame
+                m_device->getUploadScheduler()->stage( i_data, size, m_object, offset );
             }
             break;
             
@@ -293,6 +232,28 @@ void BufferT< T >::updateData( const std::vector< T > &i_data, size_t i_offset )
     updateData( i_data.data(), i_offset, i_data.size() );
 }
 
+template < class T >
+BufferSpanT< T > BufferT< T >::stageData( size_t i_offset, size_t i_count )
+{
+    if ( i_count == 0 )
+    {
+        return BufferSpanT< T >();
+    }
+    
+    if ( ( i_offset + i_count ) * sizeof( T ) > m_size )
+    {
+        throw std::runtime_error( "Trying to update out of bounds memory." );
+    }
+    
+    if ( m_mode != BufferMode::Device )
+    {
+        return BufferSpanT< T > { reinterpret_cast< T* >( m_memory.mapped + i_offset * sizeof( T ) ), i_count };
+    }
+    
+    void* staged = m_device->getUploadScheduler()->stage( i_count * sizeof( T ), m_object, i_offset * sizeof( T ) );
+    return BufferSpanT< T > { static_cast< T* >( staged ), i_count };
+}
+
 template < class T >
 size_t BufferT< T >::getCount() const
 {
@@ -303,9 +264,10 @@ template < class T >
 void BufferT< T >::destroy()
 {
     vkDestroyBuffer( m_device->getObject(), m_object, nullptr );
-    vkFreeMemory( m_device->getObject(), m_memory, nullptr );
+    m_device->getMemoryAllocator()->free( m_memory );
     
     m_object = VK_NULL_HANDLE;
+    m_memory = MemoryAllocation();
 }
 
 } // namespace marlin
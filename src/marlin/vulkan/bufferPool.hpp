@@ -15,6 +15,9 @@
 
 #include <thirdparty/OffsetAllocator/offsetAllocator.hpp>
 
+#include <array>
+#include <memory>
+
 namespace marlin
 {
 
@@ -39,10 +42,28 @@ struct BufferPoolHandleT
 template < class T >
 struct PoolEntryT
 {
-    PoolEntryT( OffsetAllocator::Allocator i_allocator, BufferTPtr< T > i_buffer );
+    PoolEntryT( OffsetAllocator::Allocator i_allocator, BufferTPtr< T > i_buffer, uint32_t i_size, bool i_dedicated );
     
     OffsetAllocator::Allocator allocator;
     BufferTPtr< T > buffer;
+    uint32_t size;
+    
+    // Holds a single allocation larger than the pool size
+    bool dedicated;
+};
+
+// Sizes are in allocation units. Fragmentation is 1 - largest free region / free space.
+struct BufferPoolStats
+{
+    size_t entryCount = 0;
+    size_t dedicatedCount = 0;
+    uint64_t totalSize = 0;
+    uint64_t freeSize = 0;
+    uint64_t largestFreeRegion = 0;
+    float fragmentation = 0.0f;
+    
+    // Free regions bucketed by power of two size
+    std::array< uint32_t, 32 > freeRegionHistogram {};
 };
 
 template < class T >
@@ -50,22 +71,37 @@ class BufferPoolT
 {
 public:
 
-    BufferPoolT( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, PoolUsage i_usage, size_t i_size );
+    // Sizes and offsets count units of i_stride elements, so records whose
+    // size is only known at runtime can be pooled as runs of plain elements
+    BufferPoolT( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, PoolUsage i_usage, size_t i_size, uint32_t i_stride = 1 );
     ~BufferPoolT() = default;
     
+    uint32_t getStride() const;
+    
     BufferPoolHandleT< T > allocate( uint32_t i_size );
     void deallocate( const BufferPoolHandleT< T > &i_handle );
+    
+    BufferPoolStats getStats() const;
+    
+    // Sparse entry worth emptying into the others so it can be released
+    bool getEvacuationCandidate( size_t &o_index ) const;
+    
+    // Allocate from existing entries other than the one given, never grows the pool
+    BufferPoolHandleT< T > allocateElsewhere( uint32_t i_size, size_t i_excludedIndex );
 
 private:
     
     BufferPoolHandleT< T > allocate( size_t i_index, uint32_t i_size );
+    size_t addEntry( uint32_t i_size, bool i_dedicated );
     
     DevicePtr m_device;
     PhysicalDevicePtr m_physicalDevice;
-    VkBufferUsageFlagBits m_vkUsage;
+    VkBufferUsageFlags m_vkUsage;
     size_t m_poolSize;
+    uint32_t m_stride;
     
-    std::vector< PoolEntryT< T > > m_entries;
+    // Released entries leave a null slot so handle indices stay stable
+    std::vector< std::unique_ptr< PoolEntryT< T > > > m_entries;
 };
 
 } // namespace marlin
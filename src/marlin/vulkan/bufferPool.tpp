@@ -8,21 +8,33 @@
 
 #include <marlin/vulkan/bufferPool.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace marlin
 {
 
+// Entries emptied below this usage are evacuated by defragmentation
+static const float s_evacuationThreshold = 0.5f;
+
+// Dedicated entries only ever hold one allocation
+static const uint32_t s_dedicatedMaxAllocs = 8;
+
 template < class T >
-PoolEntryT< T >::PoolEntryT( OffsetAllocator::Allocator i_allocator, BufferTPtr< T > i_buffer )
+PoolEntryT< T >::PoolEntryT( OffsetAllocator::Allocator i_allocator, BufferTPtr< T > i_buffer, uint32_t i_size, bool i_dedicated )
 : allocator( std::move( i_allocator ) )
 , buffer( i_buffer )
+, size( i_size )
+, dedicated( i_dedicated )
 {}
 
 template < class T >
-BufferPoolT< T >::BufferPoolT( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, PoolUsage i_usage, size_t i_size )
+BufferPoolT< T >::BufferPoolT( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, PoolUsage i_usage, size_t i_size, uint32_t i_stride )
 : m_device( i_device )
 , m_physicalDevice( i_physicalDevice )
-, m_vkUsage( VK_BUFFER_USAGE_FLAG_BITS_MAX_ENUM )
+, m_vkUsage( 0 )
 , m_poolSize( i_size )
+, m_stride( i_stride )
 {
     if ( i_usage == PoolUsage::Vertex )
     {
@@ -32,14 +44,35 @@ BufferPoolT< T >::BufferPoolT( DevicePtr i_device, PhysicalDevicePtr i_physicalD
     {
         m_vkUsage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
     }
+    
+    // Defragmentation copies between entries on the device
+    m_vkUsage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+}
+
+template < class T >
+uint32_t BufferPoolT< T >::getStride() const
+{
+    return m_stride;
 }
 
 template < class T >
 BufferPoolHandleT< T > BufferPoolT< T >::allocate( uint32_t i_size )
 {
     BufferPoolHandleT< T > handle;
-    for ( uint32_t i = 0; i < m_entries.size(); i++ )
+    
+    // Too large for a shared entry, give it one of its own
+    if ( i_size > m_poolSize )
     {
+        return allocate( addEntry( i_size, true ), i_size );
+    }
+    
+    for ( size_t i = 0; i < m_entries.size(); i++ )
+    {
+        if ( !m_entries[ i ] || m_entries[ i ]->dedicated )
+        {
+            continue;
+        }
+        
         handle = allocate( i, i_size );
         if ( handle.allocation.offset != OffsetAllocator::Allocation::NO_SPACE )
         {
@@ -49,9 +82,7 @@ BufferPoolHandleT< T > BufferPoolT< T >::allocate( uint32_t i_size )
     
     if ( handle.allocation.offset == OffsetAllocator::Allocation::NO_SPACE )
     {
-        BufferTPtr< T > buffer = BufferT< T >::create( m_device, m_physicalDevice, m_vkUsage, BufferMode::Local, nullptr, m_poolSize );
-        m_entries.emplace_back( m_poolSize, buffer );
-        handle = allocate( m_entries.size() - 1, i_size );
+        handle = allocate( addEntry( static_cast< uint32_t >( m_poolSize ), false ), i_size );
     }
     
     return handle;
@@ -61,20 +92,163 @@ template < class T >
 void BufferPoolT< T >::deallocate( const BufferPoolHandleT< T > &i_handle )
 {
     // Clear entry
-    m_entries[ i_handle.index ].allocator.free( i_handle.allocation );
+    std::unique_ptr< PoolEntryT< T > > &entry = m_entries[ i_handle.index ];
+    entry->allocator.free( i_handle.allocation );
+    
+    // Release empty entries, callers only free once the device is done with them.
+    // Keep the last shared entry around so steady state churn does not reallocate.
+    if ( entry->allocator.storageReport().totalFreeSpace != entry->size )
+    {
+        return;
+    }
+    
+    const size_t sharedEntries = std::count_if( m_entries.begin(), m_entries.end(), []( const std::unique_ptr< PoolEntryT< T > > &i_entry ) {
+        return i_entry && !i_entry->dedicated;
+    });
+    
+    if ( entry->dedicated || sharedEntries > 1 )
+    {
+        entry->buffer->destroy();
+        entry = nullptr;
+    }
+}
+
+template < class T >
+BufferPoolStats BufferPoolT< T >::getStats() const
+{
+    BufferPoolStats stats;
+    
+    for ( const std::unique_ptr< PoolEntryT< T > > &entry : m_entries )
+    {
+        if ( !entry )
+        {
+            continue;
+        }
+        
+        const OffsetAllocator::StorageReport report = entry->allocator.storageReport();
+        
+        stats.entryCount++;
+        stats.dedicatedCount += entry->dedicated ? 1 : 0;
+        stats.totalSize += entry->size;
+        stats.freeSize += report.totalFreeSpace;
+        stats.largestFreeRegion = std::max< uint64_t >( stats.largestFreeRegion, report.largestFreeRegion );
+        
+        const OffsetAllocator::StorageReportFull fullReport = entry->allocator.storageReportFull();
+        for ( const OffsetAllocator::StorageReportFull::Region &region : fullReport.freeRegions )
+        {
+            if ( region.count == 0 || region.size == 0 )
+            {
+                continue;
+            }
+            
+            const size_t bucket = std::min< size_t >( static_cast< size_t >( std::log2( region.size ) ), stats.freeRegionHistogram.size() - 1 );
+            stats.freeRegionHistogram[ bucket ] += region.count;
+        }
+    }
+    
+    if ( stats.freeSize > 0 )
+    {
+        stats.fragmentation = 1.0f - static_cast< float >( stats.largestFreeRegion ) / static_cast< float >( stats.freeSize );
+    }
+    
+    return stats;
+}
+
+template < class T >
+bool BufferPoolT< T >::getEvacuationCandidate( size_t &o_index ) const
+{
+    // Emptiest shared entry, as long as the rest of the pool can take its contents
+    float lowestUsage = s_evacuationThreshold;
+    bool found = false;
+    
+    uint64_t sharedFree = 0;
+    for ( const std::unique_ptr< PoolEntryT< T > > &entry : m_entries )
+    {
+        if ( entry && !entry->dedicated )
+        {
+            sharedFree += entry->allocator.storageReport().totalFreeSpace;
+        }
+    }
+    
+    for ( size_t i = 0; i < m_entries.size(); i++ )
+    {
+        const std::unique_ptr< PoolEntryT< T > > &entry = m_entries[ i ];
+        if ( !entry || entry->dedicated )
+        {
+            continue;
+        }
+        
+        const uint32_t freeSpace = entry->allocator.storageReport().totalFreeSpace;
+        const uint32_t usedSpace = entry->size - freeSpace;
+        const float usage = static_cast< float >( usedSpace ) / static_cast< float >( entry->size );
+        
+        if ( usedSpace > 0 && usage < lowestUsage && usedSpace <= sharedFree - freeSpace )
+        {
+            lowestUsage = usage;
+            o_index = i;
+            found = true;
+        }
+    }
+    
+    return found;
+}
+
+template < class T >
+BufferPoolHandleT< T > BufferPoolT< T >::allocateElsewhere( uint32_t i_size, size_t i_excludedIndex )
+{
+    BufferPoolHandleT< T > handle;
+    
+    for ( size_t i = 0; i < m_entries.size(); i++ )
+    {
+        if ( i == i_excludedIndex || !m_entries[ i ] || m_entries[ i ]->dedicated )
+        {
+            continue;
+        }
+        
+        handle = allocate( i, i_size );
+        if ( handle.allocation.offset != OffsetAllocator::Allocation::NO_SPACE )
+        {
+            break;
+        }
+    }
+    
+    return handle;
 }
 
 template < class T >
 BufferPoolHandleT< T > BufferPoolT< T >::allocate( size_t i_index, uint32_t i_size )
 {
-    OffsetAllocator::Allocation allocation = m_entries[ i_index ].allocator.allocate( i_size );
+    OffsetAllocator::Allocation allocation = m_entries[ i_index ]->allocator.allocate( i_size );
 
     BufferPoolHandleT< T > handle;
     handle.allocation = allocation;
     handle.index = i_index;
-    handle.buffer = m_entries[ i_index ].buffer;
+    handle.buffer = m_entries[ i_index ]->buffer;
     
     return handle;
 }
 
+template < class T >
+size_t BufferPoolT< T >::addEntry( uint32_t i_size, bool i_dedicated )
+{
+    // Every element could be its own allocation, no need for the allocator's default node count
+    const uint32_t maxAllocs = i_dedicated ? s_dedicatedMaxAllocs : std::min< uint32_t >( 128 * 1024, i_size + 1 );
+    
+    BufferTPtr< T > buffer = BufferT< T >::create( m_device, m_physicalDevice, m_vkUsage, BufferMode::Device, nullptr, static_cast< size_t >( i_size ) * m_stride );
+    auto entry = std::make_unique< PoolEntryT< T > >( OffsetAllocator::Allocator( i_size, maxAllocs ), buffer, i_size, i_dedicated );
+    
+    // Reuse a released slot before growing
+    for ( size_t i = 0; i < m_entries.size(); i++ )
+    {
+        if ( !m_entries[ i ] )
+        {
+            m_entries[ i ] = std::move( entry );
+            return i;
+        }
+    }
+    
+    m_entries.push_back( std::move( entry ) );
+    return m_entries.size() - 1;
+}
+
 } // namespace marlin
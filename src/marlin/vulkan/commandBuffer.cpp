@@ -31,25 +31,21 @@ CommandBuffer::CommandBuffer( VkCommandBuffer i_commandBuffer )
 : VkObjectT< VkCommandBuffer >( i_commandBuffer )
 {
 }
-void CommandBuffer::addCommand( CommandPtr i_command )
+CommandStream & CommandBuffer::getStream()
 {
-    m_commands.emplace_back( std::move( i_command ) );
+    return m_stream;
 }
 
 void CommandBuffer::reset()
 {
     vkResetCommandBuffer( m_object, 0 );
-    m_commands.clear();
+    m_stream.clear();
 }
 
 void CommandBuffer::record( VkCommandBufferUsageFlags i_flags )
 {
     CommandBufferRecordPtr record = scopedRecord( i_flags );
-    
-    for ( CommandPtr &command : m_commands )
-    {
-        command->record( getObject() );
-    }
+    m_stream.replay( getObject() );
 }
 
 CommandBufferRecordPtr CommandBuffer::scopedRecord( VkCommandBufferUsageFlags i_flags )
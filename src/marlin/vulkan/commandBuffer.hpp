@@ -34,14 +34,15 @@ class CommandBuffer : public VkObjectT< VkCommandBuffer >
 public:
     
     explicit CommandBuffer( VkCommandBuffer i_commandBuffer );
-    void addCommand( CommandPtr i_command );
+    CommandStream & getStream();
     void record( VkCommandBufferUsageFlags i_flags );
     void reset();
     CommandBufferRecordPtr scopedRecord( VkCommandBufferUsageFlags i_flags );
     
 private:
     
-    CommandPtrs m_commands;
+    // Reused every frame, cleared but never shrunk
+    CommandStream m_stream;
 };
 
 } // namespace marlin
@@ -15,91 +15,247 @@
 namespace marlin
 {
 
-Command::Command( std::function< void ( VkCommandBuffer ) > i_recordFunc )
-: m_recordFunc( i_recordFunc )
+template < class T >
+static T s_readPayload( const std::byte* i_record )
 {
+    T payload;
+    memcpy( &payload, i_record + sizeof( CommandHeader ), sizeof( T ) );
+    return payload;
 }
 
-void Command::record( VkCommandBuffer i_commandBuffer )
+void CommandStream::clear()
 {
-    m_recordFunc( i_commandBuffer );
+    m_data.clear();
 }
 
-CommandPtr CommandFactory::commandFunction( std::function< void ( VkCommandBuffer ) > i_func )
+bool CommandStream::empty() const
 {
-    return std::make_unique< Command >( i_func );
+    return m_data.empty();
 }
 
-CommandPtr CommandFactory::beginRenderPass( VkRenderPass i_renderPass, VkFramebuffer i_frameBuffer, const VkExtent2D &i_extent )
+size_t CommandStream::getSize() const
 {
-    auto func = [ i_renderPass, i_frameBuffer, i_extent ]( VkCommandBuffer i_commandBuffer ) {
-        
-        VkClearValue clearColor = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+    return m_data.size();
+}
+
+void CommandStream::replay( VkCommandBuffer i_commandBuffer ) const
+{
+    const std::byte* record = m_data.data();
+    const std::byte* end = record + m_data.size();
+    
+    while ( record < end )
+    {
+        CommandHeader header;
+        memcpy( &header, record, sizeof( CommandHeader ) );
         
-        VkRenderPassBeginInfo renderPassInfo {
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .renderPass = i_renderPass,
-            .framebuffer = i_frameBuffer,
-            .renderArea.offset = { 0, 0 },
-            .renderArea.extent = i_extent,
-            .clearValueCount = 1,
-            .pClearValues = &clearColor,
-        };
+        switch ( header.op ) {
+            case CommandOp::BeginRenderPass:
+                {
+                    const BeginRenderPassCommand command = s_readPayload< BeginRenderPassCommand >( record );
+                    
+                    VkClearValue clearColor = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+                    
+                    VkRenderPassBeginInfo renderPassInfo {
+                        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                        .renderPass = command.renderPass,
+                        .framebuffer = command.framebuffer,
+                        .renderArea.offset = { 0, 0 },
+                        .renderArea.extent = command.extent,
+                        .clearValueCount = 1,
+                        .pClearValues = &clearColor,
+                    };
+                    
+                    vkCmdBeginRenderPass( i_commandBuffer, &renderPassInfo, command.contents );
+                }
+                break;
+            case CommandOp::EndRenderPass:
+                {
+                    vkCmdEndRenderPass( i_commandBuffer );
+                }
+                break;
+            case CommandOp::BindPipeline:
+                {
+                    const BindPipelineCommand command = s_readPayload< BindPipelineCommand >( record );
+                    vkCmdBindPipeline( i_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, command.pipeline );
+                }
+                break;
+            case CommandOp::SetViewport:
+                {
+                    const SetViewportCommand command = s_readPayload< SetViewportCommand >( record );
+                    vkCmdSetViewport( i_commandBuffer, 0, 1, &command.viewport );
+                }
+                break;
+            case CommandOp::SetScissor:
+                {
+                    const SetScissorCommand command = s_readPayload< SetScissorCommand >( record );
+                    vkCmdSetScissor( i_commandBuffer, 0, 1, &command.scissor );
+                }
+                break;
+            case CommandOp::BindDescriptorSets:
+                {
+                    const BindDescriptorSetsCommand command = s_readPayload< BindDescriptorSetsCommand >( record );
+                    vkCmdBindDescriptorSets( i_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, command.layout, 0, 1, &command.descriptorSet, 0, nullptr );
+                }
+                break;
+            case CommandOp::BindVertexBuffer:
+                {
+                    const BindVertexBufferCommand command = s_readPayload< BindVertexBufferCommand >( record );
+                    vkCmdBindVertexBuffers( i_commandBuffer, command.binding, 1, &command.buffer, &command.offset );
+                }
+                break;
+            case CommandOp::BindIndexBuffer:
+                {
+                    const BindIndexBufferCommand command = s_readPayload< BindIndexBufferCommand >( record );
+                    vkCmdBindIndexBuffer( i_commandBuffer, command.buffer, command.offset, command.indexType );
+                }
+                break;
+            case CommandOp::DrawIndexedIndirect:
+                {
+                    const DrawIndexedIndirectCommand command = s_readPayload< DrawIndexedIndirectCommand >( record );
+                    vkCmdDrawIndexedIndirect( i_commandBuffer, command.buffer, command.offset, command.drawCount, command.stride );
+                }
+                break;
+            case CommandOp::DrawIndexedIndirectCount:
+                {
+                    const DrawIndexedIndirectCountCommand command = s_readPayload< DrawIndexedIndirectCountCommand >( record );
+                    vkCmdDrawIndexedIndirectCount( i_commandBuffer, command.buffer, command.offset, command.countBuffer, command.countOffset, command.maxDrawCount, command.stride );
+                }
+                break;
+            case CommandOp::ExecuteCommands:
+                {
+                    const ExecuteCommandsCommand command = s_readPayload< ExecuteCommandsCommand >( record );
+                    
+                    // Records are max aligned and the payload is padded, the handles are aligned in place
+                    const VkCommandBuffer* commandBuffers = reinterpret_cast< const VkCommandBuffer* >( record + sizeof( CommandHeader ) + sizeof( ExecuteCommandsCommand ) );
+                    vkCmdExecuteCommands( i_commandBuffer, command.commandBufferCount, commandBuffers );
+                }
+                break;
+            case CommandOp::CopyImageToBuffer:
+                {
+                    const CopyImageToBufferCommand command = s_readPayload< CopyImageToBufferCommand >( record );
+                    
+                    VkBufferImageCopy region {
+                        .bufferOffset = 0,
+                        .bufferRowLength = 0,
+                        .bufferImageHeight = 0,
+                        .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+                        .imageOffset = { 0, 0, 0 },
+                        .imageExtent = { command.extent.width, command.extent.height, 1 },
+                    };
+                    vkCmdCopyImageToBuffer( i_commandBuffer, command.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, command.buffer, 1, &region );
+                    
+                    // Make the copy visible to the host once the frame fence signals
+                    VkBufferMemoryBarrier barrier {
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+                        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                        .buffer = command.buffer,
+                        .offset = 0,
+                        .size = VK_WHOLE_SIZE,
+                    };
+                    vkCmdPipelineBarrier( i_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr );
+                }
+                break;
+            case CommandOp::Callback:
+                {
+                    const CallbackCommand command = s_readPayload< CallbackCommand >( record );
+                    command.callback( i_commandBuffer, command.context );
+                }
+                break;
+                
+            default:
+                throw std::runtime_error( "Error: Unknown command in stream." );
+        }
         
-        vkCmdBeginRenderPass( i_commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
-    };
-    
-    return std::make_unique< Command >( func );
+        record += header.size;
+    }
 }
 
-CommandPtr CommandFactory::endRenderPass()
+void CommandFactory::callback( CommandStream &io_stream, CommandCallback i_callback, void* i_context )
 {
-    auto func = []( VkCommandBuffer i_commandBuffer ) {
-        vkCmdEndRenderPass( i_commandBuffer );
-    };
-    
-    return std::make_unique< Command >( func );
+    io_stream.write( CommandOp::Callback, CallbackCommand { i_callback, i_context } );
 }
 
-CommandPtr CommandFactory::bindPipeline( GraphicsPipelinePtr i_pipeline )
+void CommandFactory::beginRenderPass( CommandStream &io_stream, VkRenderPass i_renderPass, VkFramebuffer i_frameBuffer, const VkExtent2D &i_extent, VkSubpassContents i_contents )
 {
-    auto func = [ i_pipeline ]( VkCommandBuffer i_commandBuffer ) {
-        vkCmdBindPipeline( i_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, i_pipeline->getObject() );
-    };
+    io_stream.write( CommandOp::BeginRenderPass, BeginRenderPassCommand { i_renderPass, i_frameBuffer, i_extent, i_contents } );
+}
+
+void CommandFactory::executeCommands( CommandStream &io_stream, const std::vector< VkCommandBuffer > &i_commandBuffers )
+{
+    if ( i_commandBuffers.empty() )
+    {
+        return;
+    }
     
-    return std::make_unique< Command >( func );
+    const ExecuteCommandsCommand command { static_cast< uint32_t >( i_commandBuffers.size() ) };
+    io_stream.write( CommandOp::ExecuteCommands, command, i_commandBuffers.data(), i_commandBuffers.size() * sizeof( VkCommandBuffer ) );
 }
 
-CommandPtr CommandFactory::setViewport( const Vec2f i_position, const Vec2f i_size )
+void CommandFactory::endRenderPass( CommandStream &io_stream )
 {
-    auto func = [ i_position, i_size ]( VkCommandBuffer i_commandBuffer ) {
-        
-        VkViewport viewport {
-            .x = i_position.x,
-            .y = i_position.y,
-            .width = i_size.x,
-            .height = i_size.y,
-            .minDepth = 0.0f,
-            .maxDepth = 1.0f,
-        };
-        vkCmdSetViewport( i_commandBuffer, 0, 1, &viewport );
+    io_stream.write( CommandOp::EndRenderPass, EndRenderPassCommand {} );
+}
+
+void CommandFactory::bindPipeline( CommandStream &io_stream, GraphicsPipelinePtr i_pipeline )
+{
+    io_stream.write( CommandOp::BindPipeline, BindPipelineCommand { i_pipeline->getObject() } );
+}
+
+void CommandFactory::setViewport( CommandStream &io_stream, const Vec2f i_position, const Vec2f i_size )
+{
+    VkViewport viewport {
+        .x = i_position.x,
+        .y = i_position.y,
+        .width = i_size.x,
+        .height = i_size.y,
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
     };
     
-    return std::make_unique< Command >( func );
+    io_stream.write( CommandOp::SetViewport, SetViewportCommand { viewport } );
 }
 
-CommandPtr CommandFactory::setScissor( const Vec2i i_offset, const Vec2u i_extent )
+void CommandFactory::setScissor( CommandStream &io_stream, const Vec2i i_offset, const Vec2u i_extent )
 {
-    auto func = [ i_offset, i_extent ]( VkCommandBuffer i_commandBuffer ) {
-        
-        VkRect2D scissor {
-            .offset = { i_offset.x, i_offset.y },
-            .extent = { i_extent.x, i_extent.y },
-        };
-        vkCmdSetScissor( i_commandBuffer, 0, 1, &scissor );
+    VkRect2D scissor {
+        .offset = { i_offset.x, i_offset.y },
+        .extent = { i_extent.x, i_extent.y },
     };
     
-    return std::make_unique< Command >( func );
+    io_stream.write( CommandOp::SetScissor, SetScissorCommand { scissor } );
+}
+
+void CommandFactory::bindDescriptorSet( CommandStream &io_stream, VkPipelineLayout i_layout, VkDescriptorSet i_descriptorSet )
+{
+    io_stream.write( CommandOp::BindDescriptorSets, BindDescriptorSetsCommand { i_layout, i_descriptorSet } );
+}
+
+void CommandFactory::bindVertexBuffer( CommandStream &io_stream, uint32_t i_binding, VkBuffer i_buffer, VkDeviceSize i_offset )
+{
+    io_stream.write( CommandOp::BindVertexBuffer, BindVertexBufferCommand { i_binding, i_buffer, i_offset } );
+}
+
+void CommandFactory::bindIndexBuffer( CommandStream &io_stream, VkBuffer i_buffer, VkDeviceSize i_offset, VkIndexType i_indexType )
+{
+    io_stream.write( CommandOp::BindIndexBuffer, BindIndexBufferCommand { i_buffer, i_offset, i_indexType } );
+}
+
+void CommandFactory::drawIndexedIndirect( CommandStream &io_stream, VkBuffer i_buffer, VkDeviceSize i_offset, uint32_t i_drawCount, uint32_t i_stride )
+{
+    io_stream.write( CommandOp::DrawIndexedIndirect, DrawIndexedIndirectCommand { i_buffer, i_offset, i_drawCount, i_stride } );
+}
+
+void CommandFactory::drawIndexedIndirectCount( CommandStream &io_stream, VkBuffer i_buffer, VkDeviceSize i_offset, VkBuffer i_countBuffer, VkDeviceSize i_countOffset, uint32_t i_maxDrawCount, uint32_t i_stride )
+{
+    io_stream.write( CommandOp::DrawIndexedIndirectCount, DrawIndexedIndirectCountCommand { i_buffer, i_offset, i_countBuffer, i_countOffset, i_maxDrawCount, i_stride } );
+}
+
+void CommandFactory::copyImageToBuffer( CommandStream &io_stream, VkImage i_image, VkBuffer i_buffer, const VkExtent2D &i_extent )
+{
+    io_stream.write( CommandOp::CopyImageToBuffer, CopyImageToBufferCommand { i_image, i_buffer, i_extent } );
 }
 
 } // marlin
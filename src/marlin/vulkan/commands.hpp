@@ -14,37 +14,193 @@
 
 #include <vulkan/vulkan.h>
 
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
 namespace marlin
 {
 
-class Command
+enum class CommandOp : uint32_t
 {
-public:
-        
-    Command() = delete;
-    Command( std::function< void ( VkCommandBuffer ) > i_recordFunc );
+    BeginRenderPass,
+    EndRenderPass,
+    BindPipeline,
+    SetViewport,
+    SetScissor,
+    BindDescriptorSets,
+    BindVertexBuffer,
+    BindIndexBuffer,
+    DrawIndexedIndirect,
+    DrawIndexedIndirectCount,
+    ExecuteCommands,
+    CopyImageToBuffer,
+    Callback,
+};
+
+// Escape hatch for work that records its own commands, e.g. barriers
+using CommandCallback = void (*)( VkCommandBuffer i_commandBuffer, void* i_context );
 
-    virtual ~Command() = default;
+// Every record starts with a header, size covers the header, the payload and
+// any trailing array, padded so the next header stays aligned
+struct CommandHeader
+{
+    CommandOp op;
+    uint32_t size;
+};
+
+struct BeginRenderPassCommand
+{
+    VkRenderPass renderPass;
+    VkFramebuffer framebuffer;
+    VkExtent2D extent;
+    VkSubpassContents contents;
+};
+
+struct BindPipelineCommand
+{
+    VkPipeline pipeline;
+};
+
+struct SetViewportCommand
+{
+    VkViewport viewport;
+};
+
+struct SetScissorCommand
+{
+    VkRect2D scissor;
+};
+
+struct BindDescriptorSetsCommand
+{
+    VkPipelineLayout layout;
+    VkDescriptorSet descriptorSet;
+};
+
+struct BindVertexBufferCommand
+{
+    uint32_t binding;
+    VkBuffer buffer;
+    VkDeviceSize offset;
+};
+
+struct BindIndexBufferCommand
+{
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    VkIndexType indexType;
+};
+
+struct DrawIndexedIndirectCommand
+{
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    uint32_t drawCount;
+    uint32_t stride;
+};
+
+// The draw count is read from countBuffer on the device, capped at maxDrawCount
+struct DrawIndexedIndirectCountCommand
+{
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    VkBuffer countBuffer;
+    VkDeviceSize countOffset;
+    uint32_t maxDrawCount;
+    uint32_t stride;
+};
+
+struct EndRenderPassCommand
+{
+};
+
+// Followed by commandBufferCount VkCommandBuffer handles, aligned for them
+struct alignas( VkCommandBuffer ) ExecuteCommandsCommand
+{
+    uint32_t commandBufferCount;
+};
+
+struct CopyImageToBufferCommand
+{
+    VkImage image;
+    VkBuffer buffer;
+    VkExtent2D extent;
+};
+
+struct CallbackCommand
+{
+    CommandCallback callback;
+    void* context;
+};
+
+// Commands encoded as plain data into one linear arena. Clearing keeps the
+// capacity, so a stream that is reused every frame stops allocating once it
+// has grown to the size of a frame. Replaying does not modify the stream and
+// can happen from several threads at once. Records hold raw Vulkan handles
+// and callback pointers, so a stream can be replayed for as long as those
+// objects live within this process but cannot be saved or shared outside it.
+class CommandStream
+{
+public:
+    
+    void clear();
+    bool empty() const;
+    size_t getSize() const;
+    
+    template < class T >
+    void write( CommandOp i_op, const T &i_payload, const void* i_trailing = nullptr, size_t i_trailingSize = 0 );
+    
+    void replay( VkCommandBuffer i_commandBuffer ) const;
     
-    void record( VkCommandBuffer i_commandBuffer );
 private:
     
-    std::function< void ( VkCommandBuffer ) > m_recordFunc;
+    std::vector< std::byte > m_data;
 };
 
 class CommandFactory
 {
 public:
     
-    static CommandPtr commandFunction( std::function< void ( VkCommandBuffer ) > i_func );
-    static CommandPtr beginRenderPass( VkRenderPass i_renderPass, VkFramebuffer i_frameBuffer, const VkExtent2D &i_extent );
-    static CommandPtr endRenderPass();
-    static CommandPtr bindPipeline( GraphicsPipelinePtr i_pipeline );
-    static CommandPtr setViewport( const Vec2f i_position, const Vec2f i_size );
-    static CommandPtr setScissor( const Vec2i i_offset, const Vec2u i_extent );
+    static void callback( CommandStream &io_stream, CommandCallback i_callback, void* i_context );
+    static void beginRenderPass( CommandStream &io_stream, VkRenderPass i_renderPass, VkFramebuffer i_frameBuffer, const VkExtent2D &i_extent, VkSubpassContents i_contents = VK_SUBPASS_CONTENTS_INLINE );
+    static void endRenderPass( CommandStream &io_stream );
+    static void executeCommands( CommandStream &io_stream, const std::vector< VkCommandBuffer > &i_commandBuffers );
+    static void bindPipeline( CommandStream &io_stream, GraphicsPipelinePtr i_pipeline );
+    static void setViewport( CommandStream &io_stream, const Vec2f i_position, const Vec2f i_size );
+    static void setScissor( CommandStream &io_stream, const Vec2i i_offset, const Vec2u i_extent );
+    static void bindDescriptorSet( CommandStream &io_stream, VkPipelineLayout i_layout, VkDescriptorSet i_descriptorSet );
+    static void bindVertexBuffer( CommandStream &io_stream, uint32_t i_binding, VkBuffer i_buffer, VkDeviceSize i_offset );
+    static void bindIndexBuffer( CommandStream &io_stream, VkBuffer i_buffer, VkDeviceSize i_offset, VkIndexType i_indexType );
+    static void drawIndexedIndirect( CommandStream &io_stream, VkBuffer i_buffer, VkDeviceSize i_offset, uint32_t i_drawCount, uint32_t i_stride );
+    static void drawIndexedIndirectCount( CommandStream &io_stream, VkBuffer i_buffer, VkDeviceSize i_offset, VkBuffer i_countBuffer, VkDeviceSize i_countOffset, uint32_t i_maxDrawCount, uint32_t i_stride );
+    static void copyImageToBuffer( CommandStream &io_stream, VkImage i_image, VkBuffer i_buffer, const VkExtent2D &i_extent );
 
 };
 
+template < class T >
+void CommandStream::write( CommandOp i_op, const T &i_payload, const void* i_trailing, size_t i_trailingSize )
+{
+    static_assert( std::is_trivially_copyable< T >::value, "Command payloads must be plain data." );
+    
+    const size_t unpadded = sizeof( CommandHeader ) + sizeof( T ) + i_trailingSize;
+    const size_t size = ( unpadded + alignof( std::max_align_t ) - 1 ) & ~( alignof( std::max_align_t ) - 1 );
+    
+    const size_t offset = m_data.size();
+    m_data.resize( offset + size );
+    
+    const CommandHeader header { i_op, static_cast< uint32_t >( size ) };
+    std::byte* dest = m_data.data() + offset;
+    memcpy( dest, &header, sizeof( CommandHeader ) );
+    memcpy( dest + sizeof( CommandHeader ), &i_payload, sizeof( T ) );
+    
+    if ( i_trailingSize > 0 )
+    {
+        memcpy( dest + sizeof( CommandHeader ) + sizeof( T ), i_trailing, i_trailingSize );
+    }
+}
+
 } // namespace marlin
 
 #endif /* MARLIN_COMMANDS_HPP */
@@ -21,10 +21,6 @@ class BufferT;
 template< class T >
 using BufferTPtr = std::shared_ptr< BufferT< T > >;
 
-class Command;
-using CommandPtr = std::unique_ptr< Command >;
-using CommandPtrs = std::vector< CommandPtr >;
-
 class CommandBuffer;
 using CommandBufferPtr = std::shared_ptr< CommandBuffer >;
 
@@ -34,22 +30,49 @@ using CommandBufferRecordPtr = std::shared_ptr< CommandBufferRecord >;
 class Device;
 using DevicePtr = std::shared_ptr< Device >;
 
+class DeviceMemoryAllocator;
+using DeviceMemoryAllocatorPtr = std::shared_ptr< DeviceMemoryAllocator >;
+
+class ComputePipeline;
+using ComputePipelinePtr = std::shared_ptr< ComputePipeline >;
+
 class DescriptorCache;
 using DescriptorCachePtr = std::unique_ptr< DescriptorCache >;
 
+class GpuCuller;
+using GpuCullerPtr = std::shared_ptr< GpuCuller >;
+
 class GraphicsPipeline;
 using GraphicsPipelinePtr = std::shared_ptr< GraphicsPipeline >;
 
+class JobSystem;
+using JobSystemPtr = std::shared_ptr< JobSystem >;
+
+class OffscreenTarget;
+using OffscreenTargetPtr = std::shared_ptr< OffscreenTarget >;
+
 class PhysicalDevice;
 using PhysicalDevicePtr = std::shared_ptr< PhysicalDevice >;
 using PhysicalDevicePtrs = std::vector< PhysicalDevicePtr >;
 
+class SecondaryCommandPools;
+using SecondaryCommandPoolsPtr = std::shared_ptr< SecondaryCommandPools >;
+
+class StagingRing;
+using StagingRingPtr = std::shared_ptr< StagingRing >;
+
 class Surface;
 using SurfacePtr = std::shared_ptr< Surface >;
 
 class SwapChain;
 using SwapChainPtr = std::shared_ptr< SwapChain >;
 
+class TaskQueue;
+using TaskQueuePtr = std::shared_ptr< TaskQueue >;
+
+class UploadScheduler;
+using UploadSchedulerPtr = std::shared_ptr< UploadScheduler >;
+
 class QueueFamily;
 using QueueFamilies = std::vector< QueueFamily >;
 
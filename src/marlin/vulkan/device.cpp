@@ -10,6 +10,10 @@
 
 #include <marlin/vulkan/physicalDevice.hpp>
 #include <marlin/vulkan/commandBuffer.hpp>
+#include <marlin/vulkan/deviceMemoryAllocator.hpp>
+#include <marlin/vulkan/uploadScheduler.hpp>
+
+#include <cstring>
 
 namespace marlin
 {
@@ -18,6 +22,8 @@ static const std::vector< const char* > s_deviceExtensions {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+static const VkDeviceSize s_stagingRingSize = 16 * 1024 * 1024;
+
 DevicePtr Device::create( PhysicalDevicePtr i_device, const SurfacePtr i_surface, const QueueCreateCounts &i_queuesCounts, const BufferCreateCounts &i_bufferCounts )
 {
     QueueFamilies deviceFamilies;
@@ -34,7 +40,13 @@ DevicePtr Device::create( PhysicalDevicePtr i_device, const SurfacePtr i_surface
 
         if ( family.hasTransfer() && ( i_queuesCounts.find( QueueTypeTransfer ) != i_queuesCounts.end() ) )
         {
-            queueFamilies[ QueueTypeTransfer ] = family;
+            // Prefer a dedicated transfer family so uploads overlap rendering
+            const auto existing = queueFamilies.find( QueueTypeTransfer );
+            const bool dedicated = !family.hasGraphics() && !family.hasCompute();
+            if ( existing == queueFamilies.end() || dedicated )
+            {
+                queueFamilies[ QueueTypeTransfer ] = family;
+            }
         }
 
         if ( family.hasCompute() && ( i_queuesCounts.find( QueueTypeCompute ) != i_queuesCounts.end() ) )
@@ -77,14 +89,49 @@ DevicePtr Device::create( PhysicalDevicePtr i_device, const SurfacePtr i_surface
     }
 
     VkPhysicalDeviceFeatures deviceFeatures {};
+    
+    // Whole indirect batches are drawn with one call where supported
+    const VkPhysicalDeviceFeatures supportedFeatures = i_device->getFeatures();
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    
+    // Draws select their world matrix through firstInstance
+    deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+    
+    // Uploads are ordered against rendering with timeline semaphores
+    VkPhysicalDeviceVulkan12Features vulkan12Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .timelineSemaphore = VK_TRUE,
+    };
+    
+    // Lets culling on the device decide how many draws are issued
+    vulkan12Features.drawIndirectCount = i_device->getVulkan12Features().drawIndirectCount;
+    
+    // Swap chains are only needed when presenting to a surface
+    std::vector< const char* > extensions;
+    if ( i_surface != nullptr )
+    {
+        extensions = s_deviceExtensions;
+    }
+    
+    // Lets the memory allocator report per heap budgets
+    std::vector< VkExtensionProperties > supportedExtensions;
+    i_device->getExtensions( supportedExtensions );
+    for ( const VkExtensionProperties &extension : supportedExtensions )
+    {
+        if ( strcmp( extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME ) == 0 )
+        {
+            extensions.push_back( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+        }
+    }
 
     VkDeviceCreateInfo deviceCreateInfo {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = &vulkan12Features,
         .pQueueCreateInfos = queueCreateInfos.data(),
         .queueCreateInfoCount = static_cast< uint32_t >( queueCreateInfos.size() ),
         .pEnabledFeatures = &deviceFeatures,
-        .enabledExtensionCount = static_cast< uint32_t >( s_deviceExtensions.size() ),
-        .ppEnabledExtensionNames = s_deviceExtensions.data()
+        .enabledExtensionCount = static_cast< uint32_t >( extensions.size() ),
+        .ppEnabledExtensionNames = extensions.data()
     };
 
     VkDevice vkDevice;
@@ -93,13 +140,21 @@ DevicePtr Device::create( PhysicalDevicePtr i_device, const SurfacePtr i_surface
         throw std::runtime_error( "Failed to create logical device." );
     }
     
-    return std::make_shared< Device >( vkDevice, queueFamilies, i_bufferCounts );
+    const std::set< std::string > enabledExtensions( extensions.begin(), extensions.end() );
+    // The chain pointed into this function's locals
+    vulkan12Features.pNext = nullptr;
+    
+    return std::make_shared< Device >( vkDevice, i_device, queueFamilies, i_bufferCounts, deviceFeatures, vulkan12Features, enabledExtensions );
 }
 
-Device::Device( VkDevice i_device, const QueueToFamily &i_supportedQueues, const BufferCreateCounts &i_bufferCounts )
+Device::Device( VkDevice i_device, PhysicalDevicePtr i_physicalDevice, const QueueToFamily &i_supportedQueues, const BufferCreateCounts &i_bufferCounts, const VkPhysicalDeviceFeatures &i_enabledFeatures, const VkPhysicalDeviceVulkan12Features &i_enabledVulkan12Features, const std::set< std::string > &i_enabledExtensions )
 : VkObjectT<VkDevice>( i_device )
+, m_physicalDevice( i_physicalDevice )
 , m_supportedQueues( i_supportedQueues )
 , m_bufferCounts( i_bufferCounts )
+, m_enabledFeatures( i_enabledFeatures )
+, m_enabledVulkan12Features( i_enabledVulkan12Features )
+, m_enabledExtensions( i_enabledExtensions )
 {}
 
 Device::~Device()
@@ -131,6 +186,43 @@ VkQueue Device::getQueue( QueueType i_type, uint32_t i_index ) const
     return queue;
 }
 
+uint32_t Device::getQueueFamilyIndex( QueueType i_type ) const
+{
+    const auto it = m_supportedQueues.find( i_type );
+    if ( it == m_supportedQueues.end() )
+    {
+        throw std::runtime_error( "Requesting queue that was not created." );
+    }
+    
+    return it->second.getIndex();
+}
+
+const VkPhysicalDeviceFeatures & Device::getEnabledFeatures() const
+{
+    return m_enabledFeatures;
+}
+
+const VkPhysicalDeviceVulkan12Features & Device::getEnabledVulkan12Features() const
+{
+    return m_enabledVulkan12Features;
+}
+
+const QueueFamily & Device::getQueueFamily( QueueType i_type ) const
+{
+    const auto it = m_supportedQueues.find( i_type );
+    if ( it == m_supportedQueues.end() )
+    {
+        throw std::runtime_error( "Requesting queue that was not created." );
+    }
+    
+    return it->second;
+}
+
+bool Device::isExtensionEnabled( const char* i_extension ) const
+{
+    return m_enabledExtensions.find( i_extension ) != m_enabledExtensions.end();
+}
+
 CommandBufferPtr Device::getCommandBuffer( QueueType i_type, uint32_t i_index )
 {
     THROW_INVALID( "Invalid Device" );
@@ -178,8 +270,78 @@ CommandBufferPtr Device::getCommandBuffer( QueueType i_type, uint32_t i_index )
     return queueCommandBuffer[ i_index ];
 }
 
+std::vector< CommandBufferPtr > Device::allocateCommandBuffers( QueueType i_type, uint32_t i_count )
+{
+    THROW_INVALID( "Invalid Device" );
+    
+    if ( m_supportedQueues.find( i_type ) == m_supportedQueues.end() )
+    {
+        throw std::runtime_error( "Unsupported queue type." );
+    }
+    
+    std::vector< VkCommandBuffer > commandBuffers( i_count );
+    
+    VkCommandBufferAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = getCommandPool( i_type ),
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = i_count,
+    };
+    
+    if ( vkAllocateCommandBuffers( m_object, &allocInfo, commandBuffers.data() ) != VK_SUCCESS )
+    {
+        throw std::runtime_error( "Failed to allocate command buffers!" );
+    }
+    
+    // Freed along with the pool when the device is destroyed
+    std::vector< CommandBufferPtr > result;
+    for ( VkCommandBuffer vkCommandBuffer : commandBuffers )
+    {
+        result.push_back( std::make_shared< CommandBuffer >( vkCommandBuffer ) );
+    }
+    
+    return result;
+}
+
+UploadSchedulerPtr Device::getUploadScheduler()
+{
+    THROW_INVALID( "Invalid Device" );
+    
+    if ( !m_uploadScheduler )
+    {
+        m_uploadScheduler = UploadScheduler::create( shared_from_this(), m_physicalDevice, s_stagingRingSize );
+    }
+    
+    return m_uploadScheduler;
+}
+
+DeviceMemoryAllocatorPtr Device::getMemoryAllocator()
+{
+    THROW_INVALID( "Invalid Device" );
+    
+    if ( !m_memoryAllocator )
+    {
+        m_memoryAllocator = DeviceMemoryAllocator::create( shared_from_this(), m_physicalDevice );
+    }
+    
+    return m_memoryAllocator;
+}
+
 void Device::destroy()
 {
+    // The scheduler's staging ring is sub-allocated, release it first
+    if ( m_uploadScheduler )
+    {
+        m_uploadScheduler->destroy();
+        m_uploadScheduler = nullptr;
+    }
+    
+    if ( m_memoryAllocator )
+    {
+        m_memoryAllocator->destroy();
+        m_memoryAllocator = nullptr;
+    }
+    
     for ( const auto &pair : m_commandPools )
     {
         vkDestroyCommandPool( m_object, pair.second, nullptr );
@@ -13,6 +13,9 @@
 #include <marlin/vulkan/vkObject.hpp>
 
 #include <map>
+#include <memory>
+#include <set>
+#include <string>
 
 namespace marlin
 {
@@ -31,20 +34,35 @@ using QueueToFamily = std::map< QueueType, QueueFamily >;
 using QueueToCommandPool = std::map< QueueType, VkCommandPool >;
 using QueueToCommandBuffers = std::map< QueueType, std::vector< CommandBufferPtr > >;
 
-class Device : public VkObjectT< VkDevice >
+class Device : public VkObjectT< VkDevice >, public std::enable_shared_from_this< Device >
 {
 public:
     
     static DevicePtr create( PhysicalDevicePtr i_device, const SurfacePtr, const QueueCreateCounts &i_queueCounts, const BufferCreateCounts &i_bufferCounts );
     
     Device() = default;
-    Device( VkDevice i_device, const QueueToFamily &i_supportedQueues, const BufferCreateCounts &i_bufferCounts );
+    Device( VkDevice i_device, PhysicalDevicePtr i_physicalDevice, const QueueToFamily &i_supportedQueues, const BufferCreateCounts &i_bufferCounts, const VkPhysicalDeviceFeatures &i_enabledFeatures, const VkPhysicalDeviceVulkan12Features &i_enabledVulkan12Features, const std::set< std::string > &i_enabledExtensions );
         
     ~Device() override;
     
     VkQueue getQueue( QueueType i_type, uint32_t i_index ) const;
+    uint32_t getQueueFamilyIndex( QueueType i_type ) const;
+    const QueueFamily & getQueueFamily( QueueType i_type ) const;
+    
+    const VkPhysicalDeviceFeatures & getEnabledFeatures() const;
+    const VkPhysicalDeviceVulkan12Features & getEnabledVulkan12Features() const;
+    bool isExtensionEnabled( const char* i_extension ) const;
     
     CommandBufferPtr getCommandBuffer( QueueType i_type, uint32_t i_index );
+    
+    // Extra buffers from the queue's pool, for owners whose count is only known after creation
+    std::vector< CommandBufferPtr > allocateCommandBuffers( QueueType i_type, uint32_t i_count );
+    
+    // Shared transfer queue uploads used by device local buffers
+    UploadSchedulerPtr getUploadScheduler();
+    
+    // Block sub-allocator that buffer and image memory is drawn from
+    DeviceMemoryAllocatorPtr getMemoryAllocator();
 
     void destroy();
     
@@ -52,11 +70,18 @@ private:
 
     VkCommandPool getCommandPool( QueueType i_type );
 
+    PhysicalDevicePtr m_physicalDevice;
     QueueToFamily m_supportedQueues;
     BufferCreateCounts m_bufferCounts;
+    VkPhysicalDeviceFeatures m_enabledFeatures;
+    VkPhysicalDeviceVulkan12Features m_enabledVulkan12Features;
+    std::set< std::string > m_enabledExtensions;
     
     QueueToCommandPool m_commandPools;
     QueueToCommandBuffers m_commandBuffers;
+    
+    UploadSchedulerPtr m_uploadScheduler;
+    DeviceMemoryAllocatorPtr m_memoryAllocator;
 };
 
 } // namespace marlin
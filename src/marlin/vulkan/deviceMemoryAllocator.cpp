@@ -0,0 +1,354 @@
+//
+//  deviceMemoryAllocator.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/vulkan/deviceMemoryAllocator.hpp>
+
+#include <marlin/vulkan/device.hpp>
+#include <marlin/vulkan/physicalDevice.hpp>
+
+#include <algorithm>
+
+namespace marlin
+{
+
+static const VkDeviceSize s_blockSize = 64 * 1024 * 1024;
+static const uint32_t s_blockMaxAllocs = 32 * 1024;
+
+static VkDeviceSize s_alignUp( VkDeviceSize i_value, VkDeviceSize i_alignment )
+{
+    return ( i_value + i_alignment - 1 ) / i_alignment * i_alignment;
+}
+
+static uint64_t s_blockKey( uint32_t i_memoryType, MemoryResourceType i_type )
+{
+    return ( static_cast< uint64_t >( i_memoryType ) << 1 ) | ( i_type == MemoryResourceType::NonLinear ? 1 : 0 );
+}
+
+static const uint32_t s_noMemoryType = UINT32_MAX;
+
+static uint32_t s_findMemoryType( const VkPhysicalDeviceMemoryProperties &i_memoryProperties, uint32_t i_typeFilter, VkMemoryPropertyFlags i_properties )
+{
+    for ( uint32_t i = 0; i < i_memoryProperties.memoryTypeCount; i++ )
+    {
+        if ( ( i_typeFilter & ( 1 << i ) ) && ( i_memoryProperties.memoryTypes[ i ].propertyFlags & i_properties ) == i_properties )
+        {
+            return i;
+        }
+    }
+    
+    return s_noMemoryType;
+}
+
+DeviceMemoryAllocator::MemoryBlock::MemoryBlock( VkDeviceMemory i_memory, VkDeviceSize i_size, std::byte* i_mapped, uint32_t i_maxAllocs )
+: memory( i_memory )
+, size( i_size )
+, mapped( i_mapped )
+, allocator( static_cast< OffsetAllocator::uint32 >( std::min< VkDeviceSize >( i_size, UINT32_MAX ) ), i_maxAllocs )
+{}
+
+DeviceMemoryAllocatorPtr DeviceMemoryAllocator::create( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice )
+{
+    return std::make_shared< DeviceMemoryAllocator >( i_device, i_physicalDevice );
+}
+
+DeviceMemoryAllocator::DeviceMemoryAllocator( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice )
+: m_device( i_device )
+, m_physicalDevice( i_physicalDevice )
+, m_memoryProperties( i_physicalDevice->getMemoryProperties() )
+, m_nonCoherentAtomSize( std::max< VkDeviceSize >( i_physicalDevice->getProperties().limits.nonCoherentAtomSize, 1 ) )
+{
+}
+
+DeviceMemoryAllocator::~DeviceMemoryAllocator()
+{
+    if ( !m_blocks.empty() )
+    {
+        std::cerr << "Warning: Device memory allocator not released." << std::endl;
+    }
+}
+
+MemoryAllocation DeviceMemoryAllocator::allocate( const VkMemoryRequirements &i_requirements, VkMemoryPropertyFlags i_properties, MemoryResourceType i_type, VkMemoryPropertyFlags i_preferred )
+{
+    uint32_t memoryType = s_findMemoryType( m_memoryProperties, i_requirements.memoryTypeBits, i_properties | i_preferred );
+    if ( memoryType == s_noMemoryType )
+    {
+        memoryType = s_findMemoryType( m_memoryProperties, i_requirements.memoryTypeBits, i_properties );
+    }
+    
+    if ( memoryType == s_noMemoryType )
+    {
+        throw std::runtime_error( "Error: Failed to find suitable memory type." );
+    }
+    
+    const uint64_t key = s_blockKey( memoryType, i_type );
+    MemoryBlocks &blocks = m_blocks[ key ];
+    
+    const VkMemoryPropertyFlags propertyFlags = m_memoryProperties.memoryTypes[ memoryType ].propertyFlags;
+    const bool nonCoherent = ( propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ) && !( propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+    
+    // Non coherent ranges are flushed in whole atoms, own every atom we touch
+    VkDeviceSize alignment = std::max< VkDeviceSize >( i_requirements.alignment, 1 );
+    VkDeviceSize size = i_requirements.size;
+    if ( nonCoherent )
+    {
+        alignment = s_alignUp( alignment, m_nonCoherentAtomSize );
+        size = s_alignUp( size, m_nonCoherentAtomSize );
+    }
+    
+    MemoryAllocation allocation;
+    allocation.memoryType = memoryType;
+    allocation.propertyFlags = propertyFlags;
+    allocation.blockKey = key;
+    allocation.size = size;
+    
+    // Large resources get a block of their own
+    if ( size > s_blockSize / 2 )
+    {
+        allocation.blockIndex = addBlock( blocks, memoryType, size, true );
+        
+        MemoryBlock &block = *blocks[ allocation.blockIndex ];
+        block.allocatedBytes = size;
+        block.allocationCount = 1;
+        
+        allocation.memory = block.memory;
+        allocation.offset = 0;
+        allocation.mapped = block.mapped;
+        return allocation;
+    }
+    
+    // OffsetAllocator does not align, over allocate and align inside the range
+    const OffsetAllocator::uint32 paddedSize = static_cast< OffsetAllocator::uint32 >( size + alignment - 1 );
+    
+    auto subAllocate = [ & ]( size_t i_blockIndex ) -> bool
+    {
+        MemoryBlock &block = *blocks[ i_blockIndex ];
+        OffsetAllocator::Allocation subAllocation = block.allocator.allocate( paddedSize );
+        if ( subAllocation.offset == OffsetAllocator::Allocation::NO_SPACE )
+        {
+            return false;
+        }
+        
+        block.allocatedBytes += paddedSize;
+        block.allocationCount++;
+        
+        allocation.blockIndex = i_blockIndex;
+        allocation.allocation = subAllocation;
+        allocation.memory = block.memory;
+        allocation.offset = s_alignUp( subAllocation.offset, alignment );
+        allocation.mapped = block.mapped ? block.mapped + allocation.offset : nullptr;
+        return true;
+    };
+    
+    for ( size_t i = 0; i < blocks.size(); i++ )
+    {
+        if ( blocks[ i ] && !blocks[ i ]->dedicated && subAllocate( i ) )
+        {
+            return allocation;
+        }
+    }
+    
+    if ( subAllocate( addBlock( blocks, memoryType, s_blockSize, false ) ) )
+    {
+        return allocation;
+    }
+    
+    throw std::runtime_error( "Error: Failed to sub-allocate device memory." );
+}
+
+void DeviceMemoryAllocator::free( const MemoryAllocation &i_allocation )
+{
+    if ( !i_allocation.isValid() )
+    {
+        return;
+    }
+    
+    MemoryBlocks &blocks = m_blocks[ i_allocation.blockKey ];
+    std::unique_ptr< MemoryBlock > &block = blocks[ i_allocation.blockIndex ];
+    
+    if ( !block->dedicated )
+    {
+        block->allocatedBytes -= block->allocator.allocationSize( i_allocation.allocation );
+        block->allocator.free( i_allocation.allocation );
+    }
+    else
+    {
+        block->allocatedBytes = 0;
+    }
+    
+    block->allocationCount--;
+    if ( block->allocationCount > 0 )
+    {
+        return;
+    }
+    
+    // Keep one shared block per memory type so churn does not hit the driver
+    const size_t sharedBlocks = std::count_if( blocks.begin(), blocks.end(), []( const std::unique_ptr< MemoryBlock > &i_block ) {
+        return i_block && !i_block->dedicated;
+    });
+    
+    if ( block->dedicated || sharedBlocks > 1 )
+    {
+        vkFreeMemory( m_device->getObject(), block->memory, nullptr );
+        block = nullptr;
+    }
+}
+
+void DeviceMemoryAllocator::flush( const MemoryAllocation &i_allocation, VkDeviceSize i_offset, VkDeviceSize i_size ) const
+{
+    VkMappedMemoryRange range;
+    if ( getMappedRange( i_allocation, i_offset, i_size, range ) )
+    {
+        vkFlushMappedMemoryRanges( m_device->getObject(), 1, &range );
+    }
+}
+
+void DeviceMemoryAllocator::invalidate( const MemoryAllocation &i_allocation, VkDeviceSize i_offset, VkDeviceSize i_size ) const
+{
+    VkMappedMemoryRange range;
+    if ( getMappedRange( i_allocation, i_offset, i_size, range ) )
+    {
+        vkInvalidateMappedMemoryRanges( m_device->getObject(), 1, &range );
+    }
+}
+
+std::vector< MemoryHeapStats > DeviceMemoryAllocator::getHeapStats() const
+{
+    std::vector< MemoryHeapStats > stats( m_memoryProperties.memoryHeapCount );
+    
+    for ( uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++ )
+    {
+        stats[ i ].heapSize = m_memoryProperties.memoryHeaps[ i ].size;
+        stats[ i ].budget = m_memoryProperties.memoryHeaps[ i ].size;
+    }
+    
+    if ( m_device->isExtensionEnabled( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME ) )
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+        };
+        
+        VkPhysicalDeviceMemoryProperties2 memoryProperties {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+            .pNext = &budgetProperties,
+        };
+        vkGetPhysicalDeviceMemoryProperties2( m_physicalDevice->getObject(), &memoryProperties );
+        
+        for ( uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++ )
+        {
+            stats[ i ].budget = budgetProperties.heapBudget[ i ];
+            stats[ i ].driverUsage = budgetProperties.heapUsage[ i ];
+        }
+    }
+    
+    for ( const auto &pair : m_blocks )
+    {
+        const uint32_t memoryType = static_cast< uint32_t >( pair.first >> 1 );
+        MemoryHeapStats &heapStats = stats[ m_memoryProperties.memoryTypes[ memoryType ].heapIndex ];
+        
+        for ( const std::unique_ptr< MemoryBlock > &block : pair.second )
+        {
+            if ( !block )
+            {
+                continue;
+            }
+            
+            heapStats.blockBytes += block->size;
+            heapStats.allocationBytes += block->allocatedBytes;
+            heapStats.blockCount++;
+            heapStats.allocationCount += block->allocationCount;
+        }
+    }
+    
+    return stats;
+}
+
+void DeviceMemoryAllocator::destroy()
+{
+    uint32_t liveAllocations = 0;
+    
+    for ( auto &pair : m_blocks )
+    {
+        for ( std::unique_ptr< MemoryBlock > &block : pair.second )
+        {
+            if ( block )
+            {
+                liveAllocations += block->allocationCount;
+                vkFreeMemory( m_device->getObject(), block->memory, nullptr );
+            }
+        }
+    }
+    
+    if ( liveAllocations > 0 )
+    {
+        std::cerr << "Warning: " << liveAllocations << " device memory allocations still live at release." << std::endl;
+    }
+    
+    m_blocks.clear();
+}
+
+size_t DeviceMemoryAllocator::addBlock( MemoryBlocks &io_blocks, uint32_t i_memoryType, VkDeviceSize i_size, bool i_dedicated )
+{
+    VkMemoryAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = i_size,
+        .memoryTypeIndex = i_memoryType,
+    };
+    
+    VkDeviceMemory memory;
+    if ( vkAllocateMemory( m_device->getObject(), &allocInfo, nullptr, &memory ) != VK_SUCCESS )
+    {
+        throw std::runtime_error( "Error: Failed to allocate device memory block." );
+    }
+    
+    // Host visible blocks stay mapped, a memory object can only be mapped once
+    std::byte* mapped = nullptr;
+    if ( m_memoryProperties.memoryTypes[ i_memoryType ].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+    {
+        void* data;
+        vkMapMemory( m_device->getObject(), memory, 0, VK_WHOLE_SIZE, 0, &data );
+        mapped = static_cast< std::byte* >( data );
+    }
+    
+    auto block = std::make_unique< MemoryBlock >( memory, i_size, mapped, i_dedicated ? 1 : s_blockMaxAllocs );
+    block->dedicated = i_dedicated;
+    
+    for ( size_t i = 0; i < io_blocks.size(); i++ )
+    {
+        if ( !io_blocks[ i ] )
+        {
+            io_blocks[ i ] = std::move( block );
+            return i;
+        }
+    }
+    
+    io_blocks.push_back( std::move( block ) );
+    return io_blocks.size() - 1;
+}
+
+bool DeviceMemoryAllocator::getMappedRange( const MemoryAllocation &i_allocation, VkDeviceSize i_offset, VkDeviceSize i_size, VkMappedMemoryRange &o_range ) const
+{
+    if ( !i_allocation.isValid() || i_size == 0 || ( i_allocation.propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ) )
+    {
+        return false;
+    }
+    
+    // Allocations are atom aligned and sized, widening stays inside them
+    const VkDeviceSize begin = i_allocation.offset + i_offset / m_nonCoherentAtomSize * m_nonCoherentAtomSize;
+    const VkDeviceSize end = std::min( i_allocation.offset + s_alignUp( i_offset + i_size, m_nonCoherentAtomSize ), i_allocation.offset + i_allocation.size );
+    
+    o_range = {
+        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .memory = i_allocation.memory,
+        .offset = begin,
+        .size = end - begin,
+    };
+    
+    return true;
+}
+
+} // namespace marlin
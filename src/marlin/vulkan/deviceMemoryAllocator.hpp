@@ -0,0 +1,115 @@
+//
+//  deviceMemoryAllocator.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_DEVICEMEMORYALLOCATOR_HPP
+#define MARLIN_DEVICEMEMORYALLOCATOR_HPP
+
+#include <marlin/stats.hpp>
+#include <marlin/vulkan/defs.hpp>
+
+#include <thirdparty/OffsetAllocator/offsetAllocator.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <memory>
+
+namespace marlin
+{
+
+enum class MemoryResourceType
+{
+    // Buffers and linear images
+    Linear,
+    // Optimally tiled images, kept in their own blocks to honour bufferImageGranularity
+    NonLinear,
+};
+
+struct MemoryAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    
+    // Host pointer at offset when the memory type is host visible
+    std::byte* mapped = nullptr;
+    
+    uint32_t memoryType = 0;
+    VkMemoryPropertyFlags propertyFlags = 0;
+    
+    // Internal, identifies the block and sub-allocation to free
+    uint64_t blockKey = 0;
+    size_t blockIndex = 0;
+    OffsetAllocator::Allocation allocation;
+    
+    bool isValid() const
+    {
+        return memory != VK_NULL_HANDLE;
+    }
+};
+
+// Reserves large VkDeviceMemory blocks per memory type and sub-allocates them
+// with OffsetAllocator, so creating a buffer does not round trip to the driver.
+// Host visible blocks are mapped once for their whole lifetime.
+class DeviceMemoryAllocator
+{
+public:
+    
+    static DeviceMemoryAllocatorPtr create( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice );
+    
+    DeviceMemoryAllocator( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice );
+    ~DeviceMemoryAllocator();
+    
+    // i_preferred flags are used when a matching memory type exists, i_properties always
+    MemoryAllocation allocate( const VkMemoryRequirements &i_requirements, VkMemoryPropertyFlags i_properties, MemoryResourceType i_type, VkMemoryPropertyFlags i_preferred = 0 );
+    void free( const MemoryAllocation &i_allocation );
+    
+    // Make host writes visible to the device, and device writes visible to the host.
+    // Offsets are relative to the allocation, no-ops for coherent memory.
+    void flush( const MemoryAllocation &i_allocation, VkDeviceSize i_offset, VkDeviceSize i_size ) const;
+    void invalidate( const MemoryAllocation &i_allocation, VkDeviceSize i_offset, VkDeviceSize i_size ) const;
+    
+    std::vector< MemoryHeapStats > getHeapStats() const;
+    
+    void destroy();
+    
+private:
+    
+    struct MemoryBlock
+    {
+        MemoryBlock( VkDeviceMemory i_memory, VkDeviceSize i_size, std::byte* i_mapped, uint32_t i_maxAllocs );
+        
+        VkDeviceMemory memory;
+        VkDeviceSize size;
+        std::byte* mapped;
+        OffsetAllocator::Allocator allocator;
+        
+        VkDeviceSize allocatedBytes = 0;
+        uint32_t allocationCount = 0;
+        
+        // Holds a single allocation too large to share a block
+        bool dedicated = false;
+    };
+    
+    using MemoryBlocks = std::vector< std::unique_ptr< MemoryBlock > >;
+    
+    size_t addBlock( MemoryBlocks &io_blocks, uint32_t i_memoryType, VkDeviceSize i_size, bool i_dedicated );
+    bool getMappedRange( const MemoryAllocation &i_allocation, VkDeviceSize i_offset, VkDeviceSize i_size, VkMappedMemoryRange &o_range ) const;
+    
+    DevicePtr m_device;
+    PhysicalDevicePtr m_physicalDevice;
+    VkPhysicalDeviceMemoryProperties m_memoryProperties;
+    VkDeviceSize m_nonCoherentAtomSize;
+    
+    // Keyed by memory type and resource type
+    std::map< uint64_t, MemoryBlocks > m_blocks;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_DEVICEMEMORYALLOCATOR_HPP */
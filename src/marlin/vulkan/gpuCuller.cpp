@@ -0,0 +1,280 @@
+//
+//  gpuCuller.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/vulkan/gpuCuller.hpp>
+
+#include <marlin/vulkan/buffer.hpp>
+#include <marlin/vulkan/descriptor/descriptorCache.hpp>
+#include <marlin/vulkan/device.hpp>
+#include <marlin/vulkan/pipeline.hpp>
+#include <marlin/vulkan/uploadScheduler.hpp>
+
+#include <array>
+
+namespace marlin
+{
+
+// Must match local_size_x in cull.comp
+static const uint32_t s_cullGroupSize = 64;
+
+static const uint32_t s_setsPerPool = 64;
+
+// One uniform buffer and four storage buffers per set
+static const uint32_t s_storageBuffersPerSet = 4;
+
+GpuCullerPtr GpuCuller::create( DevicePtr i_device, DescriptorCachePtr &io_descriptorCache, uint32_t i_frameCount )
+{
+    const std::string path = "/Users/jonathangraham/Code/Marlin/src/marlin/shaders/cull.spv";
+
+    ComputePipelinePtr pipeline = ComputePipeline::create( i_device, path, io_descriptorCache, sizeof( uint32_t ) );
+    VkDescriptorSetLayout setLayout = io_descriptorCache->getLayouts( path ).front();
+
+    return std::make_shared< GpuCuller >( i_device, pipeline, setLayout, i_frameCount );
+}
+
+GpuCuller::GpuCuller( DevicePtr i_device, ComputePipelinePtr i_pipeline, VkDescriptorSetLayout i_setLayout, uint32_t i_frameCount )
+: m_device( i_device )
+, m_pipeline( i_pipeline )
+, m_setLayout( i_setLayout )
+, m_frameCount( i_frameCount )
+{
+}
+
+GpuCuller::~GpuCuller()
+{
+    if ( !m_descriptorPools.empty() )
+    {
+        std::cerr << "Warning: GPU culler descriptor pools not released." << std::endl;
+    }
+}
+
+void GpuCuller::prepare( uint32_t i_frame, const RenderStorage &i_storage, BufferTPtr< UniformBufferObject > i_uniformBuffer )
+{
+    const IndirectBatches &batches = i_storage.getIndirectBatches();
+
+    m_dispatches.clear();
+
+    // Sets of batches that are gone may still be used by frames in flight
+    for ( auto itr = m_batchSets.begin(); itr != m_batchSets.end(); )
+    {
+        if ( batches.find( itr->first ) != batches.end() )
+        {
+            itr++;
+            continue;
+        }
+
+        std::vector< VkDescriptorSet > retired;
+        for ( VkDescriptorSet set : itr->second.sets )
+        {
+            if ( set != VK_NULL_HANDLE )
+            {
+                retired.push_back( set );
+            }
+        }
+
+        m_device->getUploadScheduler()->defer( [ this, retired ]() {
+            m_freeSets.insert( m_freeSets.end(), retired.begin(), retired.end() );
+        });
+
+        itr = m_batchSets.erase( itr );
+    }
+
+    for ( const auto &pair : batches )
+    {
+        const IndirectBatch &batch = pair.second;
+
+        BatchSets &batchSets = m_batchSets[ pair.first ];
+        if ( batchSets.sets.empty() )
+        {
+            batchSets.sets.resize( m_frameCount, VK_NULL_HANDLE );
+            batchSets.bound.resize( m_frameCount );
+        }
+
+        VkDescriptorSet &set = batchSets.sets[ i_frame ];
+        if ( set == VK_NULL_HANDLE )
+        {
+            set = allocateSet();
+        }
+
+        const BoundBuffers buffers {
+            .uniforms = i_uniformBuffer,
+            .transforms = i_storage.getTransformBuffer( i_frame ),
+            .bounds = batch.boundsBuffers[ i_frame ],
+            .commands = batch.indirectBuffers[ i_frame ],
+            .visible = batch.visibleBuffers[ i_frame ],
+        };
+
+        // Only this frame's set is written, its fence has been waited on
+        if ( !( buffers == batchSets.bound[ i_frame ] ) )
+        {
+            writeSet( set, buffers );
+            batchSets.bound[ i_frame ] = buffers;
+        }
+
+        m_dispatches.push_back( {
+            .set = set,
+            .visibleBuffer = buffers.visible->getObject(),
+            .drawCount = static_cast< uint32_t >( batch.commands.size() ),
+        } );
+    }
+}
+
+void GpuCuller::recordDispatches( VkCommandBuffer i_commandBuffer )
+{
+    if ( m_dispatches.empty() )
+    {
+        return;
+    }
+
+    // Every batch starts the frame with nothing visible
+    for ( const Dispatch &dispatch : m_dispatches )
+    {
+        vkCmdFillBuffer( i_commandBuffer, dispatch.visibleBuffer, 0, sizeof( uint32_t ), 0 );
+    }
+
+    VkMemoryBarrier clearBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+
+    vkCmdPipelineBarrier( i_commandBuffer,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          0, 1, &clearBarrier, 0, nullptr, 0, nullptr );
+
+    vkCmdBindPipeline( i_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline->getObject() );
+
+    for ( const Dispatch &dispatch : m_dispatches )
+    {
+        vkCmdBindDescriptorSets( i_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline->getLayout(), 0, 1, &dispatch.set, 0, nullptr );
+        vkCmdPushConstants( i_commandBuffer, m_pipeline->getLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( uint32_t ), &dispatch.drawCount );
+        vkCmdDispatch( i_commandBuffer, ( dispatch.drawCount + s_cullGroupSize - 1 ) / s_cullGroupSize, 1, 1 );
+    }
+
+    VkMemoryBarrier cullBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+    };
+
+    vkCmdPipelineBarrier( i_commandBuffer,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                          0, 1, &cullBarrier, 0, nullptr, 0, nullptr );
+}
+
+void GpuCuller::destroy()
+{
+    for ( VkDescriptorPool pool : m_descriptorPools )
+    {
+        vkDestroyDescriptorPool( m_device->getObject(), pool, nullptr );
+    }
+
+    m_descriptorPools.clear();
+    m_freeSets.clear();
+    m_batchSets.clear();
+    m_dispatches.clear();
+
+    m_pipeline->destroy();
+}
+
+VkDescriptorSet GpuCuller::allocateSet()
+{
+    if ( !m_freeSets.empty() )
+    {
+        VkDescriptorSet set = m_freeSets.back();
+        m_freeSets.pop_back();
+        return set;
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &m_setLayout,
+    };
+
+    VkDescriptorSet set;
+    if ( !m_descriptorPools.empty() )
+    {
+        allocInfo.descriptorPool = m_descriptorPools.back();
+        if ( vkAllocateDescriptorSets( m_device->getObject(), &allocInfo, &set ) == VK_SUCCESS )
+        {
+            return set;
+        }
+    }
+
+    VkDescriptorPoolSize poolSizes[] = {
+        {
+            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount = s_setsPerPool,
+        },
+        {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = s_setsPerPool * s_storageBuffersPerSet,
+        },
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = s_setsPerPool,
+        .poolSizeCount = 2,
+        .pPoolSizes = poolSizes,
+    };
+
+    VkDescriptorPool pool;
+    if ( vkCreateDescriptorPool( m_device->getObject(), &poolInfo, nullptr, &pool ) != VK_SUCCESS )
+    {
+        throw std::runtime_error( "Error: Failed to create culling descriptor pool." );
+    }
+    m_descriptorPools.push_back( pool );
+
+    allocInfo.descriptorPool = pool;
+    if ( vkAllocateDescriptorSets( m_device->getObject(), &allocInfo, &set ) != VK_SUCCESS )
+    {
+        throw std::runtime_error( "Error: Failed to allocate culling descriptor set." );
+    }
+
+    return set;
+}
+
+void GpuCuller::writeSet( VkDescriptorSet i_set, const BoundBuffers &i_buffers )
+{
+    const VkBuffer buffers[] = {
+        i_buffers.uniforms->getObject(),
+        i_buffers.transforms->getObject(),
+        i_buffers.bounds->getObject(),
+        i_buffers.commands->getObject(),
+        i_buffers.visible->getObject(),
+    };
+
+    std::array< VkDescriptorBufferInfo, 5 > bufferInfos;
+    std::array< VkWriteDescriptorSet, 5 > descriptorWrites;
+    for ( uint32_t binding = 0; binding < 5; binding++ )
+    {
+        bufferInfos[ binding ] = {
+            .buffer = buffers[ binding ],
+            .offset = 0,
+            .range = VK_WHOLE_SIZE,
+        };
+
+        descriptorWrites[ binding ] = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = i_set,
+            .dstBinding = binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &bufferInfos[ binding ],
+        };
+    }
+
+    vkUpdateDescriptorSets( m_device->getObject(), static_cast< uint32_t >( descriptorWrites.size() ), descriptorWrites.data(), 0, nullptr );
+}
+
+} // namespace marlin
@@ -0,0 +1,98 @@
+//
+//  gpuCuller.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_GPUCULLER_HPP
+#define MARLIN_GPUCULLER_HPP
+
+#include <marlin/scene/renderStorage.hpp>
+#include <marlin/vulkan/defs.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <vector>
+
+namespace marlin
+{
+
+// Frustum and normal cone culls every indirect batch on the device. Each
+// batch's draws are tested by a compute dispatch that appends the survivors
+// to the batch's visible buffer, the draw count lands in its first slot and
+// the graphics pass consumes both with vkCmdDrawIndexedIndirectCount.
+class GpuCuller
+{
+public:
+
+    static GpuCullerPtr create( DevicePtr i_device, DescriptorCachePtr &io_descriptorCache, uint32_t i_frameCount );
+
+    GpuCuller( DevicePtr i_device, ComputePipelinePtr i_pipeline, VkDescriptorSetLayout i_setLayout, uint32_t i_frameCount );
+    ~GpuCuller();
+
+    // Called while a frame is recorded, the frame's fence has been waited on.
+    // Sets pointing at replaced buffers are rewritten and the dispatches for
+    // recordDispatches are gathered.
+    void prepare( uint32_t i_frame, const RenderStorage &i_storage, BufferTPtr< UniformBufferObject > i_uniformBuffer );
+
+    // Compute work has to be outside the render pass
+    void recordDispatches( VkCommandBuffer i_commandBuffer );
+
+    void destroy();
+
+private:
+
+    // What a set was last written with, buffers are replaced when they grow
+    struct BoundBuffers
+    {
+        BufferTPtr< UniformBufferObject > uniforms;
+        BufferTPtr< Mat4f > transforms;
+        BufferTPtr< DrawBounds > bounds;
+        BufferTPtr< VkDrawIndexedIndirectCommand > commands;
+        BufferTPtr< VkDrawIndexedIndirectCommand > visible;
+
+        bool operator==( const BoundBuffers &i_other ) const
+        {
+            return uniforms == i_other.uniforms &&
+                   transforms == i_other.transforms &&
+                   bounds == i_other.bounds &&
+                   commands == i_other.commands &&
+                   visible == i_other.visible;
+        }
+    };
+
+    struct BatchSets
+    {
+        std::vector< VkDescriptorSet > sets;
+        std::vector< BoundBuffers > bound;
+    };
+
+    struct Dispatch
+    {
+        VkDescriptorSet set;
+        VkBuffer visibleBuffer;
+        uint32_t drawCount;
+    };
+
+    VkDescriptorSet allocateSet();
+    void writeSet( VkDescriptorSet i_set, const BoundBuffers &i_buffers );
+
+    DevicePtr m_device;
+    ComputePipelinePtr m_pipeline;
+    VkDescriptorSetLayout m_setLayout;
+    uint32_t m_frameCount;
+
+    // A new pool is added whenever the current ones run out
+    std::vector< VkDescriptorPool > m_descriptorPools;
+    std::vector< VkDescriptorSet > m_freeSets;
+
+    std::map< IndirectBatchKey, BatchSets > m_batchSets;
+    std::vector< Dispatch > m_dispatches;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_GPUCULLER_HPP */
@@ -15,9 +15,15 @@
 #include <marlin/vulkan/commands.hpp>
 #include <marlin/vulkan/descriptor/descriptorCache.hpp>
 #include <marlin/vulkan/device.hpp>
+#include <marlin/vulkan/deviceMemoryAllocator.hpp>
+#include <marlin/vulkan/gpuCuller.hpp>
+#include <marlin/vulkan/jobSystem.hpp>
 #include <marlin/vulkan/physicalDevice.hpp>
+#include <marlin/vulkan/secondaryCommandPools.hpp>
+#include <marlin/vulkan/uploadScheduler.hpp>
 #include <marlin/vulkan/surface.hpp>
 #include <marlin/vulkan/swapChain.hpp>
+#include <marlin/vulkan/taskQueue.hpp>
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Weverything"
@@ -30,8 +36,12 @@
 #include <stb/stb_image.h>
 
 #include <chrono>
+#include <cstring>
+#include <thread>
 
+#if defined( __APPLE__ )
 #include <vulkan/vulkan_metal.h>
+#endif
 
 #include <fstream>
 #include <set>
@@ -43,6 +53,18 @@ namespace marlin
 // TODO FIX
 const int MAX_FRAMES_IN_FLIGHT = 2;
 
+// Indirect batches recorded per secondary command buffer by default. A chunk
+// costs about as much to set up as one and a half batches cost to record, so
+// at 32 setup stays under 5% while a few hundred batches still spread over
+// every recording thread. See the record chunk size benchmark.
+static const size_t s_defaultRecordChunkSize = 32;
+
+// Recording threads besides the calling one
+static const uint32_t s_maxRecordWorkers = 7;
+
+// Threads for work that may span frames, they compete with the recorders
+static const uint32_t s_backgroundWorkers = 2;
+
 #define VK_EXT_METAL_SURFACE_EXTENSION_NAME "VK_EXT_metal_surface"
 
 // Callback for debug output on validation layers
@@ -97,13 +119,18 @@ static bool hasRequiredInstanceExtension( const char* i_extension )
     return true;
 }
 
-void getExtensions( bool i_enableValidation, std::vector< const char* > &o_extensions )
+void getExtensions( bool i_enableValidation, bool i_headless, std::vector< const char* > &o_extensions )
 {
     std::vector< const char* > extensions = {
-        VK_EXT_METAL_SURFACE_EXTENSION_NAME,
-        VK_KHR_SURFACE_EXTENSION_NAME,
         VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME,
     };
+    
+    // Headless instances never create a surface
+    if ( !i_headless )
+    {
+        extensions.push_back( VK_EXT_METAL_SURFACE_EXTENSION_NAME );
+        extensions.push_back( VK_KHR_SURFACE_EXTENSION_NAME );
+    }
 
     if ( i_enableValidation )
     {
@@ -161,7 +188,7 @@ void getValidationLayers( bool i_enableValidation, std::vector< const char* > &o
     getSupportedValidationLayers( validationLayers, o_validationLayers );
 }
 
-Instance Instance::create( bool i_enableValidation )
+Instance Instance::create( bool i_enableValidation, bool i_headless )
 {
     VkApplicationInfo appInfo {};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -174,10 +201,20 @@ Instance Instance::create( bool i_enableValidation )
     VkInstanceCreateInfo createInstanceInfo {};
     createInstanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInstanceInfo.pApplicationInfo = &appInfo;
-    createInstanceInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
     
     std::vector< const char* > extensions;
-    getExtensions( i_enableValidation, extensions );
+    getExtensions( i_enableValidation, i_headless, extensions );
+    
+    // Portability enumeration is only present on MoltenVK style drivers
+    const auto portability = std::find_if( extensions.begin(), extensions.end(), []( const char* i_extension ) {
+        return std::strcmp( i_extension, VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME ) == 0;
+    });
+    
+    if ( portability != extensions.end() )
+    {
+        createInstanceInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+    }
+    
     createInstanceInfo.enabledExtensionCount = static_cast< uint32_t >( extensions.size() );
     createInstanceInfo.ppEnabledExtensionNames = extensions.data();
     
@@ -290,6 +327,15 @@ static int getDeviceScore( const PhysicalDevicePtr &i_device )
     {
         score += 50;
     }
+    else if ( deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU )
+    {
+        score += 25;
+    }
+    else if ( deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU )
+    {
+        // Software implementations such as lavapipe, used for headless rendering
+        score += 10;
+    }
     
     return score;
 }
@@ -335,8 +381,14 @@ static const std::vector< const char* > s_deviceExtensions {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
-static bool hasRequiredExtensions( PhysicalDevicePtr i_device )
+static bool hasRequiredExtensions( PhysicalDevicePtr i_device, SurfacePtr i_surface )
 {
+    // Nothing is required when we are not presenting
+    if ( i_surface == nullptr )
+    {
+        return true;
+    }
+    
     std::vector< VkExtensionProperties > extensions;
     i_device->getExtensions( extensions );
         
@@ -396,7 +448,19 @@ VkExtent2D chooseSwapExtent( const VkSurfaceCapabilitiesKHR &i_capabilities )
 
 static bool isDeviceSuitable( PhysicalDevicePtr i_device, SurfacePtr i_surface )
 {
-    if ( !hasRequiredExtensions( i_device ) )
+    if ( !hasRequiredExtensions( i_device, i_surface ) )
+    {
+        return false;
+    }
+    
+    // Uploads are synchronised with timeline semaphores
+    if ( !i_device->getVulkan12Features().timelineSemaphore )
+    {
+        return false;
+    }
+    
+    // Indirect draws carry the object's transform slot as firstInstance
+    if ( !i_device->getFeatures().drawIndirectFirstInstance )
     {
         return false;
     }
@@ -405,13 +469,23 @@ static bool isDeviceSuitable( PhysicalDevicePtr i_device, SurfacePtr i_surface )
     getQueueFamilies( i_device, i_surface, familyIndices );
     
     if ( !familyIndices.graphicsFamily.has_value() ||
-         !familyIndices.presentFamily.has_value()  ||
          !familyIndices.transferFamily.has_value() ||
          !familyIndices.computeFamily.has_value() )
     {
         return false;
     }
     
+    // Headless devices only need to render
+    if ( i_surface == nullptr )
+    {
+        return true;
+    }
+    
+    if ( !familyIndices.presentFamily.has_value() )
+    {
+        return false;
+    }
+    
     SwapChainSupportDetails swapChainDetails = i_device->getSwapChainSupportDetails( i_surface );
     if ( swapChainDetails.formats.empty() || swapChainDetails.presentModes.empty() )
     {
@@ -481,17 +555,14 @@ MlnInstance::MlnInstance()
 #else
     m_enableValidation = false;
 #endif
+    
+    m_recordChunkSize = s_defaultRecordChunkSize;
+    m_poolEntryBytes = s_defaultPoolEntryBytes;
 }
 
 void MlnInstance::init( void* i_layer )
 {
-    Instance instance = Instance::create( true );
-    m_vkInstance = instance.getObject();
-    
-    if ( m_enableValidation )
-    {
-        setupDebugging( m_vkInstance, m_debugMessenger );
-    }
+    createInstance( false );
     
     m_surface = Surface::create( m_vkInstance, i_layer );
     
@@ -501,12 +572,47 @@ void MlnInstance::init( void* i_layer )
     // Create logical device
     createLogicalDevice();
     
-    m_renderStorage = new RenderStorage( m_device, m_physicalDevice );
+    m_renderStorage = new RenderStorage( m_device, m_physicalDevice, MAX_FRAMES_IN_FLIGHT, m_vertexEncoding, m_poolEntryBytes );
     
     // Create the swap chain
     createSwapChain();
     createImageViews();
     
+    createRenderResources();
+}
+
+void MlnInstance::initOffscreen( uint32_t i_width, uint32_t i_height, uint32_t i_ringDepth )
+{
+    createInstance( true );
+    
+    // Choose our physical device, no surface means no present support required
+    m_physicalDevice = pickPhysicalDevice( m_vkInstance, nullptr );
+    
+    // Create logical device
+    createLogicalDevice();
+    
+    m_renderStorage = new RenderStorage( m_device, m_physicalDevice, MAX_FRAMES_IN_FLIGHT, m_vertexEncoding, m_poolEntryBytes );
+    
+    // Render into our own images instead of a swap chain
+    createOffscreenTarget( i_width, i_height, i_ringDepth );
+    createImageViews();
+    
+    createRenderResources();
+}
+
+void MlnInstance::createInstance( bool i_headless )
+{
+    Instance instance = Instance::create( m_enableValidation, i_headless );
+    m_vkInstance = instance.getObject();
+    
+    if ( m_enableValidation )
+    {
+        setupDebugging( m_vkInstance, m_debugMessenger );
+    }
+}
+
+void MlnInstance::createRenderResources()
+{
     createRenderPass();
     
     // Create our pipeline
@@ -518,12 +624,29 @@ void MlnInstance::init( void* i_layer )
     createUniformBuffers();
     createDescriptorPool();
     createDescriptorSets();
+    createGpuCuller();
     
     createSyncObjects();
+    createRecorders();
 }
 
 void MlnInstance::deinit()
 {
+    // Frames may still be in flight, offscreen rendering never waits on present
+    vkDeviceWaitIdle( m_device->getObject() );
+    
+    // Deferred pool frees reference the render storage
+    m_device->getUploadScheduler()->retireAll();
+    
+    m_jobSystem->destroy();
+    m_taskQueue->destroy();
+    m_secondaryCommandPools->destroy();
+    
+    if ( m_gpuCuller )
+    {
+        m_gpuCuller->destroy();
+    }
+    
     for ( size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
     {
         vkDestroySemaphore( m_device->getObject(), m_imageAvailableSemaphores[ i ], nullptr );
@@ -531,14 +654,18 @@ void MlnInstance::deinit()
         vkDestroyFence( m_device->getObject(), m_inFlightFences[ i ], nullptr );
     }
 
-    for ( auto framebuffer : m_swapChainFramebuffers )
+    for ( auto framebuffer : m_framebuffers )
     {
         vkDestroyFramebuffer( m_device->getObject(), framebuffer, nullptr );
     }
     
     vkDestroyDescriptorPool( m_device->getObject(), m_descriptorPool, nullptr );
     vkDestroyDescriptorSetLayout( m_device->getObject(), m_descriptorSetLayout, nullptr );
-    m_pipeline->destroy();
+    for ( const auto &[ layoutKey, pipeline ] : m_pipelines )
+    {
+        pipeline->destroy();
+    }
+    m_pipelines.clear();
     vkDestroyRenderPass( m_device->getObject(), m_renderPass, nullptr );
     
     for ( BufferTPtr< UniformBufferObject > buffer : m_uniformBuffers )
@@ -546,15 +673,24 @@ void MlnInstance::deinit()
         buffer->destroy();
     }
     m_uniformBuffers.clear();
+    m_boundTransformBuffers.clear();
 
     vkDestroyDescriptorSetLayout(m_device->getObject(), m_descriptorSetLayout, nullptr);
 
-    for ( VkImageView imageView : m_swapChainImageViews )
+    for ( VkImageView imageView : m_imageViews )
     {
         vkDestroyImageView( m_device->getObject(), imageView, nullptr );
     }
     
-    m_swapChain->destroy();
+    if ( m_swapChain )
+    {
+        m_swapChain->destroy();
+    }
+    
+    if ( m_offscreenTarget )
+    {
+        m_offscreenTarget->destroy();
+    }
     
     delete m_renderStorage;
     
@@ -565,7 +701,11 @@ void MlnInstance::deinit()
         destroyDebugUtilsMessengerEXT( m_vkInstance, m_debugMessenger, nullptr );
     }
     
-    m_surface->destroy();
+    if ( m_surface )
+    {
+        m_surface->destroy();
+    }
+    
     vkDestroyInstance( m_vkInstance, nullptr );
 }
 
@@ -575,42 +715,161 @@ void MlnInstance::drawFrame( ScenePtr i_scene )
     i_scene->update();
     
     vkWaitForFences( m_device->getObject(), 1, &m_inFlightFences[ m_currentFrame ], VK_TRUE, UINT64_MAX );
+    
+    // Anything this frame slot copied back is now on the host
+    completeReadback( m_currentFrame );
+    
+    // And anything it stopped using can be released
+    m_device->getUploadScheduler()->retire( m_currentFrame );
+    
     vkResetFences( m_device->getObject(), 1, &m_inFlightFences[ m_currentFrame ] );
 
     uint32_t imageIndex;
-    m_swapChain->acquireImage( m_imageAvailableSemaphores[ m_currentFrame ], VK_NULL_HANDLE, imageIndex );
+    if ( m_swapChain )
+    {
+        m_swapChain->acquireImage( m_imageAvailableSemaphores[ m_currentFrame ], VK_NULL_HANDLE, imageIndex );
+    }
+    else
+    {
+        imageIndex = static_cast< uint32_t >( m_frameNumber % m_offscreenTarget->getImageCount() );
+        
+        // We are about to overwrite this image, drop it if it was never read
+        const auto overwritten = std::remove_if( m_completedReadbacks.begin(), m_completedReadbacks.end(), [ imageIndex ]( const PendingReadback &i_readback ) {
+            return i_readback.imageIndex == imageIndex;
+        });
+        m_completedReadbacks.erase( overwritten, m_completedReadbacks.end() );
+    }
     
-    updateUniformBuffer( 0 );
+    updateUniformBuffer( m_currentFrame );
     
-    CommandBufferPtr commandBuffer = m_device->getCommandBuffer( QueueTypeGraphics, m_currentFrame );
-    commandBuffer->reset();
-
-    recordCommandBuffer( commandBuffer, imageIndex );
+    // Compaction moves draws between batches, so it runs before they are uploaded
+    m_renderStorage->defragment();
+    
+    // One LOD per geometry keeps instances, culling only ever hides those
+    m_renderStorage->selectLODs( i_scene->getTransformStore(), LODSelector( m_view, m_projection, m_extent.height, i_scene->getLODBias() ) );
+    
+    // The device culls as part of the recorded frame
+    if ( !m_gpuCuller )
+    {
+        m_renderStorage->cull( i_scene->getTransformStore(), Frustum( m_viewProjection ) );
+    }
+    
+    // Only draws and matrices that changed since this frame slot was last used get uploaded
+    m_renderStorage->updateIndirectBatches( m_currentFrame );
+    m_renderStorage->updateTransforms( i_scene->getTransformStore(), m_currentFrame );
+    updateTransformDescriptor( m_currentFrame );
+    
+    // Everything staged for this frame goes out on the transfer queue now,
+    // the graphics submission waits on it
+    UploadSchedulerPtr uploadScheduler = m_device->getUploadScheduler();
+    uploadScheduler->submit( m_currentFrame );
+    
+    // Images cycle independently of frame slots, each pair keeps its own
+    // recording. Its last submission used this slot's fence, so it is idle
+    const uint32_t recordIndex = getRecordIndex( imageIndex );
+    CommandBufferPtr commandBuffer = m_recordedCommandBuffers[ recordIndex ];
+    
+    // Buffer moves belong to this frame only, a recording holding them can
+    // not be submitted again
+    const RecordedFrame recorded {
+        .sceneRevision = i_scene->getRevision(),
+        .storageRevision = m_renderStorage->getRevision(),
+        .renderStateRevision = m_renderStateRevision,
+        .reusable = !m_renderStorage->hasPendingMoves(),
+    };
+    
+    // Static scenes resubmit what this slot and image recorded last time
+    RecordedFrame &cached = m_recordedFrames[ recordIndex ];
+    m_recordStats = RecordStats();
+    if ( !cached.reusable || !recorded.reusable || !cached.matches( recorded ) )
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        
+        m_secondaryCommandPools->reset( recordIndex );
+        commandBuffer->reset();
+        
+        recordCommandBuffer( commandBuffer, imageIndex );
+        cached = recorded;
+        
+        m_recordStats.milliseconds = std::chrono::duration< double, std::milli >( std::chrono::high_resolution_clock::now() - start ).count();
+    }
+    else
+    {
+        m_recordStats.reused = true;
+    }
+    
+    // Acquire barriers change with every upload, so they go in a buffer of
+    // their own that runs ahead of the recording and leaves it reusable
+    std::vector< VkCommandBuffer > vkCommandBuffers;
+    if ( uploadScheduler->hasAcquireBarriers() )
+    {
+        CommandBufferPtr acquireCommandBuffer = m_device->getCommandBuffer( QueueTypeGraphics, m_currentFrame );
+        acquireCommandBuffer->reset();
+        
+        {
+            CommandBufferRecordPtr scopedRecord = acquireCommandBuffer->scopedRecord( VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT );
+            uploadScheduler->recordAcquire( acquireCommandBuffer->getObject() );
+        }
+        
+        vkCommandBuffers.push_back( acquireCommandBuffer->getObject() );
+    }
+    
+    vkCommandBuffers.push_back( commandBuffer->getObject() );
     
     VkSubmitInfo submitInfo {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO
     };
-
-    VkSemaphore waitSemaphores[] = { m_imageAvailableSemaphores[ m_currentFrame ] };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-    
-    submitInfo.commandBufferCount = 1;
     
-    VkCommandBuffer vkCommandBuffer = commandBuffer->getObject();
-    submitInfo.pCommandBuffers = &vkCommandBuffer;
+    // Uploads come first, binary semaphores ignore their timeline value
+    std::vector< VkSemaphore > waitSemaphores = { uploadScheduler->getSemaphore() };
+    std::vector< VkPipelineStageFlags > waitStages = { uploadScheduler->getWaitStages() };
+    std::vector< uint64_t > waitValues = { uploadScheduler->getSubmittedValue() };
     
     VkSemaphore signalSemaphores[] = { m_renderFinishedSemaphores[ m_currentFrame ] };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    
+    // Offscreen frames have no image to wait for and nothing to present
+    if ( m_swapChain )
+    {
+        waitSemaphores.push_back( m_imageAvailableSemaphores[ m_currentFrame ] );
+        waitStages.push_back( VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT );
+        waitValues.push_back( 0 );
+        
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+    }
+    
+    std::vector< uint64_t > signalValues( submitInfo.signalSemaphoreCount, 0 );
+    
+    VkTimelineSemaphoreSubmitInfo timelineInfo {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount = static_cast< uint32_t >( waitValues.size() ),
+        .pWaitSemaphoreValues = waitValues.data(),
+        .signalSemaphoreValueCount = static_cast< uint32_t >( signalValues.size() ),
+        .pSignalSemaphoreValues = signalValues.data(),
+    };
+    
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = static_cast< uint32_t >( waitSemaphores.size() );
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    
+    submitInfo.commandBufferCount = static_cast< uint32_t >( vkCommandBuffers.size() );
+    submitInfo.pCommandBuffers = vkCommandBuffers.data();
 
     if ( vkQueueSubmit( m_graphicsQueue, 1, &submitInfo, m_inFlightFences[ m_currentFrame ] ) != VK_SUCCESS )
     {
         throw std::runtime_error( "Error: Failed to submit draw command buffer!" );
     }
     
+    if ( m_offscreenTarget )
+    {
+        m_inFlightReadbacks[ m_currentFrame ] = PendingReadback { m_frameNumber, imageIndex };
+        
+        m_frameNumber++;
+        m_currentFrame = ( m_currentFrame + 1 ) % MAX_FRAMES_IN_FLIGHT;
+        return;
+    }
+    
     VkPresentInfoKHR presentInfo {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -625,9 +884,62 @@ void MlnInstance::drawFrame( ScenePtr i_scene )
 
     vkQueuePresentKHR( m_presentQueue, &presentInfo );
     
+    m_frameNumber++;
     m_currentFrame = ( m_currentFrame + 1 ) % MAX_FRAMES_IN_FLIGHT;
 }
 
+bool MlnInstance::readFrame( FrameReadback &o_frame )
+{
+    if ( !m_offscreenTarget )
+    {
+        return false;
+    }
+    
+    // Pick up any frames that have finished since we last looked, without blocking
+    for ( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        if ( m_inFlightReadbacks[ i ].has_value() && vkGetFenceStatus( m_device->getObject(), m_inFlightFences[ i ] ) == VK_SUCCESS )
+        {
+            completeReadback( i );
+        }
+    }
+    
+    if ( m_completedReadbacks.empty() )
+    {
+        return false;
+    }
+    
+    const PendingReadback readback = m_completedReadbacks.front();
+    m_completedReadbacks.pop_front();
+    
+    o_frame.frameNumber = readback.frameNumber;
+    o_frame.width = m_extent.width;
+    o_frame.height = m_extent.height;
+    o_frame.pixels = m_offscreenTarget->getPixels( readback.imageIndex );
+    
+    return true;
+}
+
+void MlnInstance::completeReadback( uint32_t i_frame )
+{
+    if ( !m_offscreenTarget || !m_inFlightReadbacks[ i_frame ].has_value() )
+    {
+        return;
+    }
+    
+    const PendingReadback readback = m_inFlightReadbacks[ i_frame ].value();
+    m_inFlightReadbacks[ i_frame ].reset();
+    
+    // The copy has landed, make it visible to the host
+    m_offscreenTarget->invalidatePixels( readback.imageIndex );
+    
+    // Fences can be polled out of order, keep readbacks sorted by frame
+    const auto itr = std::upper_bound( m_completedReadbacks.begin(), m_completedReadbacks.end(), readback, []( const PendingReadback &i_lhs, const PendingReadback &i_rhs ) {
+        return i_lhs.frameNumber < i_rhs.frameNumber;
+    });
+    m_completedReadbacks.insert( itr, readback );
+}
+
 void MlnInstance::updateUniformBuffer( uint32_t currentImage )
 {
     static auto startTime = std::chrono::high_resolution_clock::now();
@@ -635,41 +947,128 @@ void MlnInstance::updateUniformBuffer( uint32_t currentImage )
     auto currentTime = std::chrono::high_resolution_clock::now();
     float time = std::chrono::duration< float, std::chrono::seconds::period >( currentTime - startTime ).count();
     
-    VkExtent2D extend = m_swapChain->getExtent();
+    VkExtent2D extend = m_extent;
     
     UniformBufferObject ubo {};
-    ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     ubo.projection = glm::perspective(glm::radians(45.0f), extend.width / (float) extend.height, 0.1f, 10.0f);
     ubo.projection[1][1] *= -1;
     
+    m_view = ubo.view;
+    m_projection = ubo.projection;
+    m_viewProjection = ubo.projection * ubo.view;
+    
     memcpy( m_uniformBuffersMapped[ currentImage ], &ubo, sizeof( ubo ) );
 }
 
+void MlnInstance::updateTransformDescriptor( uint32_t i_frame )
+{
+    BufferTPtr< Mat4f > transformBuffer = m_renderStorage->getTransformBuffer( i_frame );
+    if ( transformBuffer == m_boundTransformBuffers[ i_frame ] )
+    {
+        return;
+    }
+    
+    // The set is not in use, this frame's fence has been waited on
+    VkDescriptorBufferInfo bufferInfo {
+        .buffer = transformBuffer->getObject(),
+        .offset = 0,
+        .range = VK_WHOLE_SIZE,
+    };
+    
+    VkWriteDescriptorSet descriptorWrite {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = m_descriptorSets[ i_frame ],
+        .dstBinding = 1,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo = &bufferInfo,
+    };
+    
+    vkUpdateDescriptorSets( m_device->getObject(), 1, &descriptorWrite, 0, nullptr );
+    m_boundTransformBuffers[ i_frame ] = transformBuffer;
+}
+
+void MlnInstance::setVertexEncoding( VertexEncoding i_encoding )
+{
+    m_vertexEncoding = i_encoding;
+}
+
+void MlnInstance::setPoolEntrySize( size_t i_bytes )
+{
+    m_poolEntryBytes = i_bytes;
+}
+
 RenderStorage & MlnInstance::getRenderStorage()
 {
     return *m_renderStorage;
 }
 
+JobSystem & MlnInstance::getJobSystem()
+{
+    return *m_jobSystem;
+}
+
+TaskQueue & MlnInstance::getTaskQueue()
+{
+    return *m_taskQueue;
+}
+
+void MlnInstance::setRecordChunkSize( size_t i_chunkSize )
+{
+    if ( i_chunkSize == 0 )
+    {
+        throw std::runtime_error( "Error: Record chunk size must be at least one batch." );
+    }
+    
+    m_recordChunkSize = i_chunkSize;
+    m_renderStateRevision++;
+}
+
+const RecordStats & MlnInstance::getRecordStats() const
+{
+    return m_recordStats;
+}
+
+std::vector< MemoryHeapStats > MlnInstance::getMemoryHeapStats()
+{
+    if ( !m_device )
+    {
+        return std::vector< MemoryHeapStats >();
+    }
+    
+    return m_device->getMemoryAllocator()->getHeapStats();
+}
+
 void MlnInstance::createLogicalDevice()
 {    
     QueueCreateCounts queuesCounts {
         { QueueTypeGraphics, 1 },
-        { QueueTypePresent,  1 },
         { QueueTypeTransfer, 1 },
     };
     QueueCreateCounts bufferCounts {
         { QueueTypeGraphics, MAX_FRAMES_IN_FLIGHT },
-        { QueueTypePresent,  MAX_FRAMES_IN_FLIGHT },
         { QueueTypeTransfer, MAX_FRAMES_IN_FLIGHT },
     };
     
+    // Only ask for a present queue when we have something to present to
+    if ( m_surface )
+    {
+        queuesCounts[ QueueTypePresent ] = 1;
+        bufferCounts[ QueueTypePresent ] = MAX_FRAMES_IN_FLIGHT;
+    }
+    
     m_device = Device::create( m_physicalDevice, m_surface, queuesCounts, bufferCounts );
     m_descriptorCache = std::make_unique< DescriptorCache >( m_device );
     
     // Get our device queues
     m_graphicsQueue = m_device->getQueue( QueueTypeGraphics, 0 );
-    m_presentQueue = m_device->getQueue( QueueTypePresent, 0 );
+    
+    if ( m_surface )
+    {
+        m_presentQueue = m_device->getQueue( QueueTypePresent, 0 );
+    }
 }
 
 void MlnInstance::createSwapChain()
@@ -705,14 +1104,28 @@ void MlnInstance::createSwapChain()
                                          presentIndex,
                                          presentMode,
                                          swapChainSupport.capabilities.currentTransform );
+    
+    m_colorFormat = m_swapChain->getFormat();
+    m_extent = m_swapChain->getExtent();
+}
+
+void MlnInstance::createOffscreenTarget( uint32_t i_width, uint32_t i_height, uint32_t i_ringDepth )
+{
+    // A frame in flight must never share an image with the frame being recorded
+    const uint32_t imageCount = std::max< uint32_t >( i_ringDepth, MAX_FRAMES_IN_FLIGHT );
+    
+    m_offscreenTarget = OffscreenTarget::create( m_device, m_physicalDevice, { i_width, i_height }, imageCount );
+    
+    m_colorFormat = m_offscreenTarget->getFormat();
+    m_extent = m_offscreenTarget->getExtent();
 }
 
 void MlnInstance::createImageViews()
 {
-    std::vector< VkImage > images = m_swapChain->getImages();
+    std::vector< VkImage > images = m_swapChain ? m_swapChain->getImages() : m_offscreenTarget->getImages();
     
     size_t imageCount = images.size();
-    m_swapChainImageViews.resize( imageCount );
+    m_imageViews.resize( imageCount );
 
     for ( size_t i = 0; i < imageCount; i++ )
     {
@@ -722,7 +1135,7 @@ void MlnInstance::createImageViews()
         imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         imageViewCreateInfo.image = image;
         imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        imageViewCreateInfo.format = m_swapChain->getFormat();
+        imageViewCreateInfo.format = m_colorFormat;
         
         imageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
         imageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -735,7 +1148,7 @@ void MlnInstance::createImageViews()
         imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
         imageViewCreateInfo.subresourceRange.layerCount = 1;
         
-        if ( vkCreateImageView( m_device->getObject(), &imageViewCreateInfo, nullptr, &m_swapChainImageViews[ i ] ) != VK_SUCCESS )
+        if ( vkCreateImageView( m_device->getObject(), &imageViewCreateInfo, nullptr, &m_imageViews[ i ] ) != VK_SUCCESS )
         {
             throw std::runtime_error( "Failed to create image views!" );
         }
@@ -745,14 +1158,14 @@ void MlnInstance::createImageViews()
 void MlnInstance::createRenderPass()
 {
     VkAttachmentDescription colorAttachment {};
-    colorAttachment.format = m_swapChain->getFormat();
+    colorAttachment.format = m_colorFormat;
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = m_swapChain ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
     
     VkAttachmentReference colorAttachmentRef {};
     colorAttachmentRef.attachment = 0;
@@ -770,7 +1183,9 @@ void MlnInstance::createRenderPass()
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
     
-    VkSubpassDependency dependency {};
+    std::array< VkSubpassDependency, 2 > dependencies {};
+    
+    VkSubpassDependency &dependency = dependencies[ 0 ];
     dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
     dependency.dstSubpass = 0;
     dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
@@ -778,8 +1193,17 @@ void MlnInstance::createRenderPass()
     dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
     
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
+    // Offscreen images are copied back to the host once the pass ends
+    VkSubpassDependency &readbackDependency = dependencies[ 1 ];
+    readbackDependency.srcSubpass = 0;
+    readbackDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    readbackDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    readbackDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    readbackDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    readbackDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    
+    renderPassInfo.dependencyCount = m_swapChain ? 1 : 2;
+    renderPassInfo.pDependencies = dependencies.data();
     
     if ( vkCreateRenderPass( m_device->getObject(), &renderPassInfo, nullptr, &m_renderPass ) != VK_SUCCESS )
     {
@@ -796,11 +1220,22 @@ void MlnInstance::createDescriptorSetLayout()
         .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
         .pImmutableSamplers = nullptr, // Optional
     };
+    
+    // World matrices, indexed by instance
+    VkDescriptorSetLayoutBinding transformLayoutBinding {
+        .binding = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .pImmutableSamplers = nullptr,
+    };
+    
+    VkDescriptorSetLayoutBinding bindings[] = { uboLayoutBinding, transformLayoutBinding };
 
     VkDescriptorSetLayoutCreateInfo layoutInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .bindingCount = 1,
-        .pBindings = &uboLayoutBinding,
+        .bindingCount = 2,
+        .pBindings = bindings,
     };
 
     if ( vkCreateDescriptorSetLayout( m_device->getObject(), &layoutInfo, nullptr, &m_descriptorSetLayout ) != VK_SUCCESS)
@@ -811,18 +1246,32 @@ void MlnInstance::createDescriptorSetLayout()
 
 void MlnInstance::createGraphicsPipeline()
 {
-    m_pipeline = GraphicsPipeline::create( m_device, m_renderPass, m_swapChain->getExtent(), m_descriptorCache );
+    m_pipelines[ VertexLayout().getKey() ] = GraphicsPipeline::create( m_device, m_renderPass, m_extent, m_descriptorCache, m_vertexEncoding, VertexLayout() );
+    m_renderStateRevision++;
+}
+
+GraphicsPipelinePtr MlnInstance::getGraphicsPipeline( const VertexLayout &i_layout )
+{
+    // New layouts only appear with new batches, which already changes the storage revision
+    GraphicsPipelinePtr &pipeline = m_pipelines[ i_layout.getKey() ];
+    if ( !pipeline )
+    {
+        pipeline = GraphicsPipeline::create( m_device, m_renderPass, m_extent, m_descriptorCache, m_vertexEncoding, i_layout );
+    }
+    
+    return pipeline;
 }
 
 void MlnInstance::createFramebuffers()
 {
-    const size_t numFramebuffers = m_swapChainImageViews.size();
-    m_swapChainFramebuffers.resize( numFramebuffers );
+    const size_t numFramebuffers = m_imageViews.size();
+    m_framebuffers.resize( numFramebuffers );
+    m_renderStateRevision++;
 
     for (size_t i = 0; i < numFramebuffers; i++)
     {
         VkImageView attachments[] = {
-            m_swapChainImageViews[ i ]
+            m_imageViews[ i ]
         };
 
         VkFramebufferCreateInfo framebufferInfo{};
@@ -830,11 +1279,11 @@ void MlnInstance::createFramebuffers()
         framebufferInfo.renderPass = m_renderPass;
         framebufferInfo.attachmentCount = 1;
         framebufferInfo.pAttachments = attachments;
-        framebufferInfo.width = m_swapChain->getExtent().width;
-        framebufferInfo.height = m_swapChain->getExtent().height;
+        framebufferInfo.width = m_extent.width;
+        framebufferInfo.height = m_extent.height;
         framebufferInfo.layers = 1;
 
-        if ( vkCreateFramebuffer( m_device->getObject(), &framebufferInfo, nullptr, &m_swapChainFramebuffers[ i ] ) != VK_SUCCESS )
+        if ( vkCreateFramebuffer( m_device->getObject(), &framebufferInfo, nullptr, &m_framebuffers[ i ] ) != VK_SUCCESS )
         {
             throw std::runtime_error("failed to create framebuffer!");
         }
@@ -871,15 +1320,21 @@ void MlnInstance::createUniformBuffers()
 
 void MlnInstance::createDescriptorPool()
 {
-    VkDescriptorPoolSize poolSize {
-        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .descriptorCount = static_cast< uint32_t >( MAX_FRAMES_IN_FLIGHT )
+    VkDescriptorPoolSize poolSizes[] = {
+        {
+            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount = static_cast< uint32_t >( MAX_FRAMES_IN_FLIGHT )
+        },
+        {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = static_cast< uint32_t >( MAX_FRAMES_IN_FLIGHT )
+        },
     };
     
     VkDescriptorPoolCreateInfo poolInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .poolSizeCount = 1,
-        .pPoolSizes = &poolSize,
+        .poolSizeCount = 2,
+        .pPoolSizes = poolSizes,
         .maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT),
     };
     
@@ -901,6 +1356,7 @@ void MlnInstance::createDescriptorSets()
     };
     
     m_descriptorSets.resize( MAX_FRAMES_IN_FLIGHT );
+    m_boundTransformBuffers.assign( MAX_FRAMES_IN_FLIGHT, nullptr );
     if ( vkAllocateDescriptorSets( m_device->getObject(), &allocInfo, m_descriptorSets.data() ) != VK_SUCCESS )
     {
         throw std::runtime_error("failed to allocate descriptor sets!");
@@ -931,75 +1387,148 @@ void MlnInstance::createDescriptorSets()
     }
 }
 
+void MlnInstance::createGpuCuller()
+{
+    // Counts are written by the cull pass, so both features are needed. Culling
+    // runs on the graphics queue, the draws consume it in the same submission.
+    const bool drawIndirectCount = m_device->getEnabledVulkan12Features().drawIndirectCount;
+    const bool multiDraw = m_device->getEnabledFeatures().multiDrawIndirect;
+    if ( !drawIndirectCount || !multiDraw || !m_device->getQueueFamily( QueueTypeGraphics ).hasCompute() )
+    {
+        return;
+    }
+    
+    m_gpuCuller = GpuCuller::create( m_device, m_descriptorCache, MAX_FRAMES_IN_FLIGHT );
+    m_renderStorage->setGpuCulling( true );
+}
+
 void MlnInstance::recordCommandBuffer( CommandBufferPtr commandBuffer, uint32_t imageIndex )
 {
-    const VkExtent2D &extent = m_swapChain->getExtent();
+    const VkExtent2D &extent = m_extent;
+    
+    const bool multiDraw = m_device->getEnabledFeatures().multiDrawIndirect;
+    const uint32_t maxDrawCount = multiDraw ? m_physicalDevice->getProperties().limits.maxDrawIndirectCount : 1;
+    
+    // Pipelines are created here, the chunks below only look them up
+    const IndirectBatches &indirectBatches = m_renderStorage->getIndirectBatches();
+    std::vector< const IndirectBatch* > batches;
+    std::vector< GraphicsPipelinePtr > batchPipelines;
+    batches.reserve( indirectBatches.size() );
+    batchPipelines.reserve( indirectBatches.size() );
+    for ( const auto &pair : indirectBatches )
+    {
+        batches.push_back( &pair.second );
+        batchPipelines.push_back( getGraphicsPipeline( pair.second.layout ) );
+    }
+    
+    VkBuffer defaultAttributes = m_renderStorage->getDefaultAttributeBuffer()->getObject();
+    
+    // Secondaries live as long as the slot and image recording they belong to
+    const uint32_t recordIndex = getRecordIndex( imageIndex );
+    
+    VkCommandBufferInheritanceInfo inheritance {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = m_renderPass,
+        .subpass = 0,
+        .framebuffer = m_framebuffers[ imageIndex ],
+    };
     
-    CommandPtr beginPass = CommandFactory::beginRenderPass( m_renderPass, m_swapChainFramebuffers[ imageIndex ], extent );
-    CommandPtr bind = CommandFactory::bindPipeline( m_pipeline );
-    CommandPtr viewport = CommandFactory::setViewport( Vec2f( 0.0 ), Vec2f( extent.width, extent.height ) );
-    CommandPtr scissor = CommandFactory::setScissor( Vec2i( 0 ), Vec2u( extent.width, extent.height ) );
-    CommandPtr endPass = CommandFactory::endRenderPass();
+    // Chunks of batches are recorded in parallel, each into its own secondary
+    // buffer. State is not inherited by secondaries so every chunk sets it up.
+    const size_t chunkCount = ( batches.size() + m_recordChunkSize - 1 ) / m_recordChunkSize;
+    std::vector< VkCommandBuffer > secondaries( chunkCount );
     
-    std::vector< CommandPtr > drawCommands;
+    m_recordStats.batchCount = static_cast< uint32_t >( batches.size() );
+    m_recordStats.chunkCount = static_cast< uint32_t >( chunkCount );
     
-    std::vector< ObjectId > geometryIds = m_renderStorage->getGeometryIds();
-    for ( ObjectId geometryId : geometryIds )
+    if ( m_chunkStreams.size() < chunkCount )
     {
-        const MeshLODs* lod = m_renderStorage->getLODs( geometryId );
-        if ( lod == nullptr )
-        {
-            continue;
-        }
+        m_chunkStreams.resize( chunkCount );
+    }
+    
+    m_jobSystem->parallelFor( batches.size(), m_recordChunkSize, [ & ]( uint32_t i_threadIndex, size_t i_chunkIndex, size_t i_begin, size_t i_end ) {
+        
+        CommandStream &stream = m_chunkStreams[ i_chunkIndex ];
+        stream.clear();
         
-        for ( const auto &pair : lod->meshLODs )
+        // Every pipeline shares the descriptor set layout, so the set survives pipeline changes
+        CommandFactory::bindPipeline( stream, batchPipelines[ i_begin ] );
+        CommandFactory::setViewport( stream, Vec2f( 0.0 ), Vec2f( extent.width, extent.height ) );
+        CommandFactory::setScissor( stream, Vec2i( 0 ), Vec2u( extent.width, extent.height ) );
+        CommandFactory::bindDescriptorSet( stream, batchPipelines[ i_begin ]->getLayout(), m_descriptorSets[ m_currentFrame ] );
+        CommandFactory::bindVertexBuffer( stream, s_defaultAttributeBinding, defaultAttributes, 0 );
+        
+        // One bind and one indirect draw per vertex and index pool entry pair.
+        // Batches are sorted by layout, so pipelines change rarely.
+        for ( size_t i = i_begin; i < i_end; i++ )
         {
-            const MeshStorage &lodStorage = pair.second;
-            if ( lodStorage.indexCount == 0 )
+            const IndirectBatch &batch = *batches[ i ];
+            
+            VkBuffer indirectBuffer = batch.indirectBuffers[ m_currentFrame ]->getObject();
+            const uint32_t drawCount = static_cast< uint32_t >( batch.commands.size() );
+            
+            if ( i > i_begin && batchPipelines[ i ] != batchPipelines[ i - 1 ] )
             {
-                continue;
+                CommandFactory::bindPipeline( stream, batchPipelines[ i ] );
             }
             
-            auto func = [ this, &lodStorage ]( VkCommandBuffer i_commandBuffer ) {
-                
-                VkBuffer vertexBuffers[] = { lodStorage.vertexHandle.buffer->getObject() };
-                VkDeviceSize offsets[] = { lodStorage.vertexHandle.allocation.offset };
-                vkCmdBindVertexBuffers( i_commandBuffer, 0, 1, vertexBuffers, offsets );
-                vkCmdBindIndexBuffer( i_commandBuffer, lodStorage.indexHandle.buffer->getObject(), 0, VK_INDEX_TYPE_UINT32 );
-
-                vkCmdBindDescriptorSets( i_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline->getLayout(), 0, 1, &m_descriptorSets[ 0 ], 0, nullptr );
-                
-//                vkCmdDrawIndexed( i_commandBuffer, lodStorage.indexCount, 1, 0, 0, 0 );
-                
-                VkDrawIndexedIndirectCommand drawIndirect {
-                    .indexCount = lodStorage.indexCount,
-                    .instanceCount = 1,
-                    .firstIndex = 0,
-                    .vertexOffset = 0,
-                    .firstInstance = 0,
-                };
-                
-                BufferTPtr< VkDrawIndexedIndirectCommand > indirectBuffer = m_renderStorage->getIndirectBuffer();  
-                std::vector< VkDrawIndexedIndirectCommand > indirectCommands = { drawIndirect };
-                indirectBuffer->updateData( indirectCommands, 0 );
-                vkCmdDrawIndexedIndirect( i_commandBuffer, indirectBuffer->getObject(), 0, 1, sizeof( VkDrawIndexedIndirectCommand ) );
-            };
+            // Separate layouts bind the one buffer once per stream
+            for ( size_t binding = 0; binding < batch.vertexOffsets.size(); binding++ )
+            {
+                CommandFactory::bindVertexBuffer( stream, static_cast< uint32_t >( binding ), batch.vertexBuffer->getObject(), batch.vertexOffsets[ binding ] );
+            }
+            
+            CommandFactory::bindIndexBuffer( stream, batch.indexBuffer->getObject(), 0, VK_INDEX_TYPE_UINT32 );
+            
+            // Survivors follow the count in the first slot
+            if ( m_gpuCuller )
+            {
+                VkBuffer visibleBuffer = batch.visibleBuffers[ m_currentFrame ]->getObject();
+                const VkDeviceSize stride = sizeof( VkDrawIndexedIndirectCommand );
+                CommandFactory::drawIndexedIndirectCount( stream, visibleBuffer, stride, visibleBuffer, 0, std::min( maxDrawCount, drawCount ), stride );
+                continue;
+            }
             
-            drawCommands.emplace_back( CommandFactory::commandFunction( func ) );
+            // Without multiDrawIndirect this falls back to one draw per entry
+            for ( uint32_t first = 0; first < drawCount; first += maxDrawCount )
+            {
+                const uint32_t count = std::min( maxDrawCount, drawCount - first );
+                const VkDeviceSize offset = first * sizeof( VkDrawIndexedIndirectCommand );
+                CommandFactory::drawIndexedIndirect( stream, indirectBuffer, offset, count, sizeof( VkDrawIndexedIndirectCommand ) );
+            }
         }
+        
+        VkCommandBuffer secondary = m_secondaryCommandPools->begin( recordIndex, i_threadIndex, inheritance );
+        stream.replay( secondary );
+        vkEndCommandBuffer( secondary );
+        
+        secondaries[ i_chunkIndex ] = secondary;
+    });
+    
+    CommandStream &stream = commandBuffer->getStream();
+    
+    CommandFactory::callback( stream, []( VkCommandBuffer i_commandBuffer, void* i_context ) {
+        static_cast< RenderStorage* >( i_context )->recordMoves( i_commandBuffer );
+    }, m_renderStorage );
+    
+    // Compute work is not allowed inside the pass that draws the survivors
+    if ( m_gpuCuller )
+    {
+        m_gpuCuller->prepare( m_currentFrame, *m_renderStorage, m_uniformBuffers[ m_currentFrame ] );
+        
+        CommandFactory::callback( stream, []( VkCommandBuffer i_commandBuffer, void* i_context ) {
+            static_cast< GpuCuller* >( i_context )->recordDispatches( i_commandBuffer );
+        }, m_gpuCuller.get() );
     }
 
-    commandBuffer->addCommand( std::move( beginPass ) );
-    commandBuffer->addCommand( std::move( bind ) );
-    commandBuffer->addCommand( std::move( viewport ) );
-    commandBuffer->addCommand( std::move( scissor ) );
+    CommandFactory::beginRenderPass( stream, m_renderPass, m_framebuffers[ imageIndex ], extent, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+    CommandFactory::executeCommands( stream, secondaries );
+    CommandFactory::endRenderPass( stream );
     
-    for ( CommandPtr &drawCommand : drawCommands )
+    if ( m_offscreenTarget )
     {
-        commandBuffer->addCommand( std::move( drawCommand ) );
+        CommandFactory::copyImageToBuffer( stream, m_offscreenTarget->getImage( imageIndex ), m_offscreenTarget->getReadbackBuffer( imageIndex ), extent );
     }
-    
-    commandBuffer->addCommand( std::move( endPass ) );
 
     commandBuffer->record( 0 );
 }
@@ -1045,6 +1574,26 @@ void MlnInstance::createSyncObjects()
         s_createFence( m_device->getObject(), inFlightFence );
         m_inFlightFences.push_back( inFlightFence );
     }
+    
+    m_inFlightReadbacks.resize( MAX_FRAMES_IN_FLIGHT );
+}
+
+void MlnInstance::createRecorders()
+{
+    const uint32_t hardwareThreads = std::max( std::thread::hardware_concurrency(), 1u );
+    m_jobSystem = JobSystem::create( std::min( hardwareThreads - 1, s_maxRecordWorkers ) );
+    m_taskQueue = TaskQueue::create( s_backgroundWorkers );
+    
+    const uint32_t graphicsFamily = m_device->getQueueFamilyIndex( QueueTypeGraphics );
+    const uint32_t recordCount = MAX_FRAMES_IN_FLIGHT * static_cast< uint32_t >( m_framebuffers.size() );
+    m_secondaryCommandPools = SecondaryCommandPools::create( m_device, graphicsFamily, m_jobSystem->getThreadCount(), recordCount );
+    m_recordedCommandBuffers = m_device->allocateCommandBuffers( QueueTypeGraphics, recordCount );
+    m_recordedFrames.resize( recordCount );
+}
+
+uint32_t MlnInstance::getRecordIndex( uint32_t i_imageIndex ) const
+{
+    return m_currentFrame * static_cast< uint32_t >( m_framebuffers.size() ) + i_imageIndex;
 }
 
 } // namespace marlin
@@ -10,14 +10,19 @@
 #define MARLIN_INSTANCE_HPP
 
 #include <marlin/scene/scene.hpp>
+#include <marlin/vulkan/commands.hpp>
 #include <marlin/vulkan/../defs.hpp>
 #include <marlin/vulkan/defs.hpp>
+#include <marlin/vulkan/offscreenTarget.hpp>
 #include <marlin/vulkan/pipeline.hpp>
+#include <marlin/vulkan/secondaryCommandPools.hpp>
 #include <marlin/vulkan/vkObject.hpp>
 
 #include <vulkan/vulkan.h>
 
 #include <array>
+#include <deque>
+#include <optional>
 #include <vector>
 
 namespace marlin
@@ -27,7 +32,7 @@ class Instance : public VkObjectT< VkInstance >
 {
 public:
     
-    static Instance create( bool i_enableValidation );
+    static Instance create( bool i_enableValidation, bool i_headless );
     
     Instance() = default;
     explicit Instance( VkInstance i_instance );
@@ -60,13 +65,32 @@ public:
     
     static MlnInstance & getInstance();
     
+    // Takes effect at init, the vertex pool and pipeline are built for it
+    void setVertexEncoding( VertexEncoding i_encoding );
+    
+    // Takes effect at init, the index pool is created with it
+    void setPoolEntrySize( size_t i_bytes );
+    
     void init( void* i_layer );
+    void initOffscreen( uint32_t i_width, uint32_t i_height, uint32_t i_ringDepth );
     void deinit();
     
     void drawFrame( ScenePtr i_scene );
+    bool readFrame( FrameReadback &o_frame );
     void updateUniformBuffer(uint32_t currentImage);
+    void updateTransformDescriptor( uint32_t i_frame );
     
     RenderStorage & getRenderStorage();
+    JobSystem & getJobSystem();
+    TaskQueue & getTaskQueue();
+    
+    // Indirect batches per secondary command buffer, the next frame is
+    // recorded again with it
+    void setRecordChunkSize( size_t i_chunkSize );
+    const RecordStats & getRecordStats() const;
+    
+    // Empty until a device has been created
+    std::vector< MemoryHeapStats > getMemoryHeapStats();
 
     MlnInstance( MlnInstance const &i_instance ) = delete;
     void operator=( MlnInstance const &i_instance )  = delete;
@@ -88,19 +112,82 @@ private:
     std::vector<void*> m_uniformBuffersMapped;
     VkDescriptorPool m_descriptorPool;
     std::vector<VkDescriptorSet> m_descriptorSets;
+    std::vector< BufferTPtr< Mat4f > > m_boundTransformBuffers;
+    
+    // Camera of the frame being built, draws are culled and LODs chosen against it
+    Mat4f m_view;
+    Mat4f m_projection;
+    Mat4f m_viewProjection;
+    
+    VertexEncoding m_vertexEncoding = VertexEncoding::Float;
+    size_t m_poolEntryBytes;
+    
+    // Culls on the device when draw counts can be read from a buffer
+    GpuCullerPtr m_gpuCuller;
     
     SwapChainPtr m_swapChain;
-    std::vector< VkImageView > m_swapChainImageViews;
+    OffscreenTargetPtr m_offscreenTarget;
+    
+    VkFormat m_colorFormat;
+    VkExtent2D m_extent;
+    std::vector< VkImageView > m_imageViews;
     
     VkRenderPass m_renderPass;
     VkDescriptorSetLayout m_descriptorSetLayout;
-    GraphicsPipelinePtr m_pipeline;
-    std::vector< VkFramebuffer > m_swapChainFramebuffers;
+    
+    // Keyed by vertex layout, layouts other than the default are built when first drawn
+    std::map< uint8_t, GraphicsPipelinePtr > m_pipelines;
+    std::vector< VkFramebuffer > m_framebuffers;
     
     std::vector< VkSemaphore > m_imageAvailableSemaphores;
     std::vector< VkSemaphore > m_renderFinishedSemaphores;
     std::vector< VkFence > m_inFlightFences;
     
+    // Draw recording is split across threads into secondary command buffers
+    JobSystemPtr m_jobSystem;
+    
+    // Work that may span frames, like LOD generation
+    TaskQueuePtr m_taskQueue;
+    SecondaryCommandPoolsPtr m_secondaryCommandPools;
+    std::vector< CommandStream > m_chunkStreams;
+    size_t m_recordChunkSize;
+    RecordStats m_recordStats;
+    
+    // What each recording was last made against. Recordings bind the frame
+    // slot's buffers and the image's framebuffer, so there is one per
+    // frame slot and image pair, see getRecordIndex
+    struct RecordedFrame
+    {
+        uint64_t sceneRevision = 0;
+        uint64_t storageRevision = 0;
+        uint64_t renderStateRevision = 0;
+        bool reusable = false;
+        
+        bool matches( const RecordedFrame &i_other ) const
+        {
+            return sceneRevision == i_other.sceneRevision &&
+                   storageRevision == i_other.storageRevision &&
+                   renderStateRevision == i_other.renderStateRevision;
+        }
+    };
+    
+    std::vector< RecordedFrame > m_recordedFrames;
+    std::vector< CommandBufferPtr > m_recordedCommandBuffers;
+    
+    // Bumped whenever the pipeline, framebuffers or recording settings change
+    uint64_t m_renderStateRevision = 0;
+    
+    // Offscreen image written by each frame in flight, and finished frames waiting to be read
+    struct PendingReadback
+    {
+        uint64_t frameNumber;
+        uint32_t imageIndex;
+    };
+    
+    std::vector< std::optional< PendingReadback > > m_inFlightReadbacks;
+    std::deque< PendingReadback > m_completedReadbacks;
+    uint64_t m_frameNumber = 0;
+    
     RenderStorage* m_renderStorage;
 
     bool m_enableValidation;
@@ -112,20 +199,29 @@ private:
     
 private:
     
+    void createInstance( bool i_headless );
     void createLogicalDevice();
     void createSwapChain();
+    void createOffscreenTarget( uint32_t i_width, uint32_t i_height, uint32_t i_ringDepth );
     void createImageViews();
+    void createRenderResources();
     void createRenderPass();
     void createDescriptorSetLayout();
     
     void createGraphicsPipeline();
+    GraphicsPipelinePtr getGraphicsPipeline( const VertexLayout &i_layout );
     void createFramebuffers();
     void createUniformBuffers();
     void createDescriptorPool();
     void createDescriptorSets();
+    void createGpuCuller();
     
     void recordCommandBuffer( CommandBufferPtr commandBuffer, uint32_t imageIndex );
     void createSyncObjects();
+    void createRecorders();
+    uint32_t getRecordIndex( uint32_t i_imageIndex ) const;
+    
+    void completeReadback( uint32_t i_frame );
 };
 
 } // namespace marlin
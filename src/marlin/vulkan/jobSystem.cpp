@@ -0,0 +1,148 @@
+//
+//  jobSystem.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/vulkan/jobSystem.hpp>
+
+#include <algorithm>
+
+namespace marlin
+{
+
+JobSystemPtr JobSystem::create( uint32_t i_workerCount )
+{
+    return std::make_shared< JobSystem >( i_workerCount );
+}
+
+JobSystem::JobSystem( uint32_t i_workerCount )
+{
+    for ( uint32_t i = 0; i < i_workerCount; i++ )
+    {
+        m_workers.emplace_back( &JobSystem::workerLoop, this, i + 1 );
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    if ( !m_workers.empty() )
+    {
+        std::cerr << "Warning: Job system not released." << std::endl;
+        destroy();
+    }
+}
+
+void JobSystem::parallelFor( size_t i_count, size_t i_chunkSize, const JobFunction &i_job )
+{
+    const size_t chunkSize = std::max< size_t >( i_chunkSize, 1 );
+    const size_t chunkCount = ( i_count + chunkSize - 1 ) / chunkSize;
+    
+    // Not worth waking anybody
+    if ( chunkCount <= 1 || m_workers.empty() )
+    {
+        for ( size_t chunk = 0; chunk < chunkCount; chunk++ )
+        {
+            const size_t begin = chunk * chunkSize;
+            i_job( 0, chunk, begin, std::min( begin + chunkSize, i_count ) );
+        }
+        
+        return;
+    }
+    
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_job = &i_job;
+        m_count = i_count;
+        m_chunkSize = chunkSize;
+        m_chunkCount = chunkCount;
+        m_nextChunk = 0;
+        m_pendingChunks = chunkCount;
+        m_generation++;
+    }
+    
+    m_wake.notify_all();
+    runChunks( 0 );
+    
+    // Late workers may still hold the job, wait for them to let go of it too
+    std::unique_lock< std::mutex > lock( m_mutex );
+    m_done.wait( lock, [ this ] { return m_pendingChunks == 0 && m_activeWorkers == 0; } );
+    m_job = nullptr;
+}
+
+uint32_t JobSystem::getThreadCount() const
+{
+    return static_cast< uint32_t >( m_workers.size() ) + 1;
+}
+
+void JobSystem::destroy()
+{
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_stopping = true;
+    }
+    
+    m_wake.notify_all();
+    
+    for ( std::thread &worker : m_workers )
+    {
+        worker.join();
+    }
+    
+    m_workers.clear();
+}
+
+void JobSystem::workerLoop( uint32_t i_threadIndex )
+{
+    uint64_t generation = 0;
+    
+    while ( true )
+    {
+        {
+            std::unique_lock< std::mutex > lock( m_mutex );
+            m_wake.wait( lock, [ this, generation ] { return m_stopping || ( m_job != nullptr && m_generation != generation ); } );
+            
+            if ( m_stopping )
+            {
+                return;
+            }
+            
+            generation = m_generation;
+            m_activeWorkers++;
+        }
+        
+        runChunks( i_threadIndex );
+        
+        {
+            std::lock_guard< std::mutex > lock( m_mutex );
+            m_activeWorkers--;
+        }
+        
+        m_done.notify_all();
+    }
+}
+
+void JobSystem::runChunks( uint32_t i_threadIndex )
+{
+    while ( true )
+    {
+        const size_t chunk = m_nextChunk.fetch_add( 1 );
+        if ( chunk >= m_chunkCount )
+        {
+            return;
+        }
+        
+        const size_t begin = chunk * m_chunkSize;
+        ( *m_job )( i_threadIndex, chunk, begin, std::min( begin + m_chunkSize, m_count ) );
+        
+        if ( m_pendingChunks.fetch_sub( 1 ) == 1 )
+        {
+            std::lock_guard< std::mutex > lock( m_mutex );
+            m_done.notify_all();
+        }
+    }
+}
+
+} // namespace marlin
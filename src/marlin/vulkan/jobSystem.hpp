@@ -0,0 +1,72 @@
+//
+//  jobSystem.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_JOBSYSTEM_HPP
+#define MARLIN_JOBSYSTEM_HPP
+
+#include <marlin/vulkan/defs.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace marlin
+{
+
+// Receives the index of the thread running it, in [0, getThreadCount()),
+// and the chunk of the range it should process
+using JobFunction = std::function< void ( uint32_t i_threadIndex, size_t i_chunkIndex, size_t i_begin, size_t i_end ) >;
+
+// Fixed pool of worker threads that split a range into chunks. The calling
+// thread takes part as thread 0, so per thread resources can be indexed
+// directly by the thread index.
+class JobSystem
+{
+public:
+    
+    static JobSystemPtr create( uint32_t i_workerCount );
+    
+    explicit JobSystem( uint32_t i_workerCount );
+    ~JobSystem();
+    
+    // Blocks until every chunk of [0, i_count) has run
+    void parallelFor( size_t i_count, size_t i_chunkSize, const JobFunction &i_job );
+    
+    uint32_t getThreadCount() const;
+    
+    void destroy();
+    
+private:
+    
+    void workerLoop( uint32_t i_threadIndex );
+    void runChunks( uint32_t i_threadIndex );
+    
+    std::vector< std::thread > m_workers;
+    
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    
+    // The job in flight, guarded by the mutex while workers pick it up
+    const JobFunction* m_job = nullptr;
+    size_t m_count = 0;
+    size_t m_chunkSize = 0;
+    size_t m_chunkCount = 0;
+    uint64_t m_generation = 0;
+    uint32_t m_activeWorkers = 0;
+    bool m_stopping = false;
+    
+    std::atomic< size_t > m_nextChunk { 0 };
+    std::atomic< size_t > m_pendingChunks { 0 };
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_JOBSYSTEM_HPP */
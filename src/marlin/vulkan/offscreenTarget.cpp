@@ -0,0 +1,144 @@
+//
+//  offscreenTarget.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/vulkan/offscreenTarget.hpp>
+
+#include <marlin/vulkan/buffer.hpp>
+#include <marlin/vulkan/device.hpp>
+#include <marlin/vulkan/deviceMemoryAllocator.hpp>
+#include <marlin/vulkan/physicalDevice.hpp>
+
+namespace marlin
+{
+
+static const VkFormat s_offscreenFormat = VK_FORMAT_R8G8B8A8_SRGB;
+static const uint32_t s_offscreenPixelSize = 4;
+
+OffscreenTargetPtr OffscreenTarget::create( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, const VkExtent2D &i_extent, uint32_t i_imageCount )
+{
+    return std::make_shared< OffscreenTarget >( i_device, i_physicalDevice, i_extent, i_imageCount );
+}
+
+OffscreenTarget::OffscreenTarget( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, const VkExtent2D &i_extent, uint32_t i_imageCount )
+: m_device( i_device )
+, m_extent( i_extent )
+{
+    VkDevice device = i_device->getObject();
+    const size_t readbackSize = static_cast< size_t >( i_extent.width ) * i_extent.height * s_offscreenPixelSize;
+
+    for ( uint32_t i = 0; i < i_imageCount; i++ )
+    {
+        VkImageCreateInfo imageInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = s_offscreenFormat,
+            .extent = { i_extent.width, i_extent.height, 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        VkImage image;
+        if ( vkCreateImage( device, &imageInfo, nullptr, &image ) != VK_SUCCESS )
+        {
+            throw std::runtime_error( "Error: Failed to create offscreen image." );
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements( device, image, &memRequirements );
+
+        // Optimal tiling, kept apart from buffers for bufferImageGranularity
+        const MemoryAllocation memory = i_device->getMemoryAllocator()->allocate( memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryResourceType::NonLinear );
+
+        vkBindImageMemory( device, image, memory.memory, memory.offset );
+
+        m_images.push_back( image );
+        m_imageMemory.push_back( memory );
+
+        // Host side copy of the image, mapped for the lifetime of the target
+        BufferTPtr< std::byte > readbackBuffer = BufferT< std::byte >::create( i_device, i_physicalDevice, VK_BUFFER_USAGE_TRANSFER_DST_BIT, BufferMode::HostCached, nullptr, readbackSize );
+        m_readbackData.push_back( readbackBuffer->getSpan().data );
+        m_readbackBuffers.push_back( readbackBuffer );
+    }
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+    if ( !m_images.empty() )
+    {
+        std::cerr << "Warning: Offscreen target not released." << std::endl;
+    }
+}
+
+std::vector< VkImage > OffscreenTarget::getImages() const
+{
+    return m_images;
+}
+
+uint32_t OffscreenTarget::getImageCount() const
+{
+    return static_cast< uint32_t >( m_images.size() );
+}
+
+VkImage OffscreenTarget::getImage( uint32_t i_index ) const
+{
+    return m_images[ i_index ];
+}
+
+VkBuffer OffscreenTarget::getReadbackBuffer( uint32_t i_index ) const
+{
+    return m_readbackBuffers[ i_index ]->getObject();
+}
+
+const std::byte* OffscreenTarget::getPixels( uint32_t i_index ) const
+{
+    return m_readbackData[ i_index ];
+}
+
+void OffscreenTarget::invalidatePixels( uint32_t i_index )
+{
+    BufferTPtr< std::byte > &buffer = m_readbackBuffers[ i_index ];
+    buffer->invalidate( 0, buffer->getCount() );
+}
+
+VkFormat OffscreenTarget::getFormat() const
+{
+    return s_offscreenFormat;
+}
+
+const VkExtent2D & OffscreenTarget::getExtent() const
+{
+    return m_extent;
+}
+
+void OffscreenTarget::destroy()
+{
+    VkDevice device = m_device->getObject();
+
+    for ( size_t i = 0; i < m_images.size(); i++ )
+    {
+        vkDestroyImage( device, m_images[ i ], nullptr );
+        m_device->getMemoryAllocator()->free( m_imageMemory[ i ] );
+    }
+
+    for ( BufferTPtr< std::byte > &buffer : m_readbackBuffers )
+    {
+        buffer->destroy();
+    }
+
+    m_images.clear();
+    m_imageMemory.clear();
+    m_readbackBuffers.clear();
+    m_readbackData.clear();
+}
+
+} // namespace marlin
@@ -0,0 +1,64 @@
+//
+//  offscreenTarget.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_OFFSCREENTARGET_HPP
+#define MARLIN_OFFSCREENTARGET_HPP
+
+#include <marlin/stats.hpp>
+#include <marlin/vulkan/defs.hpp>
+#include <marlin/vulkan/deviceMemoryAllocator.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace marlin
+{
+
+// Ring of device local color images used in place of a swap chain when
+// rendering without a surface. Every image has a persistently mapped host
+// buffer that the frame copies its result into.
+class OffscreenTarget
+{
+public:
+
+    static OffscreenTargetPtr create( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, const VkExtent2D &i_extent, uint32_t i_imageCount );
+
+    OffscreenTarget( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, const VkExtent2D &i_extent, uint32_t i_imageCount );
+    ~OffscreenTarget();
+
+    std::vector< VkImage > getImages() const;
+    uint32_t getImageCount() const;
+
+    VkImage getImage( uint32_t i_index ) const;
+    VkBuffer getReadbackBuffer( uint32_t i_index ) const;
+    const std::byte* getPixels( uint32_t i_index ) const;
+    
+    // Readback memory is host cached, call once the copy has completed
+    void invalidatePixels( uint32_t i_index );
+
+    VkFormat getFormat() const;
+    const VkExtent2D & getExtent() const;
+
+    void destroy();
+
+private:
+
+    DevicePtr m_device;
+    VkExtent2D m_extent;
+
+    std::vector< VkImage > m_images;
+    std::vector< MemoryAllocation > m_imageMemory;
+    std::vector< BufferTPtr< std::byte > > m_readbackBuffers;
+    std::vector< const std::byte* > m_readbackData;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_OFFSCREENTARGET_HPP */
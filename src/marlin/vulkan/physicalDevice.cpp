@@ -36,6 +36,11 @@ bool QueueFamily::hasTransfer() const
 
 bool QueueFamily::isSurfaceSupported( const SurfacePtr &i_surface ) const
 {
+    if ( i_surface == nullptr )
+    {
+        return false;
+    }
+    
     VkBool32 supported = false;
     vkGetPhysicalDeviceSurfaceSupportKHR( m_physicalDevice, m_index, i_surface->getObject(), &supported );
     
@@ -99,6 +104,22 @@ VkPhysicalDeviceFeatures PhysicalDevice::getFeatures() const
     return features;
 }
 
+VkPhysicalDeviceVulkan12Features PhysicalDevice::getVulkan12Features() const
+{
+    VkPhysicalDeviceVulkan12Features vulkan12Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+    };
+    
+    VkPhysicalDeviceFeatures2 features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan12Features,
+    };
+    vkGetPhysicalDeviceFeatures2( m_object, &features );
+    
+    vulkan12Features.pNext = nullptr;
+    return vulkan12Features;
+}
+
 VkPhysicalDeviceMemoryProperties PhysicalDevice::getMemoryProperties() const
 {
     VkPhysicalDeviceMemoryProperties properties;
@@ -60,6 +60,7 @@ public:
 
     VkPhysicalDeviceProperties getProperties() const;
     VkPhysicalDeviceFeatures getFeatures() const;
+    VkPhysicalDeviceVulkan12Features getVulkan12Features() const;
     VkPhysicalDeviceMemoryProperties getMemoryProperties() const;
     
     void getQueueFamilies( QueueFamilies &o_queueFamilies ) const;
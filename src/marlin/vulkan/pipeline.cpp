@@ -59,7 +59,7 @@ VkPipelineLayout Pipeline::getLayout() const
     return m_layout;
 }
 
-GraphicsPipelinePtr GraphicsPipeline::create( DevicePtr i_device, VkRenderPass i_renderPass, const VkExtent2D &i_extent, DescriptorCachePtr &io_descriptorCache )
+GraphicsPipelinePtr GraphicsPipeline::create( DevicePtr i_device, VkRenderPass i_renderPass, const VkExtent2D &i_extent, DescriptorCachePtr &io_descriptorCache, VertexEncoding i_vertexEncoding, const VertexLayout &i_vertexLayout )
 {
     
     const std::vector< VkDescriptorSetLayout > &vertLayouts = io_descriptorCache->getLayouts( "/Users/jonathangraham/Code/Marlin/src/marlin/shaders/vert.spv" );
@@ -75,11 +75,28 @@ GraphicsPipelinePtr GraphicsPipeline::create( DevicePtr i_device, VkRenderPass i
     layouts.insert( layouts.end(), vertLayouts.begin(), vertLayouts.end() );
     layouts.insert( layouts.end(), fragLayouts.begin(), fragLayouts.end() );
 
+    // constant_id 0 in shader.vert, octahedral normals need decoding
+    const VkBool32 quantizedNormals = i_vertexEncoding == VertexEncoding::Quantized ? VK_TRUE : VK_FALSE;
+    
+    VkSpecializationMapEntry specializationEntry {
+        .constantID = 0,
+        .offset = 0,
+        .size = sizeof( VkBool32 ),
+    };
+    
+    VkSpecializationInfo specializationInfo {
+        .mapEntryCount = 1,
+        .pMapEntries = &specializationEntry,
+        .dataSize = sizeof( VkBool32 ),
+        .pData = &quantizedNormals,
+    };
+    
     VkPipelineShaderStageCreateInfo vertShaderStageInfo {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .stage = vertStage.getStage(),
         .module = vertShaderModule,
         .pName = vertStage.getEntryPoint().c_str(),
+        .pSpecializationInfo = &specializationInfo,
     };
     
     VkPipelineShaderStageCreateInfo fragShaderStageInfo {
@@ -95,13 +112,13 @@ GraphicsPipelinePtr GraphicsPipeline::create( DevicePtr i_device, VkRenderPass i
     };
     
     // Vertex format
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    auto bindingDescriptions = i_vertexLayout.getBindingDescriptions( i_vertexEncoding );
+    auto attributeDescriptions = i_vertexLayout.getAttributeDescriptions( i_vertexEncoding );
     
     VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast< uint32_t >( bindingDescriptions.size() );
+    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
     vertexInputInfo.vertexAttributeDescriptionCount = static_cast< uint32_t >( attributeDescriptions.size() );
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
     
@@ -244,4 +261,69 @@ void GraphicsPipeline::destroy()
     vkDestroyPipelineLayout( m_device->getObject(), m_layout, nullptr );
 }
 
+ComputePipelinePtr ComputePipeline::create( DevicePtr i_device, const std::string &i_path, DescriptorCachePtr &io_descriptorCache, uint32_t i_pushConstantSize )
+{
+    const std::vector< VkDescriptorSetLayout > &layouts = io_descriptorCache->getLayouts( i_path );
+    
+    ShaderStage stage( i_path );
+    VkShaderModule shaderModule = createShaderModule( i_device, stage.getBytes() );
+    
+    VkPushConstantRange pushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = i_pushConstantSize,
+    };
+    
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast< uint32_t >( layouts.size() ),
+        .pSetLayouts = layouts.data(),
+        .pushConstantRangeCount = i_pushConstantSize > 0 ? 1u : 0u,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    
+    VkPipelineLayout pipelineLayout;
+    if ( vkCreatePipelineLayout( i_device->getObject(), &pipelineLayoutInfo, nullptr, &pipelineLayout ) != VK_SUCCESS )
+    {
+        throw std::runtime_error( "Error: Failed to create compute pipeline layout." );
+    }
+    
+    VkComputePipelineCreateInfo pipelineInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = stage.getStage(),
+            .module = shaderModule,
+            .pName = stage.getEntryPoint().c_str(),
+        },
+        .layout = pipelineLayout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+    
+    VkPipeline pipeline;
+    if ( vkCreateComputePipelines( i_device->getObject(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline ) != VK_SUCCESS )
+    {
+        throw std::runtime_error( "Error: Failed to create compute pipeline." );
+    }
+    
+    vkDestroyShaderModule( i_device->getObject(), shaderModule, nullptr );
+    
+    return std::make_shared< ComputePipeline >( pipeline, pipelineLayout, i_device );
+}
+
+ComputePipeline::ComputePipeline( VkPipeline i_pipeline, VkPipelineLayout i_layout, DevicePtr i_device )
+: Pipeline( i_pipeline, i_layout, i_device )
+{
+}
+
+void ComputePipeline::destroy()
+{
+    vkDestroyPipeline( m_device->getObject(), m_object, nullptr );
+    vkDestroyPipelineLayout( m_device->getObject(), m_layout, nullptr );
+    
+    m_object = VK_NULL_HANDLE;
+    m_layout = VK_NULL_HANDLE;
+}
+
 } // namespace marlin
@@ -11,6 +11,7 @@
 
 #include <marlin/vulkan/../defs.hpp>
 #include <marlin/vulkan/defs.hpp>
+#include <marlin/vulkan/vertexLayout.hpp>
 #include <marlin/vulkan/vkObject.hpp>
 
 #include <array>
@@ -18,46 +19,12 @@
 namespace marlin
 {
 
+// World matrices live in a storage buffer indexed by instance
 struct UniformBufferObject {
-    Mat4f model;
     Mat4f view;
     Mat4f projection;
 };
 
-struct Vertex
-{
-    Vec3 pos;
-    Vec3 color;
-    
-    static VkVertexInputBindingDescription getBindingDescription()
-    {
-        VkVertexInputBindingDescription bindingDescription {
-            .binding = 0,
-            .stride = sizeof( Vertex ),
-            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-        };
-
-        return bindingDescription;
-    }
-    
-    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
-        
-        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions {};
-        
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Vertex, pos);
-        
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, color);
-
-        return attributeDescriptions;
-    }
-};
-
 class Pipeline : public VkObjectT< VkPipeline >
 {
 public:
@@ -78,7 +45,8 @@ class GraphicsPipeline : public Pipeline
 {
 public:
     
-    static GraphicsPipelinePtr create( DevicePtr i_device, VkRenderPass i_renderPass, const VkExtent2D &i_extent, DescriptorCachePtr &io_descriptorCache );
+    // One pipeline per vertex layout, the vertex shader is specialized for the encoding
+    static GraphicsPipelinePtr create( DevicePtr i_device, VkRenderPass i_renderPass, const VkExtent2D &i_extent, DescriptorCachePtr &io_descriptorCache, VertexEncoding i_vertexEncoding, const VertexLayout &i_vertexLayout );
     
     GraphicsPipeline() = default;
     GraphicsPipeline( VkPipeline i_pipeline, VkPipelineLayout i_layout, DevicePtr i_device );
@@ -90,6 +58,20 @@ private:
     
 };
 
+class ComputePipeline : public Pipeline
+{
+public:
+    
+    // Layouts come from the shader, push constants are visible to the compute stage only
+    static ComputePipelinePtr create( DevicePtr i_device, const std::string &i_path, DescriptorCachePtr &io_descriptorCache, uint32_t i_pushConstantSize );
+    
+    ComputePipeline() = default;
+    ComputePipeline( VkPipeline i_pipeline, VkPipelineLayout i_layout, DevicePtr i_device );
+    ~ComputePipeline() override = default;
+    
+    void destroy();
+};
+
 } // namespace marlin
 
 #endif /* MARLIN_PIPELINE_HPP */
@@ -0,0 +1,113 @@
+//
+//  secondaryCommandPools.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/vulkan/secondaryCommandPools.hpp>
+
+#include <marlin/vulkan/device.hpp>
+
+namespace marlin
+{
+
+SecondaryCommandPoolsPtr SecondaryCommandPools::create( DevicePtr i_device, uint32_t i_queueFamilyIndex, uint32_t i_threadCount, uint32_t i_frameCount )
+{
+    return std::make_shared< SecondaryCommandPools >( i_device, i_queueFamilyIndex, i_threadCount, i_frameCount );
+}
+
+SecondaryCommandPools::SecondaryCommandPools( DevicePtr i_device, uint32_t i_queueFamilyIndex, uint32_t i_threadCount, uint32_t i_frameCount )
+: m_device( i_device )
+, m_threadCount( i_threadCount )
+, m_pools( i_threadCount * i_frameCount )
+{
+    // Buffers are recycled by resetting the whole pool when a frame is re-recorded
+    VkCommandPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = i_queueFamilyIndex,
+    };
+    
+    for ( ThreadPool &threadPool : m_pools )
+    {
+        if ( vkCreateCommandPool( i_device->getObject(), &poolInfo, nullptr, &threadPool.pool ) != VK_SUCCESS )
+        {
+            throw std::runtime_error( "Error: Failed to create secondary command pool." );
+        }
+    }
+}
+
+SecondaryCommandPools::~SecondaryCommandPools()
+{
+    if ( !m_pools.empty() )
+    {
+        std::cerr << "Warning: Secondary command pools not released." << std::endl;
+    }
+}
+
+void SecondaryCommandPools::reset( uint32_t i_frame )
+{
+    for ( uint32_t i = 0; i < m_threadCount; i++ )
+    {
+        ThreadPool &threadPool = getPool( i_frame, i );
+        if ( threadPool.used > 0 )
+        {
+            vkResetCommandPool( m_device->getObject(), threadPool.pool, 0 );
+            threadPool.used = 0;
+        }
+    }
+}
+
+VkCommandBuffer SecondaryCommandPools::begin( uint32_t i_frame, uint32_t i_threadIndex, const VkCommandBufferInheritanceInfo &i_inheritance )
+{
+    ThreadPool &threadPool = getPool( i_frame, i_threadIndex );
+    
+    if ( threadPool.used == threadPool.buffers.size() )
+    {
+        VkCommandBufferAllocateInfo allocInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = threadPool.pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1,
+        };
+        
+        VkCommandBuffer commandBuffer;
+        if ( vkAllocateCommandBuffers( m_device->getObject(), &allocInfo, &commandBuffer ) != VK_SUCCESS )
+        {
+            throw std::runtime_error( "Error: Failed to allocate secondary command buffer." );
+        }
+        
+        threadPool.buffers.push_back( commandBuffer );
+    }
+    
+    VkCommandBuffer commandBuffer = threadPool.buffers[ threadPool.used++ ];
+    
+    VkCommandBufferBeginInfo beginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        // Not one time submit, unchanged frames resubmit their recording
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &i_inheritance,
+    };
+    
+    vkBeginCommandBuffer( commandBuffer, &beginInfo );
+    return commandBuffer;
+}
+
+void SecondaryCommandPools::destroy()
+{
+    for ( ThreadPool &threadPool : m_pools )
+    {
+        vkDestroyCommandPool( m_device->getObject(), threadPool.pool, nullptr );
+    }
+    
+    m_pools.clear();
+}
+
+SecondaryCommandPools::ThreadPool & SecondaryCommandPools::getPool( uint32_t i_frame, uint32_t i_threadIndex )
+{
+    return m_pools[ i_frame * m_threadCount + i_threadIndex ];
+}
+
+} // namespace marlin
@@ -0,0 +1,62 @@
+//
+//  secondaryCommandPools.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_SECONDARYCOMMANDPOOLS_HPP
+#define MARLIN_SECONDARYCOMMANDPOOLS_HPP
+
+#include <marlin/stats.hpp>
+#include <marlin/vulkan/defs.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace marlin
+{
+
+// One command pool per recording thread per frame in flight. Command pools
+// are externally synchronized, so each thread only ever touches its own and
+// threads record secondary command buffers without taking a lock.
+class SecondaryCommandPools
+{
+public:
+    
+    static SecondaryCommandPoolsPtr create( DevicePtr i_device, uint32_t i_queueFamilyIndex, uint32_t i_threadCount, uint32_t i_frameCount );
+    
+    SecondaryCommandPools( DevicePtr i_device, uint32_t i_queueFamilyIndex, uint32_t i_threadCount, uint32_t i_frameCount );
+    ~SecondaryCommandPools();
+    
+    // The frame's fence has signalled and it is being re-recorded
+    void reset( uint32_t i_frame );
+    
+    // Next free secondary buffer of the thread, begun inside the render pass
+    VkCommandBuffer begin( uint32_t i_frame, uint32_t i_threadIndex, const VkCommandBufferInheritanceInfo &i_inheritance );
+    
+    void destroy();
+    
+private:
+    
+    struct ThreadPool
+    {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector< VkCommandBuffer > buffers;
+        size_t used = 0;
+    };
+    
+    ThreadPool & getPool( uint32_t i_frame, uint32_t i_threadIndex );
+    
+    DevicePtr m_device;
+    uint32_t m_threadCount;
+    
+    // Indexed by frame * thread count + thread
+    std::vector< ThreadPool > m_pools;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_SECONDARYCOMMANDPOOLS_HPP */
@@ -0,0 +1,153 @@
+//
+//  stagingRing.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/vulkan/stagingRing.hpp>
+
+#include <marlin/vulkan/buffer.hpp>
+#include <marlin/vulkan/device.hpp>
+
+namespace marlin
+{
+
+static const VkDeviceSize s_stagingAlignment = 16;
+
+static VkDeviceSize s_alignUp( VkDeviceSize i_value, VkDeviceSize i_alignment )
+{
+    return ( i_value + i_alignment - 1 ) & ~( i_alignment - 1 );
+}
+
+StagingRingPtr StagingRing::create( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, VkDeviceSize i_size )
+{
+    return std::make_shared< StagingRing >( i_device, i_physicalDevice, i_size );
+}
+
+StagingRing::StagingRing( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, VkDeviceSize i_size )
+: m_size( i_size )
+{
+    m_buffer = BufferT< std::byte >::create( i_device, i_physicalDevice, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, BufferMode::Local, nullptr, static_cast< size_t >( i_size ) );
+    m_data = static_cast< std::byte* >( m_buffer->mapMemory() );
+}
+
+StagingRing::~StagingRing()
+{
+    if ( m_buffer )
+    {
+        std::cerr << "Warning: Staging ring not released." << std::endl;
+    }
+}
+
+bool StagingRing::allocate( VkDeviceSize i_size, VkDeviceSize &o_offset )
+{
+    if ( i_size > m_size )
+    {
+        return false;
+    }
+    
+    if ( m_used == 0 )
+    {
+        m_head = 0;
+        m_tail = 0;
+    }
+    
+    VkDeviceSize start = s_alignUp( m_head, s_stagingAlignment );
+    VkDeviceSize consumed = 0;
+    
+    const bool wrapped = ( m_head < m_tail ) || ( m_head == m_tail && m_used > 0 );
+    if ( !wrapped && start + i_size <= m_size )
+    {
+        consumed = start + i_size - m_head;
+    }
+    else if ( !wrapped && i_size <= m_tail )
+    {
+        // Skip the end of the ring, the skipped bytes belong to this segment
+        consumed = ( m_size - m_head ) + i_size;
+        start = 0;
+    }
+    else if ( wrapped && start + i_size <= m_tail )
+    {
+        consumed = start + i_size - m_head;
+    }
+    else
+    {
+        return false;
+    }
+    
+    m_head = start + i_size;
+    m_used += consumed;
+    m_openSize += consumed;
+    
+    o_offset = start;
+    return true;
+}
+
+void StagingRing::close( uint64_t i_timelineValue, std::vector< std::function< void () > > &&i_releases )
+{
+    if ( m_openSize == 0 && i_releases.empty() )
+    {
+        return;
+    }
+    
+    Segment segment {
+        .timelineValue = i_timelineValue,
+        .head = m_head,
+        .size = m_openSize,
+        .releases = std::move( i_releases ),
+    };
+    m_segments.push_back( std::move( segment ) );
+    
+    m_openSize = 0;
+}
+
+void StagingRing::reclaim( uint64_t i_completedValue )
+{
+    while ( !m_segments.empty() && m_segments.front().timelineValue <= i_completedValue )
+    {
+        Segment &segment = m_segments.front();
+        
+        m_tail = segment.head;
+        m_used -= segment.size;
+        
+        for ( std::function< void () > &release : segment.releases )
+        {
+            release();
+        }
+        
+        m_segments.pop_front();
+    }
+}
+
+std::byte* StagingRing::getData() const
+{
+    return m_data;
+}
+
+VkBuffer StagingRing::getBuffer() const
+{
+    return m_buffer->getObject();
+}
+
+VkDeviceSize StagingRing::getUsedSize() const
+{
+    return m_used;
+}
+
+void StagingRing::destroy()
+{
+    // Device is idle, everything can go
+    reclaim( UINT64_MAX );
+    
+    if ( m_buffer )
+    {
+        m_buffer->destroy();
+        m_buffer = nullptr;
+    }
+    
+    m_data = nullptr;
+}
+
+} // namespace marlin
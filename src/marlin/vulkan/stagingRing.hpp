@@ -0,0 +1,76 @@
+//
+//  stagingRing.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_STAGINGRING_HPP
+#define MARLIN_STAGINGRING_HPP
+
+#include <marlin/vulkan/defs.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <functional>
+
+namespace marlin
+{
+
+// Persistently mapped host buffer that device uploads are sub-allocated from
+// linearly. Allocations are grouped into segments tagged with the transfer
+// timeline value that consumes them, and reclaimed once it has been reached.
+class StagingRing
+{
+public:
+    
+    static StagingRingPtr create( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, VkDeviceSize i_size );
+    
+    StagingRing( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, VkDeviceSize i_size );
+    ~StagingRing();
+    
+    // Returns false when the ring has no room, nothing is allocated then
+    bool allocate( VkDeviceSize i_size, VkDeviceSize &o_offset );
+    
+    // Seal everything allocated since the last close, releases run with the segment
+    void close( uint64_t i_timelineValue, std::vector< std::function< void () > > &&i_releases );
+    
+    // Reclaim every segment the transfer timeline has passed
+    void reclaim( uint64_t i_completedValue );
+    
+    std::byte* getData() const;
+    VkBuffer getBuffer() const;
+    VkDeviceSize getUsedSize() const;
+    
+    void destroy();
+    
+private:
+    
+    struct Segment
+    {
+        uint64_t timelineValue;
+        VkDeviceSize head;
+        VkDeviceSize size;
+        std::vector< std::function< void () > > releases;
+    };
+    
+    BufferTPtr< std::byte > m_buffer;
+    std::byte* m_data = nullptr;
+    VkDeviceSize m_size = 0;
+    
+    // Ring state, bytes in [ m_tail, m_head ) are owned by pending transfers
+    VkDeviceSize m_head = 0;
+    VkDeviceSize m_tail = 0;
+    VkDeviceSize m_used = 0;
+    
+    // Bytes allocated since the last close
+    VkDeviceSize m_openSize = 0;
+    
+    std::deque< Segment > m_segments;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_STAGINGRING_HPP */
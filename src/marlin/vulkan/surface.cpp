@@ -8,7 +8,9 @@
 
 #include <marlin/vulkan/surface.hpp>
 
+#if defined( __APPLE__ )
 #include <vulkan/vulkan_metal.h>
+#endif
 
 #include <stdexcept>
 
@@ -17,6 +19,7 @@ namespace marlin
 
 SurfacePtr Surface::create( VkInstance i_instance, void* i_layer )
 {
+#if defined( __APPLE__ )
     VkMetalSurfaceCreateInfoEXT createSurfaceInfo {
         .sType = VK_STRUCTURE_TYPE_METAL_SURFACE_CREATE_INFO_EXT,
         .pNext = nullptr,
@@ -31,6 +34,11 @@ SurfacePtr Surface::create( VkInstance i_instance, void* i_layer )
     }
     
     return std::make_shared< Surface >( vkSurface, i_instance );
+#else
+    (void)i_instance;
+    (void)i_layer;
+    throw std::runtime_error( "Error: Surfaces are only supported with Metal layers, use offscreen rendering instead." );
+#endif
 }
 
 Surface::Surface( VkSurfaceKHR i_surface, VkInstance i_instance )
@@ -0,0 +1,89 @@
+//
+//  taskQueue.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/vulkan/taskQueue.hpp>
+
+#include <iostream>
+
+namespace marlin
+{
+
+TaskQueuePtr TaskQueue::create( uint32_t i_workerCount )
+{
+    return std::make_shared< TaskQueue >( i_workerCount );
+}
+
+TaskQueue::TaskQueue( uint32_t i_workerCount )
+{
+    for ( uint32_t i = 0; i < i_workerCount; i++ )
+    {
+        m_workers.emplace_back( &TaskQueue::workerLoop, this );
+    }
+}
+
+TaskQueue::~TaskQueue()
+{
+    if ( !m_workers.empty() )
+    {
+        std::cerr << "Warning: Task queue not released." << std::endl;
+        destroy();
+    }
+}
+
+void TaskQueue::submit( std::function< void () > i_task )
+{
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_tasks.push_back( std::move( i_task ) );
+    }
+    
+    m_wake.notify_one();
+}
+
+void TaskQueue::destroy()
+{
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_stopping = true;
+        m_tasks.clear();
+    }
+    
+    m_wake.notify_all();
+    
+    for ( std::thread &worker : m_workers )
+    {
+        worker.join();
+    }
+    
+    m_workers.clear();
+}
+
+void TaskQueue::workerLoop()
+{
+    while ( true )
+    {
+        std::function< void () > task;
+        
+        {
+            std::unique_lock< std::mutex > lock( m_mutex );
+            m_wake.wait( lock, [ this ] { return m_stopping || !m_tasks.empty(); } );
+            
+            if ( m_stopping )
+            {
+                return;
+            }
+            
+            task = std::move( m_tasks.front() );
+            m_tasks.pop_front();
+        }
+        
+        task();
+    }
+}
+
+} // namespace marlin
@@ -0,0 +1,54 @@
+//
+//  taskQueue.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_TASKQUEUE_HPP
+#define MARLIN_TASKQUEUE_HPP
+
+#include <marlin/vulkan/defs.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace marlin
+{
+
+// Worker threads for work that may take longer than a frame. Unlike the job
+// system nobody waits for it, tasks hand their results back themselves.
+class TaskQueue
+{
+public:
+    
+    static TaskQueuePtr create( uint32_t i_workerCount );
+    
+    explicit TaskQueue( uint32_t i_workerCount );
+    ~TaskQueue();
+    
+    // Started in submission order by whichever worker is free
+    void submit( std::function< void () > i_task );
+    
+    // Tasks that have not started are dropped, running ones finish first
+    void destroy();
+    
+private:
+    
+    void workerLoop();
+    
+    std::vector< std::thread > m_workers;
+    
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque< std::function< void () > > m_tasks;
+    bool m_stopping = false;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_TASKQUEUE_HPP */
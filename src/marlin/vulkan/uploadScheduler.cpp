@@ -0,0 +1,409 @@
+//
+//  uploadScheduler.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/vulkan/uploadScheduler.hpp>
+
+#include <marlin/vulkan/buffer.hpp>
+#include <marlin/vulkan/commandBuffer.hpp>
+#include <marlin/vulkan/device.hpp>
+#include <marlin/vulkan/stagingRing.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+namespace marlin
+{
+
+// Every stage that can read uploaded geometry, indirect draws and uniforms,
+// including device side copies made by pool defragmentation and culling
+static const VkPipelineStageFlags s_consumerStages = VK_PIPELINE_STAGE_TRANSFER_BIT |
+                                                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                                                     VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                                     VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+static const VkAccessFlags s_consumerAccess = VK_ACCESS_TRANSFER_READ_BIT |
+                                              VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+                                              VK_ACCESS_INDEX_READ_BIT |
+                                              VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                                              VK_ACCESS_UNIFORM_READ_BIT |
+                                              VK_ACCESS_SHADER_READ_BIT;
+
+// Disjoint byte ranges of a buffer, begin to end
+using RangeSet = std::map< VkDeviceSize, VkDeviceSize >;
+
+// Add [begin, end) to the set, merging it with ranges it overlaps or touches.
+// Returns true when some of it was already in the set.
+static bool s_addRange( RangeSet &io_ranges, VkDeviceSize i_begin, VkDeviceSize i_end )
+{
+    bool overlaps = false;
+    
+    auto itr = io_ranges.upper_bound( i_begin );
+    if ( itr != io_ranges.begin() )
+    {
+        auto previous = std::prev( itr );
+        if ( previous->second >= i_begin )
+        {
+            overlaps = previous->second > i_begin;
+            i_begin = previous->first;
+            i_end = std::max( i_end, previous->second );
+            itr = io_ranges.erase( previous );
+        }
+    }
+    
+    while ( itr != io_ranges.end() && itr->first <= i_end )
+    {
+        overlaps = overlaps || itr->first < i_end;
+        i_end = std::max( i_end, itr->second );
+        itr = io_ranges.erase( itr );
+    }
+    
+    io_ranges.emplace_hint( itr, i_begin, i_end );
+    return overlaps;
+}
+
+UploadSchedulerPtr UploadScheduler::create( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, VkDeviceSize i_ringSize )
+{
+    return std::make_shared< UploadScheduler >( i_device, i_physicalDevice, i_ringSize );
+}
+
+UploadScheduler::UploadScheduler( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, VkDeviceSize i_ringSize )
+: m_device( i_device )
+, m_physicalDevice( i_physicalDevice )
+{
+    m_ring = StagingRing::create( i_device, i_physicalDevice, i_ringSize );
+    
+    m_transferQueue = i_device->getQueue( QueueTypeTransfer, 0 );
+    m_transferFamily = i_device->getQueueFamilyIndex( QueueTypeTransfer );
+    m_graphicsFamily = i_device->getQueueFamilyIndex( QueueTypeGraphics );
+    
+    VkSemaphoreTypeCreateInfo typeInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    
+    VkSemaphoreCreateInfo semaphoreInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &typeInfo,
+    };
+    
+    if ( vkCreateSemaphore( i_device->getObject(), &semaphoreInfo, nullptr, &m_timeline ) != VK_SUCCESS )
+    {
+        throw std::runtime_error( "Error: Failed to create upload timeline semaphore." );
+    }
+}
+
+UploadScheduler::~UploadScheduler()
+{
+    if ( m_timeline != VK_NULL_HANDLE )
+    {
+        std::cerr << "Warning: Upload scheduler not released." << std::endl;
+    }
+}
+
+void UploadScheduler::stage( const void* i_data, VkDeviceSize i_size, VkBuffer i_dstBuffer, VkDeviceSize i_dstOffset )
+{
+    if ( i_size == 0 )
+    {
+        return;
+    }
+    
+    memcpy( stage( i_size, i_dstBuffer, i_dstOffset ), i_data, static_cast< size_t >( i_size ) );
+}
+
+void* UploadScheduler::stage( VkDeviceSize i_size, VkBuffer i_dstBuffer, VkDeviceSize i_dstOffset )
+{
+    if ( i_size == 0 )
+    {
+        return nullptr;
+    }
+    
+    VkDeviceSize offset;
+    bool staged = m_ring->allocate( i_size, offset );
+    
+    if ( !staged )
+    {
+        // Earlier transfers may have finished since we last looked
+        uint64_t completedValue = 0;
+        vkGetSemaphoreCounterValue( m_device->getObject(), m_timeline, &completedValue );
+        m_ring->reclaim( completedValue );
+        
+        staged = m_ring->allocate( i_size, offset );
+    }
+    
+    if ( staged )
+    {
+        PendingCopy copy {
+            .srcBuffer = m_ring->getBuffer(),
+            .dstBuffer = i_dstBuffer,
+            .region = { offset, i_dstOffset, i_size },
+        };
+        m_pendingCopies.push_back( copy );
+        return m_ring->getData() + offset;
+    }
+    
+    // Ring is full or the upload is larger than the ring, stage through a
+    // buffer that lives until the transfer has completed
+    BufferTPtr< std::byte > overflow = BufferT< std::byte >::create( m_device, m_physicalDevice, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, BufferMode::Local, nullptr, static_cast< size_t >( i_size ) );
+    
+    PendingCopy copy {
+        .srcBuffer = overflow->getObject(),
+        .dstBuffer = i_dstBuffer,
+        .region = { 0, i_dstOffset, i_size },
+    };
+    m_pendingCopies.push_back( copy );
+    
+    m_overflowReleases.push_back( [ overflow ]() {
+        overflow->destroy();
+    });
+    
+    return overflow->mapMemory();
+}
+
+void UploadScheduler::defer( std::function< void () > i_release )
+{
+    m_openDeferred.push_back( std::move( i_release ) );
+}
+
+void UploadScheduler::submit( uint32_t i_frame )
+{
+    std::vector< std::function< void () > > &frameDeferred = m_frameDeferred[ i_frame ];
+    std::move( m_openDeferred.begin(), m_openDeferred.end(), std::back_inserter( frameDeferred ) );
+    m_openDeferred.clear();
+    
+    m_acquireBarriers.clear();
+    
+    if ( m_pendingCopies.empty() )
+    {
+        return;
+    }
+    
+    // The graphics frame that last used this slot waited on its transfer, so
+    // the command buffer is free again
+    CommandBufferPtr commandBuffer = m_device->getCommandBuffer( QueueTypeTransfer, i_frame );
+    commandBuffer->reset();
+    
+    {
+        CommandBufferRecordPtr scopedRecord = commandBuffer->scopedRecord( VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT );
+        VkCommandBuffer vkCommandBuffer = commandBuffer->getObject();
+        
+        // Copies keep the order they were staged in, a later upload to the
+        // same bytes has to land last. Consecutive copies between the same
+        // buffers share a command.
+        std::vector< VkBufferCopy > regions;
+        
+        // What each destination had written, gaps between copies stay with
+        // whichever family owns them
+        std::map< VkBuffer, RangeSet > writtenRanges;
+        
+        // Writes since the last transfer barrier. Regions of one copy command
+        // must not overlap and separate commands are unordered, so a copy onto
+        // any of these waits for the earlier ones.
+        std::map< VkBuffer, RangeSet > unorderedRanges;
+        
+        for ( size_t i = 0; i < m_pendingCopies.size(); i++ )
+        {
+            const PendingCopy &copy = m_pendingCopies[ i ];
+            const VkDeviceSize copyEnd = copy.region.dstOffset + copy.region.size;
+            
+            if ( s_addRange( unorderedRanges[ copy.dstBuffer ], copy.region.dstOffset, copyEnd ) )
+            {
+                // Anything still grouped shares this copy's buffers
+                if ( !regions.empty() )
+                {
+                    vkCmdCopyBuffer( vkCommandBuffer, copy.srcBuffer, copy.dstBuffer, static_cast< uint32_t >( regions.size() ), regions.data() );
+                    regions.clear();
+                }
+                
+                VkMemoryBarrier writeAfterWrite {
+                    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                    .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                };
+                
+                vkCmdPipelineBarrier( vkCommandBuffer,
+                                      VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      0, 1, &writeAfterWrite, 0, nullptr, 0, nullptr );
+                
+                unorderedRanges.clear();
+                s_addRange( unorderedRanges[ copy.dstBuffer ], copy.region.dstOffset, copyEnd );
+            }
+            
+            regions.push_back( copy.region );
+            s_addRange( writtenRanges[ copy.dstBuffer ], copy.region.dstOffset, copyEnd );
+            
+            const bool lastInGroup = ( i + 1 == m_pendingCopies.size() ) ||
+                                     ( m_pendingCopies[ i + 1 ].dstBuffer != copy.dstBuffer ) ||
+                                     ( m_pendingCopies[ i + 1 ].srcBuffer != copy.srcBuffer );
+            
+            if ( lastInGroup )
+            {
+                vkCmdCopyBuffer( vkCommandBuffer, copy.srcBuffer, copy.dstBuffer, static_cast< uint32_t >( regions.size() ), regions.data() );
+                regions.clear();
+            }
+        }
+        
+        // Hand each run of adjacent written bytes over to the graphics family
+        std::vector< VkBufferMemoryBarrier > releaseBarriers;
+        if ( m_transferFamily != m_graphicsFamily )
+        {
+            for ( const auto &pair : writtenRanges )
+            {
+                for ( const auto &range : pair.second )
+                {
+                    VkBufferMemoryBarrier release {
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                        .dstAccessMask = 0,
+                        .srcQueueFamilyIndex = m_transferFamily,
+                        .dstQueueFamilyIndex = m_graphicsFamily,
+                        .buffer = pair.first,
+                        .offset = range.first,
+                        .size = range.second - range.first,
+                    };
+                    releaseBarriers.push_back( release );
+                    
+                    VkBufferMemoryBarrier acquire = release;
+                    acquire.srcAccessMask = 0;
+                    acquire.dstAccessMask = s_consumerAccess;
+                    m_acquireBarriers.push_back( acquire );
+                }
+            }
+        }
+        
+        if ( !releaseBarriers.empty() )
+        {
+            vkCmdPipelineBarrier( vkCommandBuffer,
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                  VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                  0, 0, nullptr, static_cast< uint32_t >( releaseBarriers.size() ), releaseBarriers.data(), 0, nullptr );
+        }
+    }
+    
+    m_submittedValue++;
+    
+    VkTimelineSemaphoreSubmitInfo timelineInfo {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &m_submittedValue,
+    };
+    
+    VkCommandBuffer vkCommandBuffer = commandBuffer->getObject();
+    VkSubmitInfo submitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = &timelineInfo,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &vkCommandBuffer,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &m_timeline,
+    };
+    
+    if ( vkQueueSubmit( m_transferQueue, 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+    {
+        throw std::runtime_error( "Error: Failed to submit upload command buffer." );
+    }
+    
+    m_ring->close( m_submittedValue, std::move( m_overflowReleases ) );
+    m_overflowReleases.clear();
+    m_pendingCopies.clear();
+}
+
+void UploadScheduler::recordAcquire( VkCommandBuffer i_commandBuffer ) const
+{
+    if ( m_acquireBarriers.empty() )
+    {
+        return;
+    }
+    
+    // Source stages match the semaphore wait so the acquire is ordered after it
+    vkCmdPipelineBarrier( i_commandBuffer,
+                          s_consumerStages,
+                          s_consumerStages,
+                          0, 0, nullptr, static_cast< uint32_t >( m_acquireBarriers.size() ), m_acquireBarriers.data(), 0, nullptr );
+}
+
+bool UploadScheduler::hasAcquireBarriers() const
+{
+    return !m_acquireBarriers.empty();
+}
+
+void UploadScheduler::retire( uint32_t i_frame )
+{
+    const auto itr = m_frameDeferred.find( i_frame );
+    if ( itr != m_frameDeferred.end() )
+    {
+        for ( std::function< void () > &release : itr->second )
+        {
+            release();
+        }
+        itr->second.clear();
+    }
+    
+    uint64_t completedValue = 0;
+    vkGetSemaphoreCounterValue( m_device->getObject(), m_timeline, &completedValue );
+    m_ring->reclaim( completedValue );
+}
+
+void UploadScheduler::retireAll()
+{
+    for ( auto &pair : m_frameDeferred )
+    {
+        for ( std::function< void () > &release : pair.second )
+        {
+            release();
+        }
+    }
+    
+    for ( std::function< void () > &release : m_openDeferred )
+    {
+        release();
+    }
+    
+    m_frameDeferred.clear();
+    m_openDeferred.clear();
+    
+    m_ring->reclaim( UINT64_MAX );
+}
+
+VkSemaphore UploadScheduler::getSemaphore() const
+{
+    return m_timeline;
+}
+
+uint64_t UploadScheduler::getSubmittedValue() const
+{
+    return m_submittedValue;
+}
+
+VkPipelineStageFlags UploadScheduler::getWaitStages() const
+{
+    return s_consumerStages;
+}
+
+void UploadScheduler::destroy()
+{
+    retireAll();
+    
+    for ( std::function< void () > &release : m_overflowReleases )
+    {
+        release();
+    }
+    m_overflowReleases.clear();
+    m_pendingCopies.clear();
+    
+    m_ring->destroy();
+    
+    vkDestroySemaphore( m_device->getObject(), m_timeline, nullptr );
+    m_timeline = VK_NULL_HANDLE;
+}
+
+} // namespace marlin
@@ -0,0 +1,94 @@
+//
+//  uploadScheduler.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_UPLOADSCHEDULER_HPP
+#define MARLIN_UPLOADSCHEDULER_HPP
+
+#include <marlin/vulkan/defs.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <map>
+
+namespace marlin
+{
+
+// Batches device uploads and submits them on the transfer queue. Each submit
+// signals a timeline semaphore that the graphics submission waits on, so
+// geometry streaming overlaps with rendering instead of blocking the host.
+class UploadScheduler
+{
+public:
+    
+    static UploadSchedulerPtr create( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, VkDeviceSize i_ringSize );
+    
+    UploadScheduler( DevicePtr i_device, PhysicalDevicePtr i_physicalDevice, VkDeviceSize i_ringSize );
+    ~UploadScheduler();
+    
+    // Copy data into the staging ring and queue a copy into the destination.
+    // Uploads that do not fit fall back to a temporary buffer, nothing blocks.
+    void stage( const void* i_data, VkDeviceSize i_size, VkBuffer i_dstBuffer, VkDeviceSize i_dstOffset );
+    
+    // Reserve staging memory for the copy and return it, so data can be
+    // written there directly. It must be filled before the next submit.
+    void* stage( VkDeviceSize i_size, VkBuffer i_dstBuffer, VkDeviceSize i_dstOffset );
+    
+    // Run once the graphics frame that is being built has retired
+    void defer( std::function< void () > i_release );
+    
+    // Submit everything staged so far on the transfer queue
+    void submit( uint32_t i_frame );
+    
+    // Queue family acquire for the last submit, recorded by the graphics queue
+    void recordAcquire( VkCommandBuffer i_commandBuffer ) const;
+    bool hasAcquireBarriers() const;
+    
+    // The graphics frame's fence has signalled
+    void retire( uint32_t i_frame );
+    
+    // Device is idle, release everything that was deferred
+    void retireAll();
+    
+    VkSemaphore getSemaphore() const;
+    uint64_t getSubmittedValue() const;
+    VkPipelineStageFlags getWaitStages() const;
+    
+    void destroy();
+    
+private:
+    
+    struct PendingCopy
+    {
+        VkBuffer srcBuffer;
+        VkBuffer dstBuffer;
+        VkBufferCopy region;
+    };
+    
+    DevicePtr m_device;
+    PhysicalDevicePtr m_physicalDevice;
+    StagingRingPtr m_ring;
+    
+    VkQueue m_transferQueue = VK_NULL_HANDLE;
+    uint32_t m_transferFamily = 0;
+    uint32_t m_graphicsFamily = 0;
+    
+    VkSemaphore m_timeline = VK_NULL_HANDLE;
+    uint64_t m_submittedValue = 0;
+    
+    std::vector< PendingCopy > m_pendingCopies;
+    std::vector< std::function< void () > > m_overflowReleases;
+    std::vector< VkBufferMemoryBarrier > m_acquireBarriers;
+    
+    std::vector< std::function< void () > > m_openDeferred;
+    std::map< uint32_t, std::vector< std::function< void () > > > m_frameDeferred;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_UPLOADSCHEDULER_HPP */
@@ -0,0 +1,185 @@
+//
+//  vertexLayout.cpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#include <marlin/vulkan/vertexLayout.hpp>
+
+#include <stdexcept>
+
+namespace marlin
+{
+
+static_assert( sizeof( PackedVertex ) == 20, "Packed vertices must stay tightly packed" );
+
+uint32_t getAttributeSize( VertexAttribute i_attribute, VertexEncoding i_encoding )
+{
+    const bool quantized = i_encoding == VertexEncoding::Quantized;
+    switch ( i_attribute )
+    {
+        case VertexAttributePosition:
+            return quantized ? sizeof( PackedVertex::pos ) : sizeof( Vertex::pos );
+        case VertexAttributeColor:
+            return quantized ? sizeof( PackedVertex::color ) : sizeof( Vertex::color );
+        case VertexAttributeNormal:
+            return quantized ? sizeof( PackedVertex::normal ) : sizeof( Vertex::normal );
+        case VertexAttributeUV:
+            return quantized ? sizeof( PackedVertex::uv ) : sizeof( Vertex::uv );
+        default:
+            throw std::runtime_error( "Error: Unknown vertex attribute." );
+    }
+}
+
+VkFormat getAttributeFormat( VertexAttribute i_attribute, VertexEncoding i_encoding )
+{
+    // Normalized formats read as floats, the shaders do not see the encoding
+    const bool quantized = i_encoding == VertexEncoding::Quantized;
+    switch ( i_attribute )
+    {
+        case VertexAttributePosition:
+            return quantized ? VK_FORMAT_R16G16B16A16_UNORM : VK_FORMAT_R32G32B32_SFLOAT;
+        case VertexAttributeColor:
+            return quantized ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R32G32B32_SFLOAT;
+        case VertexAttributeNormal:
+            return quantized ? VK_FORMAT_R8G8B8A8_SNORM : VK_FORMAT_R32G32B32_SFLOAT;
+        case VertexAttributeUV:
+            return quantized ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R32G32_SFLOAT;
+        default:
+            throw std::runtime_error( "Error: Unknown vertex attribute." );
+    }
+}
+
+bool VertexLayout::has( VertexAttribute i_attribute ) const
+{
+    return ( attributes & ( 1 << i_attribute ) ) != 0;
+}
+
+uint8_t VertexLayout::getKey() const
+{
+    return static_cast< uint8_t >( attributes | ( interleaved ? 0 : 1 << VertexAttributeCount ) );
+}
+
+VertexLayout VertexLayout::fromKey( uint8_t i_key )
+{
+    VertexLayout layout;
+    layout.attributes = i_key & ( ( 1 << VertexAttributeCount ) - 1 );
+    layout.interleaved = ( i_key & ( 1 << VertexAttributeCount ) ) == 0;
+    return layout;
+}
+
+VertexLayout VertexLayout::getComplete()
+{
+    VertexLayout layout;
+    layout.attributes = ( 1 << VertexAttributeCount ) - 1;
+    layout.interleaved = false;
+    return layout;
+}
+
+uint32_t VertexLayout::getVertexSize( VertexEncoding i_encoding ) const
+{
+    uint32_t size = 0;
+    for ( VertexAttribute attribute : getAttributes() )
+    {
+        size += getAttributeSize( attribute, i_encoding );
+    }
+    
+    return size;
+}
+
+std::vector< VertexAttribute > VertexLayout::getAttributes() const
+{
+    std::vector< VertexAttribute > present;
+    for ( uint8_t i = 0; i < VertexAttributeCount; i++ )
+    {
+        if ( has( static_cast< VertexAttribute >( i ) ) )
+        {
+            present.push_back( static_cast< VertexAttribute >( i ) );
+        }
+    }
+    
+    return present;
+}
+
+std::vector< VkDeviceSize > VertexLayout::getStreamOffsets( VertexEncoding i_encoding, uint32_t i_entrySize ) const
+{
+    if ( interleaved )
+    {
+        return { 0 };
+    }
+    
+    std::vector< VkDeviceSize > offsets;
+    VkDeviceSize offset = 0;
+    for ( VertexAttribute attribute : getAttributes() )
+    {
+        offsets.push_back( offset );
+        offset += static_cast< VkDeviceSize >( getAttributeSize( attribute, i_encoding ) ) * i_entrySize;
+    }
+    
+    return offsets;
+}
+
+std::vector< VkVertexInputBindingDescription > VertexLayout::getBindingDescriptions( VertexEncoding i_encoding ) const
+{
+    std::vector< VkVertexInputBindingDescription > bindings;
+    
+    if ( interleaved )
+    {
+        bindings.push_back( { 0, getVertexSize( i_encoding ), VK_VERTEX_INPUT_RATE_VERTEX } );
+    }
+    else
+    {
+        for ( VertexAttribute attribute : getAttributes() )
+        {
+            const uint32_t binding = static_cast< uint32_t >( bindings.size() );
+            bindings.push_back( { binding, getAttributeSize( attribute, i_encoding ), VK_VERTEX_INPUT_RATE_VERTEX } );
+        }
+    }
+    
+    // A zero stride repeats the one default value for every vertex
+    if ( attributes != getComplete().attributes )
+    {
+        bindings.push_back( { s_defaultAttributeBinding, 0, VK_VERTEX_INPUT_RATE_VERTEX } );
+    }
+    
+    return bindings;
+}
+
+std::vector< VkVertexInputAttributeDescription > VertexLayout::getAttributeDescriptions( VertexEncoding i_encoding ) const
+{
+    std::vector< VkVertexInputAttributeDescription > descriptions;
+    
+    uint32_t binding = 0;
+    uint32_t offset = 0;
+    uint32_t defaultOffset = 0;
+    
+    for ( uint8_t i = 0; i < VertexAttributeCount; i++ )
+    {
+        const VertexAttribute attribute = static_cast< VertexAttribute >( i );
+        const uint32_t size = getAttributeSize( attribute, i_encoding );
+        const VkFormat format = getAttributeFormat( attribute, i_encoding );
+        
+        if ( !has( attribute ) )
+        {
+            descriptions.push_back( { i, s_defaultAttributeBinding, format, defaultOffset } );
+        }
+        else if ( interleaved )
+        {
+            descriptions.push_back( { i, 0, format, offset } );
+            offset += size;
+        }
+        else
+        {
+            descriptions.push_back( { i, binding++, format, 0 } );
+        }
+        
+        // The default buffer holds one of every attribute, in order
+        defaultOffset += size;
+    }
+    
+    return descriptions;
+}
+
+} // namespace marlin
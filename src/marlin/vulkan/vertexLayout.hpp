@@ -0,0 +1,102 @@
+//
+//  vertexLayout.hpp
+//  Marlin
+//
+//  Created by Jonathan Graham on 10/17/26.
+//  Copyright © 2026 Jonathan Graham. All rights reserved.
+//
+
+#ifndef MARLIN_VERTEXLAYOUT_HPP
+#define MARLIN_VERTEXLAYOUT_HPP
+
+#include <marlin/vulkan/../defs.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace marlin
+{
+
+// How vertex attributes are stored in the vertex pool, fixed for the whole renderer
+enum class VertexEncoding
+{
+    // 32 bit floats
+    Float,
+    
+    // As in PackedVertex
+    Quantized,
+};
+
+// Interleaved on the host, every layout and encoding is built from it
+struct Vertex
+{
+    Vec3 pos;
+    Vec3 color;
+    Vec3 normal;
+    Vec2 uv;
+};
+
+// Positions are unsigned normalized against the mesh bounds, the transform
+// buffer scales them back. Normals are octahedral with the scale in z, as
+// written by meshopt_encodeFilterOct. Colors are unsigned normalized and
+// UVs half floats.
+struct PackedVertex
+{
+    uint16_t pos[ 4 ];
+    uint8_t color[ 4 ];
+    int8_t normal[ 4 ];
+    uint16_t uv[ 2 ];
+};
+
+// Also the shader input locations
+enum VertexAttribute : uint8_t
+{
+    VertexAttributePosition = 0,
+    VertexAttributeColor    = 1,
+    VertexAttributeNormal   = 2,
+    VertexAttributeUV       = 3,
+    VertexAttributeCount    = 4,
+};
+
+// Attributes a mesh lacks read one constant value through this binding
+static const uint32_t s_defaultAttributeBinding = VertexAttributeCount;
+
+uint32_t getAttributeSize( VertexAttribute i_attribute, VertexEncoding i_encoding );
+VkFormat getAttributeFormat( VertexAttribute i_attribute, VertexEncoding i_encoding );
+
+// Which attributes a mesh stores and how they sit in a vertex pool entry.
+// Interleaved layouts use one binding. Separate layouts give every attribute
+// its own stream and binding, each stream spans the whole entry so all
+// meshes in the entry still share one set of binds and one vertex offset.
+struct VertexLayout
+{
+    // Bit per attribute, positions are always present
+    uint8_t attributes = ( 1 << VertexAttributePosition ) | ( 1 << VertexAttributeColor );
+    bool interleaved = true;
+    
+    bool has( VertexAttribute i_attribute ) const;
+    
+    // Dense, batches and pipelines are keyed by it
+    uint8_t getKey() const;
+    static VertexLayout fromKey( uint8_t i_key );
+    
+    // Every attribute in its own stream, how the default values are stored
+    static VertexLayout getComplete();
+    
+    // Over every stream
+    uint32_t getVertexSize( VertexEncoding i_encoding ) const;
+    
+    // Present attributes in binding order
+    std::vector< VertexAttribute > getAttributes() const;
+    
+    // Where each binding's stream starts in an entry of i_entrySize vertices
+    std::vector< VkDeviceSize > getStreamOffsets( VertexEncoding i_encoding, uint32_t i_entrySize ) const;
+    
+    std::vector< VkVertexInputBindingDescription > getBindingDescriptions( VertexEncoding i_encoding ) const;
+    std::vector< VkVertexInputAttributeDescription > getAttributeDescriptions( VertexEncoding i_encoding ) const;
+};
+
+} // namespace marlin
+
+#endif /* MARLIN_VERTEXLAYOUT_HPP */
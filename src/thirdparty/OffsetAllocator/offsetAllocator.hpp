@@ -1,6 +1,8 @@
 // (C) Sebastian Aaltonen 2023
 // MIT License (see file: LICENSE)
 
+#pragma once
+
 //#define USE_16_BIT_OFFSETS
 
 namespace OffsetAllocator